@@ -0,0 +1,297 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Compares a baked b2DistanceFieldShape with the exact shapes it was baked from on a
+// pinball-like level. It reports the bake cost, the distance and normal error of the
+// field, the cost of a distance query, and a simulation of fast balls against both.
+// Build from the repository root with all of Box2D, for example:
+//   g++ -O2 -std=c++11 -I. Benchmarks/DistanceFieldBenchmark.cpp $(find Box2D -name '*.cpp') -lpthread
+// Usage: DistanceFieldBenchmark [balls] [steps] [cellSize]
+
+#include "Box2D/Box2D.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const float32 s_ballRadius = 0.3f;
+
+static float64 Milliseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<float64, std::milli>(end - start).count();
+}
+
+// An outer loop with flippers, boxes, round bumpers and capsules.
+static void CreateLevel(std::vector<b2Shape*>* level)
+{
+	b2Vec2 loop[8] =
+	{
+		b2Vec2(-10.0f, 0.0f), b2Vec2(-1.0f, -4.0f), b2Vec2(1.0f, -4.0f), b2Vec2(10.0f, 0.0f),
+		b2Vec2(10.0f, 30.0f), b2Vec2(6.0f, 34.0f), b2Vec2(-6.0f, 34.0f), b2Vec2(-10.0f, 30.0f)
+	};
+	b2ChainShape* chain = new b2ChainShape;
+	chain->CreateLoop(loop, 8);
+	level->push_back(chain);
+
+	for (int32 i = 0; i < 12; ++i)
+	{
+		b2PolygonShape* box = new b2PolygonShape;
+		b2Vec2 center(-7.0f + 4.5f * (i % 4) + (i / 4) % 2, 6.0f + 7.0f * (i / 4));
+		box->SetAsBox(0.8f, 0.25f, center, 0.4f * i);
+		level->push_back(box);
+	}
+
+	for (int32 i = 0; i < 8; ++i)
+	{
+		b2CircleShape* bumper = new b2CircleShape;
+		bumper->m_radius = 0.7f;
+		bumper->m_p.Set(-4.5f + 4.0f * (i % 4), 9.5f + 7.0f * (i / 4));
+		level->push_back(bumper);
+	}
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		b2CapsuleShape* capsule = new b2CapsuleShape;
+		capsule->Set(b2Vec2(-8.0f + 4.5f * i, 27.0f), b2Vec2(-6.0f + 4.5f * i, 28.0f - i % 2), 0.2f);
+		level->push_back(capsule);
+	}
+
+	b2EdgeShape* edge = new b2EdgeShape;
+	edge->Set(b2Vec2(-9.0f, 3.0f), b2Vec2(-3.0f, 1.0f));
+	level->push_back(edge);
+}
+
+// The exact distance from a point to the level using GJK against every child.
+static float32 ComputeDistance(const std::vector<b2Shape*>& level, const b2Vec2& p, b2Vec2* normal)
+{
+	b2CircleShape point;
+	point.m_radius = 0.0f;
+	point.m_p = p;
+
+	b2Transform identity;
+	identity.SetIdentity();
+
+	float32 best = b2_maxFloat;
+	for (size_t i = 0; i < level.size(); ++i)
+	{
+		const b2Shape* shape = level[i];
+		for (int32 child = 0; child < shape->GetChildCount(); ++child)
+		{
+			b2DistanceInput input;
+			input.proxyA.Set(shape, child);
+			input.proxyB.Set(&point, 0);
+			input.transformA = identity;
+			input.transformB = identity;
+			input.useRadii = false;
+
+			b2SimplexCache cache;
+			cache.count = 0;
+			b2DistanceOutput output;
+			b2Distance(&output, &cache, &input);
+
+			float32 distance = output.distance - shape->m_radius;
+			if (distance < best)
+			{
+				best = distance;
+				if (normal)
+				{
+					*normal = output.pointB - output.pointA;
+					normal->Normalize();
+				}
+			}
+		}
+	}
+
+	return best;
+}
+
+static void CreateWorld(b2World* world, int32 ballCount, const std::vector<b2Shape*>& level,
+						const b2DistanceFieldShape* field)
+{
+	b2BodyDef groundDef;
+	b2Body* ground = world->CreateBody(&groundDef);
+	if (field)
+	{
+		ground->CreateFixture(field, 0.0f);
+	}
+	else
+	{
+		for (size_t i = 0; i < level.size(); ++i)
+		{
+			ground->CreateFixture(level[i], 0.0f);
+		}
+	}
+
+	b2CircleShape circle;
+	circle.m_radius = s_ballRadius;
+
+	b2FixtureDef fd;
+	fd.shape = &circle;
+	fd.density = 1.0f;
+	fd.restitution = 0.8f;
+
+	for (int32 i = 0; i < ballCount; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.bullet = true;
+		bd.position.Set(-8.0f + 0.8f * (i % 20), 20.0f + 0.8f * (i / 20));
+		bd.linearVelocity.Set(30.0f * sinf(1.7f * i), 30.0f * cosf(2.3f * i));
+		world->CreateBody(&bd)->CreateFixture(&fd);
+	}
+}
+
+static void Simulate(const char* name, int32 ballCount, int32 stepCount,
+					 const std::vector<b2Shape*>& level, const b2DistanceFieldShape* field)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	CreateWorld(&world, ballCount, level, field);
+
+	float64 collide = 0.0, solveTOI = 0.0;
+	Clock::time_point start = Clock::now();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+		collide += world.GetProfile().collide;
+		solveTOI += world.GetProfile().solveTOI;
+	}
+	float64 total = Milliseconds(start, Clock::now());
+
+	// Measure the penetration against the exact level for both runs.
+	float32 penetration = 0.0f;
+	int32 escaped = 0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		if (b->GetType() != b2_dynamicBody)
+		{
+			continue;
+		}
+
+		b2Vec2 p = b->GetPosition();
+		penetration = b2Max(penetration, s_ballRadius - ComputeDistance(level, p, nullptr));
+		if (p.x < -10.0f || 10.0f < p.x || p.y < -4.0f || 34.0f < p.y)
+		{
+			++escaped;
+		}
+	}
+
+	printf("%-6s step %7.3f ms  collide %7.3f ms  solveTOI %7.3f ms  proxies %4d  contacts %4d  worstPenetration %.4f  escaped %d\n",
+		name, total / stepCount, collide / stepCount, solveTOI / stepCount,
+		world.GetProxyCount(), world.GetContactCount(), penetration, escaped);
+}
+
+int main(int argc, char** argv)
+{
+	int32 ballCount = argc > 1 ? atoi(argv[1]) : 200;
+	int32 stepCount = argc > 2 ? atoi(argv[2]) : 600;
+	float32 cellSize = argc > 3 ? float32(atof(argv[3])) : 0.1f;
+	if (ballCount < 0 || stepCount <= 0 || cellSize <= 0.0f)
+	{
+		printf("usage: %s [balls] [steps] [cellSize]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<b2Shape*> level;
+	CreateLevel(&level);
+
+	b2DistanceFieldShape field;
+	Clock::time_point bakeStart = Clock::now();
+	field.Bake(level.data(), int32(level.size()), cellSize, 1.0f);
+	float64 bakeTime = Milliseconds(bakeStart, Clock::now());
+	int32 size = field.Save(nullptr, 0);
+	printf("bake %d x %d cells of %.3f in %.1f ms, %d bytes\n", field.m_width, field.m_height, cellSize, bakeTime, size);
+
+	// The cache written to disk must load back to the same field.
+	std::vector<char> image(size);
+	field.Save(image.data(), size);
+	b2DistanceFieldShape loaded;
+	bool same = loaded.Load(image.data(), size) && loaded.m_width == field.m_width && loaded.m_height == field.m_height &&
+		std::equal(loaded.m_values, loaded.m_values + loaded.m_width * loaded.m_height, field.m_values);
+	printf("cache roundtrip %s\n", same ? "identical" : "different");
+
+	// Query accuracy near the surface, where the ball touches.
+	const int32 queryCount = 20000;
+	std::vector<b2Vec2> points(queryCount);
+	srand(1);
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		points[i].Set(-11.0f + 22.0f * rand() / RAND_MAX, -5.0f + 40.0f * rand() / RAND_MAX);
+	}
+
+	float64 sumError = 0.0, maxError = 0.0;
+	std::vector<float64> angles;
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		b2Vec2 exactNormal, gradient;
+		float32 exact = ComputeDistance(level, points[i], &exactNormal);
+		float32 sampled = field.Sample(points[i], &gradient);
+		if (exact <= 0.05f || 2.0f * s_ballRadius <= exact)
+		{
+			continue;
+		}
+
+		float64 error = fabs(exact - sampled);
+		sumError += error;
+		maxError = b2Max(maxError, error);
+
+		gradient.Normalize();
+		float64 cosine = b2Clamp(float64(b2Dot(exactNormal, gradient)), -1.0, 1.0);
+		angles.push_back(acos(cosine) * 180.0 / b2_pi);
+	}
+
+	if (angles.empty() == false)
+	{
+		std::sort(angles.begin(), angles.end());
+		printf("%d points near the surface: distance error mean %.5f max %.5f, normal error p50 %.2f p99 %.2f max %.2f deg\n",
+			int32(angles.size()), sumError / angles.size(), maxError,
+			angles[angles.size() / 2], angles[angles.size() * 99 / 100], angles.back());
+	}
+
+	// Query cost. The sums keep the queries from being optimized away.
+	float32 exactSum = 0.0f, fieldSum = 0.0f;
+	Clock::time_point exactStart = Clock::now();
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		exactSum += ComputeDistance(level, points[i], nullptr);
+	}
+	Clock::time_point fieldStart = Clock::now();
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		b2Vec2 gradient;
+		fieldSum += field.Sample(points[i], &gradient);
+	}
+	Clock::time_point fieldEnd = Clock::now();
+	printf("query exact %.3f us  field %.4f us  (%g %g)\n",
+		1000.0 * Milliseconds(exactStart, fieldStart) / queryCount,
+		1000.0 * Milliseconds(fieldStart, fieldEnd) / queryCount, exactSum, fieldSum);
+
+	Simulate("exact", ballCount, stepCount, level, nullptr);
+	Simulate("field", ballCount, stepCount, level, &field);
+
+	for (size_t i = 0; i < level.size(); ++i)
+	{
+		delete level[i];
+	}
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Measures the narrow-phase on a large pile of mixed circles, boxes and capsules
+// resting on a terrain between two walls. The bodies are created in a shuffled
+// order so that neighboring contacts point to scattered memory, which is the case
+// the prefetching in b2ContactManager::Collide addresses. Build once as usual and
+// once with -DB2_NO_PREFETCH to compare; the positions are identical either way.
+// Build from the repository root with all of Box2D, for example:
+//   g++ -O2 -std=c++11 -I. Benchmarks/NarrowPhaseBenchmark.cpp $(find Box2D -name '*.cpp') -lpthread
+// Usage: NarrowPhaseBenchmark [rows] [steps]
+
+#include "Box2D/Box2D.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static void CreateScene(b2World* world, int32 rowCount)
+{
+	const int32 columnCount = 100;
+	const float32 halfWidth = 0.5f * columnCount + 1.0f;
+
+	b2BodyDef groundDef;
+	b2Body* ground = world->CreateBody(&groundDef);
+
+	// A gently rolling floor with many segments sharing one proxy.
+	const int32 heightCount = 400;
+	float32 heights[heightCount];
+	for (int32 i = 0; i < heightCount; ++i)
+	{
+		heights[i] = 0.5f * sinf(0.05f * i);
+	}
+	b2TerrainShape terrain;
+	terrain.CreateHeightfield(heights, heightCount, 2.0f * halfWidth / (heightCount - 1));
+	ground->CreateFixture(&terrain, 0.0f);
+
+	// CreateHeightfield starts at the origin, so shift the walls instead of the floor.
+	b2PolygonShape wall;
+	wall.SetAsBox(1.0f, 100.0f, b2Vec2(-1.0f, 100.0f), 0.0f);
+	ground->CreateFixture(&wall, 0.0f);
+	wall.SetAsBox(1.0f, 100.0f, b2Vec2(2.0f * halfWidth + 1.0f, 100.0f), 0.0f);
+	ground->CreateFixture(&wall, 0.0f);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.4f;
+	b2PolygonShape box;
+	box.SetAsBox(0.4f, 0.4f);
+	b2CapsuleShape capsule;
+	capsule.Set(b2Vec2(-0.25f, 0.0f), b2Vec2(0.25f, 0.0f), 0.3f);
+	const b2Shape* shapes[3] = { &circle, &box, &capsule };
+
+	// Shuffle the creation order with a fixed generator.
+	int32 count = rowCount * columnCount;
+	std::vector<int32> order(count);
+	for (int32 i = 0; i < count; ++i)
+	{
+		order[i] = i;
+	}
+	uint32 seed = 1;
+	for (int32 i = count - 1; i > 0; --i)
+	{
+		seed = 1664525u * seed + 1013904223u;
+		int32 j = int32((seed >> 8) % uint32(i + 1));
+		b2Swap(order[i], order[j]);
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 row = order[i] / columnCount;
+		int32 column = order[i] % columnCount;
+
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(1.0f + 1.0f * column + 0.1f * (row % 3), 2.0f + 1.0f * row);
+		world->CreateBody(&bd)->CreateFixture(shapes[order[i] % 3], 1.0f);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32 rowCount = argc > 1 ? atoi(argv[1]) : 40;
+	int32 stepCount = argc > 2 ? atoi(argv[2]) : 300;
+	if (rowCount <= 0 || stepCount <= 0)
+	{
+		printf("usage: %s [rows] [steps]\n", argv[0]);
+		return 1;
+	}
+
+	b2World world(b2Vec2(0.0f, -10.0f));
+	world.SetAllowSleeping(false);
+	CreateScene(&world, rowCount);
+
+	// Let the pile form before measuring.
+	for (int32 i = 0; i < 200; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+	}
+
+	float64 collide = 0.0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+		collide += world.GetProfile().collide;
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	float64 total = std::chrono::duration<float64, std::milli>(end - start).count();
+
+	float64 hash = 0.0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		hash += 1.3 * b->GetPosition().x + b->GetPosition().y;
+	}
+
+	int32 contactCount = world.GetContactCount();
+	printf("%d bodies, %d contacts: step %.3f ms  collide %.3f ms  %.1f ns per contact  hash %.6f\n",
+		world.GetBodyCount(), contactCount, total / stepCount, collide / stepCount,
+		1.0e6 * collide / stepCount / b2Max(contactCount, 1), hash);
+
+	return 0;
+}
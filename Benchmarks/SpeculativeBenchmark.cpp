@@ -0,0 +1,158 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Compares speculative contacts with the classic TOI sub-stepping on a field of
+// boxes hit by fast bullets, and with no continuous collision as a baseline.
+// Build from the repository root with all of Box2D, for example:
+//   g++ -O2 -std=c++11 -I. Benchmarks/SpeculativeBenchmark.cpp $(find Box2D -name '*.cpp') -lpthread
+// Usage: SpeculativeBenchmark [bullets] [steps]
+
+#include "Box2D/Box2D.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+enum Mode
+{
+	e_continuous,
+	e_speculative,
+	e_discrete,
+	e_modeCount
+};
+
+static const char* s_modeNames[e_modeCount] = { "continuous", "speculative", "discrete" };
+
+struct Result
+{
+	float64 stepTime;
+	float64 toiTime;
+	int32 tunneled;
+	int32 bullets;
+	float64 hash;
+};
+
+static void CreateScene(b2World* world, int32 bulletCount)
+{
+	b2BodyDef groundDef;
+	b2Body* ground = world->CreateBody(&groundDef);
+
+	b2EdgeShape edge;
+	edge.Set(b2Vec2(-200.0f, 0.0f), b2Vec2(200.0f, 0.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(-200.0f, 0.0f), b2Vec2(-200.0f, 100.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(200.0f, 0.0f), b2Vec2(200.0f, 100.0f));
+	ground->CreateFixture(&edge, 0.0f);
+
+	b2PolygonShape box;
+	box.SetAsBox(0.5f, 0.5f);
+	for (int32 i = 0; i < 60; ++i)
+	{
+		for (int32 j = 0; j < 40; ++j)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(-150.0f + 5.0f * i, 0.5f + 1.0f * j);
+			world->CreateBody(&bd)->CreateFixture(&box, 1.0f);
+		}
+	}
+
+	// The bullets cross several boxes per step. Use a fixed generator so
+	// every mode sees the same scene.
+	b2CircleShape circle;
+	circle.m_radius = 0.1f;
+	uint32 seed = 1;
+	for (int32 i = 0; i < bulletCount; ++i)
+	{
+		seed = 1664525u * seed + 1013904223u;
+
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.bullet = true;
+		bd.position.Set(-190.0f + float32((seed >> 8) % 380), 50.0f + float32((seed >> 4) % 40));
+		bd.linearVelocity.Set(float32(int32(seed % 400) - 200), -300.0f);
+		bd.userData = &circle;
+		world->CreateBody(&bd)->CreateFixture(&circle, 1.0f);
+	}
+}
+
+static Result Run(Mode mode, int32 bulletCount, int32 stepCount)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	world.SetSpeculativeContacts(mode == e_speculative);
+	world.SetContinuousPhysics(mode != e_discrete);
+	CreateScene(&world, bulletCount);
+
+	Result result;
+	result.toiTime = 0.0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+		result.toiTime += world.GetProfile().solveTOI;
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	result.stepTime = std::chrono::duration<float64, std::milli>(end - start).count() / stepCount;
+	result.toiTime /= stepCount;
+
+	// A bullet tunneled if it ended up below the ground between the walls.
+	result.tunneled = 0;
+	result.bullets = 0;
+	result.hash = 0.0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetPosition();
+		result.hash += 1.3 * p.x + p.y;
+
+		if (b->GetUserData() == nullptr)
+		{
+			continue;
+		}
+
+		++result.bullets;
+		if (p.y < -0.2f && -200.0f < p.x && p.x < 200.0f)
+		{
+			++result.tunneled;
+		}
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	int32 bulletCount = argc > 1 ? atoi(argv[1]) : 300;
+	int32 stepCount = argc > 2 ? atoi(argv[2]) : 120;
+	if (bulletCount < 0 || stepCount <= 0)
+	{
+		printf("usage: %s [bullets] [steps]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%d bullets, %d steps\n", bulletCount, stepCount);
+	for (int32 mode = 0; mode < e_modeCount; ++mode)
+	{
+		Result r = Run(Mode(mode), bulletCount, stepCount);
+		printf("%-12s step %8.3f ms  solveTOI %8.3f ms  tunneled %4d / %d  hash %.6f\n",
+			s_modeNames[mode], r.stepTime, r.toiTime, r.tunneled, r.bullets, r.hash);
+	}
+
+	return 0;
+}
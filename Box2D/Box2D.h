@@ -32,6 +32,7 @@ For discussion please visit http://box2d.org/forum
 // These include files constitute the main Box2D API
 
 #include "Box2D/Common/b2Settings.h"
+#include "Box2D/Common/b2AllocatorInterface.h"
 #include "Box2D/Common/b2Draw.h"
 #include "Box2D/Common/b2Timer.h"
 
@@ -39,6 +40,9 @@ For discussion please visit http://box2d.org/forum
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
 
 #include "Box2D/Collision/b2BroadPhase.h"
 #include "Box2D/Collision/b2Distance.h"
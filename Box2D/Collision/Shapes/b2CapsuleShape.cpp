@@ -0,0 +1,192 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include <new>
+
+void b2CapsuleShape::Set(const b2Vec2& v1, const b2Vec2& v2, float32 radius)
+{
+	b2Assert(b2DistanceSquared(v1, v2) > b2_linearSlop * b2_linearSlop);
+	b2Assert(radius >= 0.0f);
+	m_vertex1 = v1;
+	m_vertex2 = v2;
+	m_radius = radius;
+}
+
+b2Shape* b2CapsuleShape::Clone(b2BlockAllocator* allocator) const
+{
+	void* mem = allocator->Allocate(sizeof(b2CapsuleShape), b2_fixtureMemory);
+	b2CapsuleShape* clone = new (mem) b2CapsuleShape;
+	*clone = *this;
+	return clone;
+}
+
+int32 b2CapsuleShape::GetChildCount() const
+{
+	return 1;
+}
+
+// Closest point to p on the segment v1-v2.
+static b2Vec2 b2ClosestPointOnSegment(const b2Vec2& v1, const b2Vec2& v2, const b2Vec2& p)
+{
+	b2Vec2 e = v2 - v1;
+	float32 t = b2Clamp(b2Dot(p - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+	return v1 + t * e;
+}
+
+bool b2CapsuleShape::TestPoint(const b2Transform& transform, const b2Vec2& p) const
+{
+	b2Vec2 pLocal = b2MulT(transform, p);
+	b2Vec2 closest = b2ClosestPointOnSegment(m_vertex1, m_vertex2, pLocal);
+	return b2DistanceSquared(pLocal, closest) <= m_radius * m_radius;
+}
+
+// The ray is tested against the two sides and the two end caps. The first hit
+// is the closest one. A ray starting inside the capsule does not hit it.
+bool b2CapsuleShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+							const b2Transform& transform, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	// Put the ray into the capsule's frame of reference.
+	b2Vec2 p1 = b2MulT(transform.q, input.p1 - transform.p);
+	b2Vec2 p2 = b2MulT(transform.q, input.p2 - transform.p);
+	b2Vec2 d = p2 - p1;
+
+	float32 rr = b2Dot(d, d);
+	if (rr < b2_epsilon)
+	{
+		return false;
+	}
+
+	b2Vec2 v1 = m_vertex1;
+	b2Vec2 v2 = m_vertex2;
+	float32 radius = m_radius;
+
+	if (b2DistanceSquared(p1, b2ClosestPointOnSegment(v1, v2, p1)) <= radius * radius)
+	{
+		return false;
+	}
+
+	b2Vec2 axis = v2 - v1;
+	float32 length = axis.Normalize();
+	b2Vec2 normal = b2Cross(axis, 1.0f);
+
+	float32 fraction = input.maxFraction;
+	b2Vec2 hitNormal;
+	bool hit = false;
+
+	// The sides are the segment offset by the radius on either side.
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Vec2 n = i == 0 ? normal : -normal;
+
+		// dot(n, p1 + t * d - v1) = radius
+		float32 numerator = radius - b2Dot(n, p1 - v1);
+		float32 denominator = b2Dot(n, d);
+		if (denominator >= 0.0f)
+		{
+			continue;
+		}
+
+		float32 t = numerator / denominator;
+		if (t < 0.0f || fraction < t)
+		{
+			continue;
+		}
+
+		float32 s = b2Dot(p1 + t * d - v1, axis);
+		if (s < 0.0f || length < s)
+		{
+			continue;
+		}
+
+		fraction = t;
+		hitNormal = n;
+		hit = true;
+	}
+
+	// The caps are circles around the vertices. See b2CircleShape::RayCast.
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Vec2 s = p1 - (i == 0 ? v1 : v2);
+		float32 b = b2Dot(s, s) - radius * radius;
+		float32 c = b2Dot(s, d);
+		float32 sigma = c * c - rr * b;
+		if (sigma < 0.0f)
+		{
+			continue;
+		}
+
+		float32 a = -(c + b2Sqrt(sigma));
+		if (0.0f <= a && a <= fraction * rr)
+		{
+			fraction = a / rr;
+			hitNormal = s + fraction * d;
+			hitNormal.Normalize();
+			hit = true;
+		}
+	}
+
+	if (hit == false)
+	{
+		return false;
+	}
+
+	output->fraction = fraction;
+	output->normal = b2Mul(transform.q, hitNormal);
+	return true;
+}
+
+void b2CapsuleShape::ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2Vec2 v1 = b2Mul(transform, m_vertex1);
+	b2Vec2 v2 = b2Mul(transform, m_vertex2);
+
+	b2Vec2 r(m_radius, m_radius);
+	aabb->lowerBound = b2Min(v1, v2) - r;
+	aabb->upperBound = b2Max(v1, v2) + r;
+}
+
+// The capsule is a box of length l and width 2r plus the two caps, which add up to
+// a circle. The centroid of each cap is lc = 4r / (3pi) beyond the end of the box, so
+// moving a cap from its own centroid to there adds m * ((h + lc)^2 - lc^2) by the
+// parallel axis theorem, with h = l / 2.
+void b2CapsuleShape::ComputeMass(b2MassData* massData, float32 density) const
+{
+	float32 radius = m_radius;
+	float32 rr = radius * radius;
+	float32 length = b2Distance(m_vertex1, m_vertex2);
+	float32 ll = length * length;
+
+	float32 circleMass = density * b2_pi * rr;
+	float32 boxMass = density * 2.0f * radius * length;
+
+	massData->mass = circleMass + boxMass;
+	massData->center = 0.5f * (m_vertex1 + m_vertex2);
+
+	float32 lc = 4.0f * radius / (3.0f * b2_pi);
+	float32 h = 0.5f * length;
+	float32 circleInertia = circleMass * (0.5f * rr + h * h + 2.0f * h * lc);
+	float32 boxInertia = boxMass * (4.0f * rr + ll) / 12.0f;
+
+	// Inertia about the local origin.
+	massData->I = circleInertia + boxInertia + massData->mass * b2Dot(massData->center, massData->center);
+}
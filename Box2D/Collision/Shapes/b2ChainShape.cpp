@@ -28,8 +28,12 @@ b2ChainShape::~b2ChainShape()
 
 void b2ChainShape::Clear()
 {
-	b2Free(m_vertices);
+	if (m_ownsVertices)
+	{
+		b2Free(m_vertices);
+	}
 	m_vertices = nullptr;
+	m_ownsVertices = true;
 	m_count = 0;
 }
 
@@ -81,6 +85,22 @@ void b2ChainShape::CreateChain(const b2Vec2* vertices, int32 count)
 	m_nextVertex.SetZero();
 }
 
+void b2ChainShape::CreateChainReference(const b2Vec2* vertices, int32 count)
+{
+	b2Assert(m_vertices == nullptr && m_count == 0);
+	b2Assert(count >= 2);
+
+	m_count = count;
+	m_vertices = const_cast<b2Vec2*>(vertices);
+	m_ownsVertices = false;
+
+	m_hasPrevVertex = false;
+	m_hasNextVertex = false;
+
+	m_prevVertex.SetZero();
+	m_nextVertex.SetZero();
+}
+
 void b2ChainShape::SetPrevVertex(const b2Vec2& prevVertex)
 {
 	m_prevVertex = prevVertex;
@@ -95,9 +115,16 @@ void b2ChainShape::SetNextVertex(const b2Vec2& nextVertex)
 
 b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 {
-	void* mem = allocator->Allocate(sizeof(b2ChainShape));
+	void* mem = allocator->Allocate(sizeof(b2ChainShape), b2_fixtureMemory);
 	b2ChainShape* clone = new (mem) b2ChainShape;
-	clone->CreateChain(m_vertices, m_count);
+	if (m_ownsVertices)
+	{
+		clone->CreateChain(m_vertices, m_count);
+	}
+	else
+	{
+		clone->CreateChainReference(m_vertices, m_count);
+	}
 	clone->m_prevVertex = m_prevVertex;
 	clone->m_nextVertex = m_nextVertex;
 	clone->m_hasPrevVertex = m_hasPrevVertex;
@@ -50,6 +50,14 @@ public:
 	/// @param count the vertex count
 	void CreateChain(const b2Vec2* vertices, int32 count);
 
+	/// Use vertices owned by the caller instead of copying them, for example
+	/// from a memory mapped file. The vertices must outlive this shape and its
+	/// clones. A loop must repeat its first vertex at the end and set up the
+	/// ghost vertices.
+	/// @param vertices an array of vertices, these are referenced
+	/// @param count the vertex count
+	void CreateChainReference(const b2Vec2* vertices, int32 count);
+
 	/// Establish connectivity to a vertex that precedes the first vertex.
 	/// Don't call this for loops.
 	void SetPrevVertex(const b2Vec2& prevVertex);
@@ -58,7 +66,7 @@ public:
 	/// Don't call this for loops.
 	void SetNextVertex(const b2Vec2& nextVertex);
 
-	/// Implement b2Shape. Vertices are cloned using b2Alloc.
+	/// Implement b2Shape. Vertices are cloned using b2Alloc unless they are referenced.
 	b2Shape* Clone(b2BlockAllocator* allocator) const override;
 
 	/// @see b2Shape::GetChildCount
@@ -82,9 +90,12 @@ public:
 	/// @see b2Shape::ComputeMass
 	void ComputeMass(b2MassData* massData, float32 density) const override;
 
-	/// The vertices. Owned by this class.
+	/// The vertices. Owned by this class unless created by CreateChainReference.
 	b2Vec2* m_vertices;
 
+	/// False if the vertices are owned by the caller.
+	bool m_ownsVertices;
+
 	/// The vertex count.
 	int32 m_count;
 
@@ -97,6 +108,7 @@ inline b2ChainShape::b2ChainShape()
 	m_type = e_chain;
 	m_radius = b2_polygonRadius;
 	m_vertices = nullptr;
+	m_ownsVertices = true;
 	m_count = 0;
 	m_hasPrevVertex = false;
 	m_hasNextVertex = false;
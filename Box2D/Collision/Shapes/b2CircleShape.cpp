@@ -21,7 +21,7 @@
 
 b2Shape* b2CircleShape::Clone(b2BlockAllocator* allocator) const
 {
-	void* mem = allocator->Allocate(sizeof(b2CircleShape));
+	void* mem = allocator->Allocate(sizeof(b2CircleShape), b2_fixtureMemory);
 	b2CircleShape* clone = new (mem) b2CircleShape;
 	*clone = *this;
 	return clone;
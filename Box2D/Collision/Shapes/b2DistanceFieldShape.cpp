@@ -0,0 +1,503 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
+#include "Box2D/Collision/Shapes/b2CircleShape.h"
+#include "Box2D/Collision/Shapes/b2EdgeShape.h"
+#include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Collision/Shapes/b2ChainShape.h"
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+#include "Box2D/Common/b2BinaryStream.h"
+#include <math.h>
+#include <new>
+#include <string.h>
+
+// Identifies a field written by b2DistanceFieldShape::Save.
+const uint32 b2_distanceFieldMagic = 0x46443262;	// "b2DF"
+const int32 b2_distanceFieldVersion = 1;
+
+// The largest quantized sample, which stands for the margin.
+const float32 b2_distanceFieldRange = 32767.0f;
+
+// The maximum number of steps used to march a ray.
+const int32 b2_distanceFieldMaxRaySteps = 64;
+
+b2DistanceFieldShape::~b2DistanceFieldShape()
+{
+	Clear();
+}
+
+void b2DistanceFieldShape::Clear()
+{
+	b2Free(m_values);
+	m_values = nullptr;
+	m_width = 0;
+	m_height = 0;
+}
+
+static float32 b2SegmentDistance(const b2Vec2& p, const b2Vec2& v1, const b2Vec2& v2)
+{
+	b2Vec2 e = v2 - v1;
+	float32 t = b2Dot(p - v1, e);
+	float32 ee = b2Dot(e, e);
+	if (t <= 0.0f || ee == 0.0f)
+	{
+		return b2Distance(p, v1);
+	}
+
+	if (t >= ee)
+	{
+		return b2Distance(p, v2);
+	}
+
+	return b2Distance(p, v1 + (t / ee) * e);
+}
+
+// Inside a convex polygon the distance to the closest face plane is exact.
+static float32 b2PolygonDistance(const b2Vec2& p, const b2PolygonShape* polygon)
+{
+	int32 count = polygon->m_count;
+	float32 separation = -b2_maxFloat;
+	for (int32 i = 0; i < count; ++i)
+	{
+		separation = b2Max(separation, b2Dot(polygon->m_normals[i], p - polygon->m_vertices[i]));
+	}
+
+	if (separation <= 0.0f)
+	{
+		return separation - polygon->m_radius;
+	}
+
+	float32 distance = b2_maxFloat;
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 i2 = i + 1 < count ? i + 1 : 0;
+		distance = b2Min(distance, b2SegmentDistance(p, polygon->m_vertices[i], polygon->m_vertices[i2]));
+	}
+
+	return distance - polygon->m_radius;
+}
+
+static float32 b2ShapeDistance(const b2Vec2& p, const b2Shape* shape, int32 childIndex)
+{
+	switch (shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* circle = (const b2CircleShape*)shape;
+			return b2Distance(p, circle->m_p) - circle->m_radius;
+		}
+
+	case b2Shape::e_edge:
+		{
+			const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+			return b2SegmentDistance(p, edge->m_vertex1, edge->m_vertex2) - edge->m_radius;
+		}
+
+	case b2Shape::e_polygon:
+		return b2PolygonDistance(p, (const b2PolygonShape*)shape);
+
+	case b2Shape::e_chain:
+		{
+			const b2ChainShape* chain = (const b2ChainShape*)shape;
+			int32 i2 = childIndex + 1 < chain->m_count ? childIndex + 1 : 0;
+			return b2SegmentDistance(p, chain->m_vertices[childIndex], chain->m_vertices[i2]) - chain->m_radius;
+		}
+
+	case b2Shape::e_capsule:
+		{
+			const b2CapsuleShape* capsule = (const b2CapsuleShape*)shape;
+			return b2SegmentDistance(p, capsule->m_vertex1, capsule->m_vertex2) - capsule->m_radius;
+		}
+
+	case b2Shape::e_terrain:
+		{
+			const b2TerrainShape* terrain = (const b2TerrainShape*)shape;
+			return b2SegmentDistance(p, terrain->m_vertices[childIndex], terrain->m_vertices[childIndex + 1]) - terrain->m_radius;
+		}
+
+	default:
+		b2Assert(false);
+		return b2_maxFloat;
+	}
+}
+
+// Terrains are sampled per segment rather than per child, so that each segment only
+// touches the samples near it.
+static int32 b2GetPieceCount(const b2Shape* shape)
+{
+	if (shape->m_type == b2Shape::e_terrain)
+	{
+		return ((const b2TerrainShape*)shape)->GetSegmentCount();
+	}
+
+	return shape->GetChildCount();
+}
+
+static void b2ComputePieceAABB(b2AABB* aabb, const b2Shape* shape, int32 index)
+{
+	b2Transform identity;
+	identity.SetIdentity();
+
+	if (shape->m_type == b2Shape::e_terrain)
+	{
+		((const b2TerrainShape*)shape)->ComputeSegmentAABB(aabb, identity, index);
+	}
+	else
+	{
+		shape->ComputeAABB(aabb, identity, index);
+	}
+}
+
+void b2DistanceFieldShape::Bake(const b2Shape* const* shapes, int32 count, float32 cellSize, float32 margin)
+{
+	b2Assert(count > 0);
+	b2Assert(cellSize > 0.0f && margin > 0.0f);
+
+	Clear();
+
+	b2AABB bounds;
+	b2ComputePieceAABB(&bounds, shapes[0], 0);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(shapes[i]->m_type != e_distanceField);
+		int32 pieceCount = b2GetPieceCount(shapes[i]);
+		for (int32 j = 0; j < pieceCount; ++j)
+		{
+			b2AABB aabb;
+			b2ComputePieceAABB(&aabb, shapes[i], j);
+			bounds.Combine(aabb);
+		}
+	}
+
+	b2Vec2 border(margin, margin);
+	bounds.lowerBound -= border;
+	bounds.upperBound += border;
+
+	m_origin = bounds.lowerBound;
+	m_cellSize = cellSize;
+	m_inverseCellSize = 1.0f / cellSize;
+	m_margin = margin;
+
+	b2Vec2 size = bounds.upperBound - bounds.lowerBound;
+	m_width = b2Max(int32(ceilf(size.x * m_inverseCellSize)) + 1, 2);
+	m_height = b2Max(int32(ceilf(size.y * m_inverseCellSize)) + 1, 2);
+	int32 sampleCount = m_width * m_height;
+
+	float32* distances = (float32*)b2Alloc(sampleCount * sizeof(float32));
+	for (int32 i = 0; i < sampleCount; ++i)
+	{
+		distances[i] = margin;
+	}
+
+	// Only the samples within the margin of a piece can be changed by it.
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2Shape* shape = shapes[i];
+		int32 pieceCount = b2GetPieceCount(shape);
+		for (int32 j = 0; j < pieceCount; ++j)
+		{
+			b2AABB aabb;
+			b2ComputePieceAABB(&aabb, shape, j);
+			b2Vec2 lower = m_inverseCellSize * (aabb.lowerBound - border - m_origin);
+			b2Vec2 upper = m_inverseCellSize * (aabb.upperBound + border - m_origin);
+			int32 x1 = b2Max(int32(floorf(lower.x)), 0);
+			int32 y1 = b2Max(int32(floorf(lower.y)), 0);
+			int32 x2 = b2Min(int32(ceilf(upper.x)), m_width - 1);
+			int32 y2 = b2Min(int32(ceilf(upper.y)), m_height - 1);
+
+			for (int32 y = y1; y <= y2; ++y)
+			{
+				float32* row = distances + y * m_width;
+				for (int32 x = x1; x <= x2; ++x)
+				{
+					b2Vec2 p(m_origin.x + x * cellSize, m_origin.y + y * cellSize);
+					row[x] = b2Min(row[x], b2ShapeDistance(p, shape, j));
+				}
+			}
+		}
+	}
+
+	m_values = (int16*)b2Alloc(sampleCount * sizeof(int16));
+	float32 scale = b2_distanceFieldRange / margin;
+	for (int32 i = 0; i < sampleCount; ++i)
+	{
+		float32 value = b2Clamp(scale * distances[i], -b2_distanceFieldRange, b2_distanceFieldRange);
+		m_values[i] = int16(floorf(value + 0.5f));
+	}
+
+	b2Free(distances);
+}
+
+float32 b2DistanceFieldShape::Sample(const b2Vec2& p, b2Vec2* gradient) const
+{
+	float32 u = (p.x - m_origin.x) * m_inverseCellSize;
+	float32 v = (p.y - m_origin.y) * m_inverseCellSize;
+
+	// The border of the grid is at least the margin away from everything.
+	if (m_values == nullptr || !(u >= 0.0f && v >= 0.0f && u <= float32(m_width - 1) && v <= float32(m_height - 1)))
+	{
+		if (gradient)
+		{
+			gradient->SetZero();
+		}
+		return m_margin;
+	}
+
+	int32 x = b2Min(int32(u), m_width - 2);
+	int32 y = b2Min(int32(v), m_height - 2);
+	float32 fx = u - float32(x);
+	float32 fy = v - float32(y);
+
+	const int16* row = m_values + y * m_width + x;
+	float32 scale = m_margin / b2_distanceFieldRange;
+	float32 d00 = scale * row[0];
+	float32 d10 = scale * row[1];
+	float32 d01 = scale * row[m_width];
+	float32 d11 = scale * row[m_width + 1];
+
+	float32 d0 = d00 + fx * (d10 - d00);
+	float32 d1 = d01 + fx * (d11 - d01);
+
+	if (gradient)
+	{
+		gradient->x = m_inverseCellSize * ((1.0f - fy) * (d10 - d00) + fy * (d11 - d01));
+		gradient->y = m_inverseCellSize * (d1 - d0);
+	}
+
+	return d0 + fy * (d1 - d0);
+}
+
+int32 b2DistanceFieldShape::Save(void* buffer, int32 capacity) const
+{
+	b2BinaryWriter writer(buffer, capacity);
+	writer.Write(b2_distanceFieldMagic);
+	writer.Write(b2_distanceFieldVersion);
+	Write(&writer);
+	return writer.GetSize();
+}
+
+bool b2DistanceFieldShape::Load(const void* data, int32 size)
+{
+	b2BinaryReader reader(data, size);
+	uint32 magic = reader.Read<uint32>();
+	int32 version = reader.Read<int32>();
+	if (reader.IsValid() == false || magic != b2_distanceFieldMagic || version != b2_distanceFieldVersion)
+	{
+		return false;
+	}
+
+	return Read(&reader);
+}
+
+void b2DistanceFieldShape::Write(b2BinaryWriter* writer) const
+{
+	writer->Write(m_origin);
+	writer->Write(m_cellSize);
+	writer->Write(m_margin);
+	writer->Write(m_width);
+	writer->Write(m_height);
+	writer->Write(m_values, m_width * m_height * int32(sizeof(int16)));
+}
+
+bool b2DistanceFieldShape::Read(b2BinaryReader* reader)
+{
+	b2Vec2 origin = reader->Read<b2Vec2>();
+	float32 cellSize = reader->Read<float32>();
+	float32 margin = reader->Read<float32>();
+	int32 width = reader->Read<int32>();
+	int32 height = reader->Read<int32>();
+	if (reader->IsValid() == false || !(cellSize > 0.0f) || !(margin > 0.0f) || width < 2 || height < 2)
+	{
+		return false;
+	}
+
+	// Check the size before multiplying so that a bad header cannot overflow.
+	int32 remaining = reader->GetSize() - reader->GetPosition();
+	if (width > remaining / (height * int32(sizeof(int16))))
+	{
+		return false;
+	}
+
+	int32 byteCount = width * height * int32(sizeof(int16));
+	const void* values = reader->Skip(byteCount);
+	if (values == nullptr)
+	{
+		return false;
+	}
+
+	Clear();
+	m_origin = origin;
+	m_cellSize = cellSize;
+	m_inverseCellSize = 1.0f / cellSize;
+	m_margin = margin;
+	m_width = width;
+	m_height = height;
+	m_values = (int16*)b2Alloc(byteCount);
+	memcpy(m_values, values, byteCount);
+	return true;
+}
+
+b2Shape* b2DistanceFieldShape::Clone(b2BlockAllocator* allocator) const
+{
+	void* mem = allocator->Allocate(sizeof(b2DistanceFieldShape), b2_fixtureMemory);
+	b2DistanceFieldShape* clone = new (mem) b2DistanceFieldShape;
+	clone->m_radius = m_radius;
+	clone->m_origin = m_origin;
+	clone->m_cellSize = m_cellSize;
+	clone->m_inverseCellSize = m_inverseCellSize;
+	clone->m_width = m_width;
+	clone->m_height = m_height;
+	clone->m_margin = m_margin;
+	int32 byteCount = m_width * m_height * sizeof(int16);
+	clone->m_values = (int16*)b2Alloc(byteCount);
+	memcpy(clone->m_values, m_values, byteCount);
+	return clone;
+}
+
+int32 b2DistanceFieldShape::GetChildCount() const
+{
+	return 1;
+}
+
+bool b2DistanceFieldShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+	return Sample(b2MulT(xf, p), nullptr) <= 0.0f;
+}
+
+// Sphere tracing: the ray advances by the sampled distance, which is close to a
+// lower bound on the distance to the surface, until it gets within a tolerance.
+// Rays that start inside miss, as with polygons.
+bool b2DistanceFieldShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+									const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	if (m_values == nullptr)
+	{
+		return false;
+	}
+
+	// Put the ray into the body frame.
+	b2Vec2 p1 = b2MulT(xf.q, input.p1 - xf.p);
+	b2Vec2 p2 = b2MulT(xf.q, input.p2 - xf.p);
+	b2Vec2 d = p2 - p1;
+	float32 length = d.Length();
+	if (length < b2_epsilon)
+	{
+		return false;
+	}
+
+	b2AABB box;
+	box.lowerBound = m_origin;
+	box.upperBound = m_origin + m_cellSize * b2Vec2(float32(m_width - 1), float32(m_height - 1));
+
+	// Start where the ray enters the grid.
+	float32 t = 0.0f;
+	bool inside = box.lowerBound.x <= p1.x && p1.x <= box.upperBound.x &&
+				box.lowerBound.y <= p1.y && p1.y <= box.upperBound.y;
+	if (inside == false)
+	{
+		b2RayCastInput boxInput;
+		boxInput.p1 = p1;
+		boxInput.p2 = p2;
+		boxInput.maxFraction = input.maxFraction;
+
+		b2RayCastOutput boxOutput;
+		if (box.RayCast(&boxOutput, boxInput) == false)
+		{
+			return false;
+		}
+		t = boxOutput.fraction;
+	}
+	else if (Sample(p1, nullptr) <= 0.0f)
+	{
+		// The ray starts inside.
+		return false;
+	}
+
+	float32 tolerance = 0.25f * b2_linearSlop;
+	float32 inverseLength = 1.0f / length;
+
+	// Interpolation keeps the distance to an edge, chain or terrain above zero between
+	// the samples, since these have no inside. So a ray that gets within half a cell
+	// hits where the distance stops decreasing.
+	float32 nearDistance = 0.5f * m_cellSize + tolerance;
+	float32 lastT = t;
+	float32 lastDistance = b2_maxFloat;
+	b2Vec2 lastGradient(0.0f, 0.0f);
+
+	for (int32 i = 0; i < b2_distanceFieldMaxRaySteps; ++i)
+	{
+		b2Vec2 gradient;
+		float32 distance = Sample(p1 + t * d, &gradient);
+
+		if (distance < tolerance || (lastDistance < nearDistance && distance > lastDistance))
+		{
+			if (distance >= tolerance)
+			{
+				t = lastT;
+				gradient = lastGradient;
+			}
+
+			if (gradient.Normalize() < b2_epsilon)
+			{
+				gradient = -inverseLength * d;
+			}
+
+			output->fraction = t;
+			output->normal = b2Mul(xf.q, gradient);
+			return true;
+		}
+
+		lastT = t;
+		lastDistance = distance;
+		lastGradient = gradient;
+
+		t += distance * inverseLength;
+		if (t > input.maxFraction)
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+void b2DistanceFieldShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	// Rotate the grid box into the world frame.
+	b2Vec2 h = 0.5f * m_cellSize * b2Vec2(float32(m_width - 1), float32(m_height - 1));
+	b2Vec2 center = b2Mul(xf, m_origin + h);
+	float32 c = b2Abs(xf.q.c), s = b2Abs(xf.q.s);
+	b2Vec2 extents(c * h.x + s * h.y, s * h.x + c * h.y);
+	aabb->lowerBound = center - extents;
+	aabb->upperBound = center + extents;
+}
+
+void b2DistanceFieldShape::ComputeMass(b2MassData* massData, float32 density) const
+{
+	B2_NOT_USED(density);
+
+	massData->mass = 0.0f;
+	massData->center.SetZero();
+	massData->I = 0.0f;
+}
@@ -0,0 +1,126 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_DISTANCE_FIELD_SHAPE_H
+#define B2_DISTANCE_FIELD_SHAPE_H
+
+#include "Box2D/Collision/Shapes/b2Shape.h"
+
+class b2BinaryReader;
+class b2BinaryWriter;
+
+/// A distance field is static geometry baked into a grid of signed distances. Circles
+/// collide with it using a few grid lookups, with the normal taken from the gradient.
+/// This replaces the pairs of a ball with the many fixtures of a static level by a
+/// single pair. Only circles collide with a distance field. Use filtering so that
+/// circles skip the fixtures that were baked and other shapes skip the field.
+/// The samples are quantized to 16 bits and allocated using b2Alloc.
+/// A distance field should only be attached to a static body.
+class b2DistanceFieldShape : public b2Shape
+{
+public:
+	b2DistanceFieldShape();
+
+	/// The destructor frees the samples using b2Free.
+	~b2DistanceFieldShape();
+
+	/// Clear all data.
+	void Clear();
+
+	/// Sample the signed distance to a set of shapes in the frame of this shape.
+	/// Chains, edges and terrains have no inside, so their distance is unsigned.
+	/// Distances are clamped to the margin, which must exceed the radius of the
+	/// circles that collide with the field.
+	/// @param shapes the shapes to sample
+	/// @param count the shape count
+	/// @param cellSize the spacing of the samples
+	/// @param margin the largest distance stored and the border around the shapes
+	void Bake(const b2Shape* const* shapes, int32 count, float32 cellSize, float32 margin);
+
+	/// Get the signed distance at a point in the frame of this shape by bilinear
+	/// interpolation. Points off the grid are at least the margin away.
+	/// @param gradient receives the gradient of the distance, may be null
+	float32 Sample(const b2Vec2& p, b2Vec2* gradient) const;
+
+	/// Write the baked field so that it can be cached, for example to disk.
+	/// @param buffer the destination, may be null to query the size
+	/// @param capacity the size of the buffer in bytes
+	/// @return the number of bytes needed
+	int32 Save(void* buffer, int32 capacity) const;
+
+	/// Read a field written by Save.
+	/// @return false if the data is not a valid field
+	bool Load(const void* data, int32 size);
+
+	/// Serialize the field without a header.
+	void Write(b2BinaryWriter* writer) const;
+	bool Read(b2BinaryReader* reader);
+
+	/// Implement b2Shape. The samples are cloned using b2Alloc.
+	b2Shape* Clone(b2BlockAllocator* allocator) const override;
+
+	/// @see b2Shape::GetChildCount
+	int32 GetChildCount() const override;
+
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2Transform& transform, const b2Vec2& p) const override;
+
+	/// March the ray through the field.
+	/// @see b2Shape::RayCast
+	bool RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+					const b2Transform& transform, int32 childIndex) const override;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const override;
+
+	/// Distance fields have zero mass.
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData, float32 density) const override;
+
+	/// The position of the first sample.
+	b2Vec2 m_origin;
+
+	/// The spacing of the samples and its inverse.
+	float32 m_cellSize;
+	float32 m_inverseCellSize;
+
+	/// The number of samples along each axis.
+	int32 m_width;
+	int32 m_height;
+
+	/// The largest stored distance. A sample of 32767 is the margin.
+	float32 m_margin;
+
+	/// The samples, row by row.
+	int16* m_values;
+};
+
+inline b2DistanceFieldShape::b2DistanceFieldShape()
+{
+	m_type = e_distanceField;
+	m_radius = 0.0f;
+	m_origin.SetZero();
+	m_cellSize = 0.0f;
+	m_inverseCellSize = 0.0f;
+	m_width = 0;
+	m_height = 0;
+	m_margin = 0.0f;
+	m_values = nullptr;
+}
+
+#endif
@@ -21,7 +21,7 @@
 
 b2Shape* b2PolygonShape::Clone(b2BlockAllocator* allocator) const
 {
-	void* mem = allocator->Allocate(sizeof(b2PolygonShape));
+	void* mem = allocator->Allocate(sizeof(b2PolygonShape), b2_fixtureMemory);
 	b2PolygonShape* clone = new (mem) b2PolygonShape;
 	*clone = *this;
 	return clone;
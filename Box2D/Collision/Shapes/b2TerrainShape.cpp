@@ -0,0 +1,330 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+#include "Box2D/Collision/Shapes/b2EdgeShape.h"
+#include <new>
+#include <string.h>
+
+// The maximum number of segments in a leaf of the segment tree.
+const int32 b2_terrainLeafSize = 4;
+
+b2TerrainShape::~b2TerrainShape()
+{
+	Clear();
+}
+
+void b2TerrainShape::Clear()
+{
+	b2Free(m_vertices);
+	m_vertices = nullptr;
+	m_count = 0;
+	b2Free(m_nodes);
+	m_nodes = nullptr;
+	m_nodeCapacity = 0;
+}
+
+void b2TerrainShape::Create(const b2Vec2* vertices, int32 count)
+{
+	b2Assert(m_vertices == nullptr && m_count == 0);
+	b2Assert(count >= 2);
+	for (int32 i = 1; i < count; ++i)
+	{
+		// If the code crashes here, it means your vertices are too close together.
+		b2Assert(b2DistanceSquared(vertices[i-1], vertices[i]) > b2_linearSlop * b2_linearSlop);
+	}
+
+	m_count = count;
+	m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+	memcpy(m_vertices, vertices, count * sizeof(b2Vec2));
+
+	m_hasPrevVertex = false;
+	m_hasNextVertex = false;
+
+	m_prevVertex.SetZero();
+	m_nextVertex.SetZero();
+
+	BuildTree();
+}
+
+void b2TerrainShape::CreateHeightfield(const float32* heights, int32 count, float32 spacing)
+{
+	b2Assert(m_vertices == nullptr && m_count == 0);
+	b2Assert(count >= 2);
+	b2Assert(spacing > b2_linearSlop);
+
+	m_count = count;
+	m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_vertices[i].Set(i * spacing, heights[i]);
+	}
+
+	m_hasPrevVertex = false;
+	m_hasNextVertex = false;
+
+	m_prevVertex.SetZero();
+	m_nextVertex.SetZero();
+
+	BuildTree();
+}
+
+// The tree splits the segments in halves until a leaf holds at most b2_terrainLeafSize
+// segments. A polyline keeps neighbors close in space, so ranges of consecutive
+// segments make tight boxes and the tree needs no search to build.
+void b2TerrainShape::BuildTree()
+{
+	int32 segmentCount = m_count - 1;
+
+	// Find the depth at which a range is small enough to be a leaf.
+	int32 depth = 0;
+	while (((segmentCount - 1) >> depth) + 1 > b2_terrainLeafSize)
+	{
+		++depth;
+	}
+
+	m_nodeCapacity = (2 << depth) - 1;
+	m_nodes = (b2TerrainNode*)b2Alloc(m_nodeCapacity * sizeof(b2TerrainNode));
+	BuildNode(0, 0, segmentCount);
+}
+
+void b2TerrainShape::BuildNode(int32 nodeIndex, int32 first, int32 count)
+{
+	b2Assert(nodeIndex < m_nodeCapacity);
+	b2TerrainNode* node = m_nodes + nodeIndex;
+	node->first = first;
+
+	if (count <= b2_terrainLeafSize)
+	{
+		node->count = count;
+		node->aabb.lowerBound = m_vertices[first];
+		node->aabb.upperBound = m_vertices[first];
+		for (int32 i = first + 1; i <= first + count; ++i)
+		{
+			node->aabb.lowerBound = b2Min(node->aabb.lowerBound, m_vertices[i]);
+			node->aabb.upperBound = b2Max(node->aabb.upperBound, m_vertices[i]);
+		}
+		return;
+	}
+
+	int32 half = (count + 1) / 2;
+	BuildNode(2 * nodeIndex + 1, first, half);
+	BuildNode(2 * nodeIndex + 2, first + half, count - half);
+
+	node->count = 0;
+	node->aabb.Combine(m_nodes[2 * nodeIndex + 1].aabb, m_nodes[2 * nodeIndex + 2].aabb);
+}
+
+void b2TerrainShape::SetPrevVertex(const b2Vec2& prevVertex)
+{
+	m_prevVertex = prevVertex;
+	m_hasPrevVertex = true;
+}
+
+void b2TerrainShape::SetNextVertex(const b2Vec2& nextVertex)
+{
+	m_nextVertex = nextVertex;
+	m_hasNextVertex = true;
+}
+
+b2Shape* b2TerrainShape::Clone(b2BlockAllocator* allocator) const
+{
+	void* mem = allocator->Allocate(sizeof(b2TerrainShape), b2_fixtureMemory);
+	b2TerrainShape* clone = new (mem) b2TerrainShape;
+	clone->m_radius = m_radius;
+	clone->m_count = m_count;
+	clone->m_vertices = (b2Vec2*)b2Alloc(m_count * sizeof(b2Vec2));
+	memcpy(clone->m_vertices, m_vertices, m_count * sizeof(b2Vec2));
+	clone->m_nodeCapacity = m_nodeCapacity;
+	clone->m_nodes = (b2TerrainNode*)b2Alloc(m_nodeCapacity * sizeof(b2TerrainNode));
+	memcpy(clone->m_nodes, m_nodes, m_nodeCapacity * sizeof(b2TerrainNode));
+	clone->m_prevVertex = m_prevVertex;
+	clone->m_nextVertex = m_nextVertex;
+	clone->m_hasPrevVertex = m_hasPrevVertex;
+	clone->m_hasNextVertex = m_hasNextVertex;
+	return clone;
+}
+
+int32 b2TerrainShape::GetChildCount() const
+{
+	return 1;
+}
+
+void b2TerrainShape::GetChildEdge(b2EdgeShape* edge, int32 index) const
+{
+	b2Assert(0 <= index && index < m_count - 1);
+	edge->m_type = b2Shape::e_edge;
+	edge->m_radius = m_radius;
+
+	edge->m_vertex1 = m_vertices[index + 0];
+	edge->m_vertex2 = m_vertices[index + 1];
+
+	if (index > 0)
+	{
+		edge->m_vertex0 = m_vertices[index - 1];
+		edge->m_hasVertex0 = true;
+	}
+	else
+	{
+		edge->m_vertex0 = m_prevVertex;
+		edge->m_hasVertex0 = m_hasPrevVertex;
+	}
+
+	if (index < m_count - 2)
+	{
+		edge->m_vertex3 = m_vertices[index + 2];
+		edge->m_hasVertex3 = true;
+	}
+	else
+	{
+		edge->m_vertex3 = m_nextVertex;
+		edge->m_hasVertex3 = m_hasNextVertex;
+	}
+}
+
+void b2TerrainShape::ComputeSegmentAABB(b2AABB* aabb, const b2Transform& xf, int32 index) const
+{
+	b2Assert(0 <= index && index < m_count - 1);
+
+	b2Vec2 v1 = b2Mul(xf, m_vertices[index]);
+	b2Vec2 v2 = b2Mul(xf, m_vertices[index + 1]);
+
+	b2Vec2 r(m_radius, m_radius);
+	aabb->lowerBound = b2Min(v1, v2) - r;
+	aabb->upperBound = b2Max(v1, v2) + r;
+}
+
+void b2TerrainShape::GetLocalAABB(b2AABB* localAABB, const b2AABB& aabb, const b2Transform& xf) const
+{
+	b2Vec2 center = b2MulT(xf, aabb.GetCenter());
+	b2Vec2 h = aabb.GetExtents();
+	float32 c = b2Abs(xf.q.c), s = b2Abs(xf.q.s);
+	b2Vec2 extents(c * h.x + s * h.y + m_radius, s * h.x + c * h.y + m_radius);
+	localAABB->lowerBound = center - extents;
+	localAABB->upperBound = center + extents;
+}
+
+bool b2TerrainShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+	B2_NOT_USED(xf);
+	B2_NOT_USED(p);
+	return false;
+}
+
+// The tree is walked like b2DynamicTree::RayCast. Each hit shortens the ray,
+// so the remaining nodes are culled against the closest hit so far.
+bool b2TerrainShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+							const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	if (m_nodes == nullptr)
+	{
+		return false;
+	}
+
+	// Put the ray into the body frame.
+	b2Vec2 p1 = b2MulT(xf.q, input.p1 - xf.p);
+	b2Vec2 p2 = b2MulT(xf.q, input.p2 - xf.p);
+	b2Vec2 d = p2 - p1;
+	b2Vec2 r = d;
+	if (r.Normalize() < b2_epsilon)
+	{
+		return false;
+	}
+
+	// Separating axis for segment (Gino, p80).
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	b2RayCastInput subInput = input;
+	bool hit = false;
+
+	b2GrowableStack<int32, 64> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeIndex = stack.Pop();
+		const b2TerrainNode* node = m_nodes + nodeIndex;
+
+		b2Vec2 t = p1 + subInput.maxFraction * d;
+		b2AABB segmentAABB;
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+		if (b2TestOverlap(node->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		b2Vec2 c = node->aabb.GetCenter();
+		b2Vec2 h = node->aabb.GetExtents();
+		float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+		if (separation > 0.0f)
+		{
+			continue;
+		}
+
+		if (node->count == 0)
+		{
+			stack.Push(2 * nodeIndex + 2);
+			stack.Push(2 * nodeIndex + 1);
+			continue;
+		}
+
+		for (int32 i = node->first; i < node->first + node->count; ++i)
+		{
+			b2EdgeShape edge;
+			edge.Set(m_vertices[i], m_vertices[i + 1]);
+
+			b2RayCastOutput segmentOutput;
+			if (edge.RayCast(&segmentOutput, subInput, xf, 0))
+			{
+				*output = segmentOutput;
+				subInput.maxFraction = segmentOutput.fraction;
+				hit = true;
+			}
+		}
+	}
+
+	return hit;
+}
+
+void b2TerrainShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+	b2Assert(m_nodes != nullptr);
+
+	// Rotate the box of the root node into the world frame.
+	const b2AABB& root = m_nodes[0].aabb;
+	b2Vec2 center = b2Mul(xf, root.GetCenter());
+	b2Vec2 h = root.GetExtents();
+	float32 c = b2Abs(xf.q.c), s = b2Abs(xf.q.s);
+	b2Vec2 extents(c * h.x + s * h.y + m_radius, s * h.x + c * h.y + m_radius);
+	aabb->lowerBound = center - extents;
+	aabb->upperBound = center + extents;
+}
+
+void b2TerrainShape::ComputeMass(b2MassData* massData, float32 density) const
+{
+	B2_NOT_USED(density);
+
+	massData->mass = 0.0f;
+	massData->center.SetZero();
+	massData->I = 0.0f;
+}
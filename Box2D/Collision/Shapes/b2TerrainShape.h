@@ -0,0 +1,200 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TERRAIN_SHAPE_H
+#define B2_TERRAIN_SHAPE_H
+
+#include "Box2D/Collision/Shapes/b2Shape.h"
+#include "Box2D/Common/b2GrowableStack.h"
+
+class b2EdgeShape;
+
+/// A node of the terrain segment tree. A leaf covers a run of consecutive
+/// segments. Internal nodes have a count of zero.
+struct b2TerrainNode
+{
+	b2AABB aabb;
+	int32 first;
+	int32 count;
+};
+
+/// A terrain is a long static polyline, such as a level floor or a heightfield.
+/// Unlike a chain, it has a single broad-phase proxy. Contacts are created per
+/// segment using a segment tree held by the shape, and collide like edges with
+/// connectivity to their neighbors. Contacts use the segment index as their
+/// child index.
+/// Since there may be many vertices, they are allocated using b2Alloc.
+/// A terrain should only be attached to a static body.
+class b2TerrainShape : public b2Shape
+{
+public:
+	b2TerrainShape();
+
+	/// The destructor frees the vertices and the tree using b2Free.
+	~b2TerrainShape();
+
+	/// Clear all data.
+	void Clear();
+
+	/// Create a terrain from a polyline.
+	/// @param vertices an array of vertices, these are copied
+	/// @param count the vertex count
+	void Create(const b2Vec2* vertices, int32 count);
+
+	/// Create a terrain from evenly spaced heights. Vertex i is at (i * spacing, heights[i])
+	/// in the body frame.
+	/// @param heights an array of heights
+	/// @param count the height count
+	/// @param spacing the horizontal distance between heights
+	void CreateHeightfield(const float32* heights, int32 count, float32 spacing);
+
+	/// Establish connectivity to a vertex that precedes the first vertex.
+	void SetPrevVertex(const b2Vec2& prevVertex);
+
+	/// Establish connectivity to a vertex that follows the last vertex.
+	void SetNextVertex(const b2Vec2& nextVertex);
+
+	/// Implement b2Shape. Vertices and the tree are cloned using b2Alloc.
+	b2Shape* Clone(b2BlockAllocator* allocator) const override;
+
+	/// A terrain has a single child that covers all segments.
+	/// @see b2Shape::GetChildCount
+	int32 GetChildCount() const override;
+
+	/// Get the number of segments.
+	int32 GetSegmentCount() const;
+
+	/// Get a segment as an edge with connectivity.
+	void GetChildEdge(b2EdgeShape* edge, int32 index) const;
+
+	/// Compute the bounding box of a segment.
+	void ComputeSegmentAABB(b2AABB* aabb, const b2Transform& transform, int32 index) const;
+
+	/// Query the segments that overlap a world AABB. The callback is
+	/// called with the segment index and returns false to stop the query.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb, const b2Transform& transform) const;
+
+	/// This always return false.
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2Transform& transform, const b2Vec2& p) const override;
+
+	/// Cast a ray against all segments and report the closest hit.
+	/// @see b2Shape::RayCast
+	bool RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+					const b2Transform& transform, int32 childIndex) const override;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const override;
+
+	/// Terrains have zero mass.
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData, float32 density) const override;
+
+	/// The vertices.
+	b2Vec2* m_vertices;
+
+	/// The vertex count.
+	int32 m_count;
+
+	/// The segment tree in the body frame. The children of node i are 2i+1 and 2i+2.
+	b2TerrainNode* m_nodes;
+	int32 m_nodeCapacity;
+
+	b2Vec2 m_prevVertex, m_nextVertex;
+	bool m_hasPrevVertex, m_hasNextVertex;
+
+private:
+
+	void BuildTree();
+	void BuildNode(int32 nodeIndex, int32 first, int32 count);
+
+	// Compute the local bounding box of a world AABB, grown by the radius.
+	void GetLocalAABB(b2AABB* localAABB, const b2AABB& aabb, const b2Transform& transform) const;
+};
+
+inline b2TerrainShape::b2TerrainShape()
+{
+	m_type = e_terrain;
+	m_radius = b2_polygonRadius;
+	m_vertices = nullptr;
+	m_count = 0;
+	m_nodes = nullptr;
+	m_nodeCapacity = 0;
+	m_prevVertex.SetZero();
+	m_nextVertex.SetZero();
+	m_hasPrevVertex = false;
+	m_hasNextVertex = false;
+}
+
+inline int32 b2TerrainShape::GetSegmentCount() const
+{
+	return m_count - 1;
+}
+
+template <typename T>
+inline void b2TerrainShape::Query(T* callback, const b2AABB& aabb, const b2Transform& transform) const
+{
+	if (m_nodes == nullptr)
+	{
+		return;
+	}
+
+	b2AABB localAABB;
+	GetLocalAABB(&localAABB, aabb, transform);
+
+	b2GrowableStack<int32, 64> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeIndex = stack.Pop();
+		const b2TerrainNode* node = m_nodes + nodeIndex;
+
+		if (b2TestOverlap(node->aabb, localAABB) == false)
+		{
+			continue;
+		}
+
+		if (node->count == 0)
+		{
+			stack.Push(2 * nodeIndex + 2);
+			stack.Push(2 * nodeIndex + 1);
+			continue;
+		}
+
+		for (int32 i = node->first; i < node->first + node->count; ++i)
+		{
+			b2AABB segmentAABB;
+			segmentAABB.lowerBound = b2Min(m_vertices[i], m_vertices[i + 1]);
+			segmentAABB.upperBound = b2Max(m_vertices[i], m_vertices[i + 1]);
+			if (b2TestOverlap(segmentAABB, localAABB) == false)
+			{
+				continue;
+			}
+
+			bool proceed = callback->QueryCallback(i);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+	}
+}
+
+#endif
@@ -18,23 +18,107 @@
 
 #include "Box2D/Collision/b2BroadPhase.h"
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase::b2BroadPhase(b2AllocatorInterface* allocator) : m_allocator(allocator), m_tree(allocator)
 {
 	m_proxyCount = 0;
 
 	m_pairCapacity = 16;
 	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	m_pairBuffer = (b2Pair*)b2Alloc(m_allocator, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseMemory);
 
 	m_moveCapacity = 16;
 	m_moveCount = 0;
-	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_broadPhaseMemory);
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
+	b2Free(m_allocator, m_moveBuffer, m_moveCapacity * sizeof(int32), b2_broadPhaseMemory);
+	b2Free(m_allocator, m_pairBuffer, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseMemory);
+}
+
+void b2BroadPhase::WriteState(b2BinaryWriter* writer) const
+{
+	m_tree.WriteState(writer);
+	writer->Write(m_proxyCount);
+	writer->Write(m_moveCount);
+	writer->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+bool b2BroadPhase::CheckState(b2BinaryReader* reader) const
+{
+	if (m_tree.CheckState(reader, true) == false)
+	{
+		return false;
+	}
+
+	int32 proxyCount = reader->Read<int32>();
+	int32 moveCount = reader->Read<int32>();
+	int32 remaining = reader->GetSize() - reader->GetPosition();
+	if (reader->IsValid() == false || proxyCount != m_proxyCount ||
+		moveCount < 0 || remaining / int32(sizeof(int32)) < moveCount)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < moveCount; ++i)
+	{
+		int32 proxyId = reader->Read<int32>();
+		if (proxyId != e_nullProxy && m_tree.IsProxy(proxyId) == false)
+		{
+			return false;
+		}
+	}
+
+	return reader->IsValid();
+}
+
+bool b2BroadPhase::ReadState(b2BinaryReader* reader)
+{
+	b2BinaryReader check = *reader;
+	if (CheckState(&check) == false)
+	{
+		return false;
+	}
+
+	m_tree.ReadState(reader);
+	reader->Read(&m_proxyCount);
+
+	int32 moveCount = reader->Read<int32>();
+	if (moveCount > m_moveCapacity)
+	{
+		b2Free(m_allocator, m_moveBuffer, m_moveCapacity * sizeof(int32), b2_broadPhaseMemory);
+		m_moveCapacity = moveCount;
+		m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_broadPhaseMemory);
+	}
+	m_moveCount = moveCount;
+	reader->Read(m_moveBuffer, m_moveCount * sizeof(int32));
+	return true;
+}
+
+void b2BroadPhase::WriteTree(b2BinaryWriter* writer) const
+{
+	m_tree.WriteState(writer);
+}
+
+bool b2BroadPhase::ReadTree(b2BinaryReader* reader)
+{
+	b2Assert(m_proxyCount == 0);
+	if (m_tree.ReadState(reader) == false)
+	{
+		return false;
+	}
+
+	m_proxyCount = m_tree.GetProxyCount();
+	m_moveCount = 0;
+	return true;
+}
+
+void b2BroadPhase::ClearTree()
+{
+	m_tree.Clear();
+	m_proxyCount = 0;
+	m_moveCount = 0;
 }
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
@@ -45,6 +129,16 @@ int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+void b2BroadPhase::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	m_tree.CreateProxies(aabbs, userData, count, proxyIds);
+	m_proxyCount += count;
+	for (int32 i = 0; i < count; ++i)
+	{
+		BufferMove(proxyIds[i]);
+	}
+}
+
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
@@ -72,9 +166,9 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	{
 		int32* oldBuffer = m_moveBuffer;
 		m_moveCapacity *= 2;
-		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_broadPhaseMemory);
 		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
-		b2Free(oldBuffer);
+		b2Free(m_allocator, oldBuffer, m_moveCount * sizeof(int32), b2_broadPhaseMemory);
 	}
 
 	m_moveBuffer[m_moveCount] = proxyId;
@@ -106,9 +200,9 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 	{
 		b2Pair* oldBuffer = m_pairBuffer;
 		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+		m_pairBuffer = (b2Pair*)b2Alloc(m_allocator, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseMemory);
 		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-		b2Free(oldBuffer);
+		b2Free(m_allocator, oldBuffer, m_pairCount * sizeof(b2Pair), b2_broadPhaseMemory);
 	}
 
 	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
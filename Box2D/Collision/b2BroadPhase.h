@@ -42,13 +42,19 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// The tree and pair buffers come from the optional allocator interface.
+	b2BroadPhase(b2AllocatorInterface* allocator = nullptr);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
 	/// UpdatePairs is called.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create many proxies at once, building the tree in one pass when the batch
+	/// is large. Pairs are not reported until UpdatePairs is called.
+	/// @param proxyIds receives the proxy ids in order
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
@@ -71,6 +77,12 @@ public:
 	/// Get the number of proxies.
 	int32 GetProxyCount() const;
 
+	/// Set the limits of the adaptive fat AABB extension.
+	void SetExtensionLimits(float32 minExtension, float32 maxExtension);
+
+	/// Get the number of tree re-insertions caused by MoveProxy.
+	int32 GetReinsertCount() const;
+
 	/// Update the pairs. This results in pair callbacks. This can only add pairs.
 	template <typename T>
 	void UpdatePairs(T* callback);
@@ -104,6 +116,39 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Reorder the embedded tree nodes in memory. Proxy ids are preserved.
+	void Reorder(b2TreeLayout layout);
+
+	/// Write the tree and the pending moves.
+	void WriteState(b2BinaryWriter* writer) const;
+
+	/// Check a state written by WriteState and skip past it. The state must
+	/// use the proxy ids of this broad-phase. Nothing is changed.
+	bool CheckState(b2BinaryReader* reader) const;
+
+	/// Read a state written by WriteState. The proxy ids must match.
+	/// @return false and leave the broad-phase unchanged if the check fails
+	bool ReadState(b2BinaryReader* reader);
+
+	/// Write the tree structure only.
+	void WriteTree(b2BinaryWriter* writer) const;
+
+	/// Replace an empty tree with one written by WriteTree. This skips
+	/// building the tree one proxy at a time. The caller sets the user
+	/// data of each proxy and touches the proxies to generate pairs.
+	/// @return false and leave the tree empty if the tree is not well formed
+	bool ReadTree(b2BinaryReader* reader);
+
+	/// Drop all proxies without reporting them. This undoes a ReadTree
+	/// whose proxies the caller could not use.
+	void ClearTree();
+
+	/// Is this a proxy id in use? Any value may be passed.
+	bool IsProxy(int32 proxyId) const;
+
+	/// Set user data of a proxy.
+	void SetUserData(int32 proxyId, void* userData);
+
 private:
 
 	friend class b2DynamicTree;
@@ -113,6 +158,8 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	b2AllocatorInterface* m_allocator;
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
@@ -144,11 +191,21 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+inline bool b2BroadPhase::IsProxy(int32 proxyId) const
+{
+	return m_tree.IsProxy(proxyId);
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
 	return m_tree.GetUserData(proxyId);
 }
 
+inline void b2BroadPhase::SetUserData(int32 proxyId, void* userData)
+{
+	m_tree.SetUserData(proxyId, userData);
+}
+
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
 	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
@@ -166,6 +223,16 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline void b2BroadPhase::SetExtensionLimits(float32 minExtension, float32 maxExtension)
+{
+	m_tree.SetExtensionLimits(minExtension, maxExtension);
+}
+
+inline int32 b2BroadPhase::GetReinsertCount() const
+{
+	return m_tree.GetReinsertCount();
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
 	return m_tree.GetHeight();
@@ -254,4 +321,9 @@ inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 	m_tree.ShiftOrigin(newOrigin);
 }
 
+inline void b2BroadPhase::Reorder(b2TreeLayout layout)
+{
+	m_tree.Reorder(layout);
+}
+
 #endif
@@ -0,0 +1,369 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/b2Collision.h"
+#include "Box2D/Collision/b2Distance.h"
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2CircleShape.h"
+#include "Box2D/Collision/Shapes/b2EdgeShape.h"
+#include "Box2D/Collision/Shapes/b2PolygonShape.h"
+
+void b2CollideCapsuleAndCircle(b2Manifold* manifold,
+							   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance)
+{
+	manifold->pointCount = 0;
+
+	// Compute the circle in the frame of the capsule.
+	b2Vec2 Q = b2MulT(xfA, b2Mul(xfB, circleB->m_p));
+
+	b2Vec2 A = capsuleA->m_vertex1, B = capsuleA->m_vertex2;
+	b2Vec2 e = B - A;
+
+	// Fraction of the closest point along the segment
+	float32 s = b2Dot(Q - A, e) / b2Dot(e, e);
+
+	float32 radius = capsuleA->m_radius + circleB->m_radius + speculativeDistance;
+
+	b2ContactFeature cf;
+	cf.indexB = 0;
+	cf.typeB = b2ContactFeature::e_vertex;
+
+	if (s <= 0.0f || 1.0f <= s)
+	{
+		// The circle is closest to an end cap.
+		int32 index = s <= 0.0f ? 0 : 1;
+		b2Vec2 P = index == 0 ? A : B;
+		if (b2DistanceSquared(Q, P) > radius * radius)
+		{
+			return;
+		}
+
+		cf.indexA = (uint8)index;
+		cf.typeA = b2ContactFeature::e_vertex;
+		manifold->type = b2Manifold::e_circles;
+		manifold->localNormal.SetZero();
+		manifold->localPoint = P;
+	}
+	else
+	{
+		// The circle is closest to a side.
+		b2Vec2 P = A + s * e;
+		if (b2DistanceSquared(Q, P) > radius * radius)
+		{
+			return;
+		}
+
+		b2Vec2 n = b2Cross(e, 1.0f);
+		n.Normalize();
+		if (b2Dot(n, Q - A) < 0.0f)
+		{
+			n = -n;
+		}
+
+		cf.indexA = 0;
+		cf.typeA = b2ContactFeature::e_face;
+		manifold->type = b2Manifold::e_faceA;
+		manifold->localNormal = n;
+		manifold->localPoint = A;
+	}
+
+	manifold->pointCount = 1;
+	manifold->points[0].id.key = 0;
+	manifold->points[0].id.cf = cf;
+	manifold->points[0].localPoint = circleB->m_p;
+}
+
+// Clip the incident segment w1-w2 to the span of the reference segment v1-v2 and keep
+// the points within maxSeparation of the reference line. The segments are in the frame
+// of the reference shape. The transform takes the incident frame into the reference
+// frame and is used to store the points in the incident frame.
+static void b2ClipSegments(b2Manifold* manifold,
+						   const b2Vec2& v1, const b2Vec2& v2, const b2Vec2& normal,
+						   const b2Vec2& w1, const b2Vec2& w2, const b2Transform& xf,
+						   float32 maxSeparation, bool flip)
+{
+	b2Vec2 tangent = v2 - v1;
+	tangent.Normalize();
+
+	b2ClipVertex incidentEdge[2];
+	incidentEdge[0].v = w1;
+	incidentEdge[0].id.cf.indexA = 0;
+	incidentEdge[0].id.cf.indexB = 0;
+	incidentEdge[0].id.cf.typeA = b2ContactFeature::e_face;
+	incidentEdge[0].id.cf.typeB = b2ContactFeature::e_vertex;
+	incidentEdge[1].v = w2;
+	incidentEdge[1].id.cf.indexA = 0;
+	incidentEdge[1].id.cf.indexB = 1;
+	incidentEdge[1].id.cf.typeA = b2ContactFeature::e_face;
+	incidentEdge[1].id.cf.typeB = b2ContactFeature::e_vertex;
+
+	// Clip to the ends of the reference segment. Beyond them the caps are closer.
+	b2ClipVertex clipPoints1[2];
+	b2ClipVertex clipPoints2[2];
+	int32 count = b2ClipSegmentToLine(clipPoints1, incidentEdge, -tangent, -b2Dot(tangent, v1), 0);
+	if (count == 2)
+	{
+		count = b2ClipSegmentToLine(clipPoints2, clipPoints1, tangent, b2Dot(tangent, v2), 1);
+	}
+	else if (count == 1)
+	{
+		clipPoints2[0] = clipPoints1[0];
+	}
+
+	manifold->localNormal = normal;
+	manifold->localPoint = 0.5f * (v1 + v2);
+
+	int32 pointCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 separation = b2Dot(normal, clipPoints2[i].v - v1);
+		if (separation > maxSeparation)
+		{
+			continue;
+		}
+
+		b2ManifoldPoint* cp = manifold->points + pointCount;
+		cp->localPoint = b2MulT(xf, clipPoints2[i].v);
+		cp->id = clipPoints2[i].id;
+		if (flip)
+		{
+			// Swap features
+			b2ContactFeature cf = cp->id.cf;
+			cp->id.cf.indexA = cf.indexB;
+			cp->id.cf.indexB = cf.indexA;
+			cp->id.cf.typeA = cf.typeB;
+			cp->id.cf.typeB = cf.typeA;
+		}
+		++pointCount;
+	}
+
+	manifold->pointCount = pointCount;
+}
+
+// Collide the segment p1-p2 of A with the segment q1-q2 of B, rounded by the radii. The
+// segments are in the frames of their shapes. The contact is on the face of the segment
+// whose interior is closest, or between end points if neither is.
+static void b2CollideSegments(b2Manifold* manifold,
+							  const b2Vec2& p1, const b2Vec2& p2, float32 radiusA, const b2Transform& xfA,
+							  const b2Vec2& q1, const b2Vec2& q2, float32 radiusB, const b2Transform& xfB,
+							  float32 speculativeDistance)
+{
+	manifold->pointCount = 0;
+
+	// Put segment B into the frame of A.
+	b2Transform xf = b2MulT(xfA, xfB);
+	b2Vec2 r1 = b2Mul(xf, q1);
+	b2Vec2 r2 = b2Mul(xf, q2);
+
+	// Closest points of the segments. See Ericson, Real-Time Collision Detection, 5.1.9.
+	b2Vec2 d1 = p2 - p1;
+	b2Vec2 d2 = r2 - r1;
+	b2Vec2 r = p1 - r1;
+	float32 a = b2Dot(d1, d1);
+	float32 e = b2Dot(d2, d2);
+	float32 f = b2Dot(d2, r);
+
+	float32 s, t;
+	if (a <= b2_epsilon && e <= b2_epsilon)
+	{
+		s = 0.0f;
+		t = 0.0f;
+	}
+	else if (a <= b2_epsilon)
+	{
+		s = 0.0f;
+		t = b2Clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		float32 c = b2Dot(d1, r);
+		if (e <= b2_epsilon)
+		{
+			t = 0.0f;
+			s = b2Clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			// Parallel segments have no unique closest points, so any s will do.
+			float32 b = b2Dot(d1, d2);
+			float32 denominator = a * e - b * b;
+			s = denominator > 0.0f ? b2Clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = b2Clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = b2Clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	b2Vec2 cA = p1 + s * d1;
+	b2Vec2 cB = r1 + t * d2;
+	float32 distanceSquared = b2DistanceSquared(cA, cB);
+	float32 maxSeparation = radiusA + radiusB + speculativeDistance;
+	if (distanceSquared > maxSeparation * maxSeparation)
+	{
+		return;
+	}
+
+	if (0.0f < s && s < 1.0f)
+	{
+		// The face of A is the reference. Crossing segments push B out on the side
+		// of its center.
+		b2Vec2 normal = b2Cross(d1, 1.0f);
+		normal.Normalize();
+		b2Vec2 side = distanceSquared > b2_epsilon * b2_epsilon ? cB - cA : 0.5f * (r1 + r2) - cA;
+		if (b2Dot(normal, side) < 0.0f)
+		{
+			normal = -normal;
+		}
+
+		manifold->type = b2Manifold::e_faceA;
+		b2ClipSegments(manifold, p1, p2, normal, r1, r2, xf, maxSeparation, false);
+	}
+	else if (0.0f < t && t < 1.0f)
+	{
+		// The face of B is the reference. Put segment A into the frame of B.
+		b2Transform xfBA = b2MulT(xfB, xfA);
+		b2Vec2 w1 = b2Mul(xfBA, p1);
+		b2Vec2 w2 = b2Mul(xfBA, p2);
+
+		b2Vec2 normal = b2Cross(q2 - q1, 1.0f);
+		normal.Normalize();
+		b2Vec2 side = distanceSquared > b2_epsilon * b2_epsilon ? b2MulT(xf.q, cA - cB) : 0.5f * (w1 + w2) - b2MulT(xf, cB);
+		if (b2Dot(normal, side) < 0.0f)
+		{
+			normal = -normal;
+		}
+
+		manifold->type = b2Manifold::e_faceB;
+		b2ClipSegments(manifold, q1, q2, normal, w1, w2, xfBA, maxSeparation, true);
+	}
+	else
+	{
+		// The closest points are end points.
+		int32 indexA = s == 0.0f ? 0 : 1;
+		int32 indexB = t == 0.0f ? 0 : 1;
+
+		manifold->type = b2Manifold::e_circles;
+		manifold->localNormal.SetZero();
+		manifold->localPoint = indexA == 0 ? p1 : p2;
+		manifold->pointCount = 1;
+
+		b2ManifoldPoint* cp = manifold->points + 0;
+		cp->localPoint = indexB == 0 ? q1 : q2;
+		cp->id.cf.indexA = (uint8)indexA;
+		cp->id.cf.indexB = (uint8)indexB;
+		cp->id.cf.typeA = b2ContactFeature::e_vertex;
+		cp->id.cf.typeB = b2ContactFeature::e_vertex;
+	}
+}
+
+void b2CollideCapsules(b2Manifold* manifold,
+					   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+					   const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+					   float32 speculativeDistance)
+{
+	b2CollideSegments(manifold,
+					  capsuleA->m_vertex1, capsuleA->m_vertex2, capsuleA->m_radius, xfA,
+					  capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius, xfB,
+					  speculativeDistance);
+}
+
+void b2CollideEdgeAndCapsule(b2Manifold* manifold,
+							 const b2EdgeShape* edgeA, const b2Transform& xfA,
+							 const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+							 float32 speculativeDistance)
+{
+	b2CollideSegments(manifold,
+					  edgeA->m_vertex1, edgeA->m_vertex2, edgeA->m_radius, xfA,
+					  capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius, xfB,
+					  speculativeDistance);
+}
+
+void b2CollidePolygonAndCapsule(b2Manifold* manifold,
+								const b2PolygonShape* polygonA, const b2Transform& xfA,
+								const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+								float32 speculativeDistance)
+{
+	manifold->pointCount = 0;
+
+	// The distance of the cores tells if a cap touches. Face normals alone would
+	// find a cap near a corner of the polygon closer than it is.
+	b2DistanceInput input;
+	input.proxyA.Set(polygonA, 0);
+	input.proxyB.Set(capsuleB, 0);
+	input.transformA = xfA;
+	input.transformB = xfB;
+	input.useRadii = false;
+
+	b2SimplexCache cache;
+	cache.count = 0;
+
+	b2DistanceOutput output;
+	b2Distance(&output, &cache, &input);
+
+	float32 maxSeparation = polygonA->m_radius + capsuleB->m_radius + speculativeDistance;
+	if (output.distance > maxSeparation)
+	{
+		return;
+	}
+
+	if (cache.count == 1 && output.distance > 0.1f * b2_linearSlop)
+	{
+		// A vertex of the polygon is closest to an end of the capsule.
+		int32 indexA = cache.indexA[0];
+		int32 indexB = cache.indexB[0];
+
+		manifold->type = b2Manifold::e_circles;
+		manifold->localNormal.SetZero();
+		manifold->localPoint = polygonA->m_vertices[indexA];
+		manifold->pointCount = 1;
+
+		b2ManifoldPoint* cp = manifold->points + 0;
+		cp->localPoint = indexB == 0 ? capsuleB->m_vertex1 : capsuleB->m_vertex2;
+		cp->id.cf.indexA = (uint8)indexA;
+		cp->id.cf.indexB = (uint8)indexB;
+		cp->id.cf.typeA = b2ContactFeature::e_vertex;
+		cp->id.cf.typeB = b2ContactFeature::e_vertex;
+		return;
+	}
+
+	// Otherwise a face is involved and the capsule collides like a polygon with two
+	// vertices and its radius.
+	b2Vec2 normal = b2Cross(capsuleB->m_vertex2 - capsuleB->m_vertex1, 1.0f);
+	normal.Normalize();
+
+	b2PolygonShape polygonB;
+	polygonB.m_count = 2;
+	polygonB.m_vertices[0] = capsuleB->m_vertex1;
+	polygonB.m_vertices[1] = capsuleB->m_vertex2;
+	polygonB.m_normals[0] = normal;
+	polygonB.m_normals[1] = -normal;
+	polygonB.m_centroid = 0.5f * (capsuleB->m_vertex1 + capsuleB->m_vertex2);
+	polygonB.m_radius = capsuleB->m_radius;
+
+	b2CollidePolygons(manifold, polygonA, xfA, &polygonB, xfB, speculativeDistance);
+}
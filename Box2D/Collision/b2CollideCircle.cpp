@@ -19,11 +19,13 @@
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Collision/Shapes/b2CircleShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
 
 void b2CollideCircles(
 	b2Manifold* manifold,
 	const b2CircleShape* circleA, const b2Transform& xfA,
-	const b2CircleShape* circleB, const b2Transform& xfB)
+	const b2CircleShape* circleB, const b2Transform& xfB,
+	float32 speculativeDistance)
 {
 	manifold->pointCount = 0;
 
@@ -33,7 +35,7 @@ void b2CollideCircles(
 	b2Vec2 d = pB - pA;
 	float32 distSqr = b2Dot(d, d);
 	float32 rA = circleA->m_radius, rB = circleB->m_radius;
-	float32 radius = rA + rB;
+	float32 radius = rA + rB + speculativeDistance;
 	if (distSqr > radius * radius)
 	{
 		return;
@@ -51,7 +53,8 @@ void b2CollideCircles(
 void b2CollidePolygonAndCircle(
 	b2Manifold* manifold,
 	const b2PolygonShape* polygonA, const b2Transform& xfA,
-	const b2CircleShape* circleB, const b2Transform& xfB)
+	const b2CircleShape* circleB, const b2Transform& xfB,
+	float32 speculativeDistance)
 {
 	manifold->pointCount = 0;
 
@@ -62,7 +65,7 @@ void b2CollidePolygonAndCircle(
 	// Find the min separating edge.
 	int32 normalIndex = 0;
 	float32 separation = -b2_maxFloat;
-	float32 radius = polygonA->m_radius + circleB->m_radius;
+	float32 radius = polygonA->m_radius + circleB->m_radius + speculativeDistance;
 	int32 vertexCount = polygonA->m_count;
 	const b2Vec2* vertices = polygonA->m_vertices;
 	const b2Vec2* normals = polygonA->m_normals;
@@ -152,3 +155,37 @@ void b2CollidePolygonAndCircle(
 		manifold->points[0].id.key = 0;
 	}
 }
+
+void b2CollideDistanceFieldAndCircle(
+	b2Manifold* manifold,
+	const b2DistanceFieldShape* fieldA, const b2Transform& xfA,
+	const b2CircleShape* circleB, const b2Transform& xfB,
+	float32 speculativeDistance)
+{
+	manifold->pointCount = 0;
+
+	// Compute circle position in the frame of the field.
+	b2Vec2 c = b2Mul(xfB, circleB->m_p);
+	b2Vec2 cLocal = b2MulT(xfA, c);
+
+	// The field is clamped to the margin, so nothing is known beyond it.
+	b2Vec2 normal;
+	float32 distance = fieldA->Sample(cLocal, &normal);
+	if (distance >= fieldA->m_margin || distance > circleB->m_radius + speculativeDistance)
+	{
+		return;
+	}
+
+	if (normal.Normalize() < b2_epsilon)
+	{
+		normal.Set(0.0f, 1.0f);
+	}
+
+	// The plane passes through the closest surface point.
+	manifold->pointCount = 1;
+	manifold->type = b2Manifold::e_faceA;
+	manifold->localNormal = normal;
+	manifold->localPoint = cLocal - distance * normal;
+	manifold->points[0].localPoint = circleB->m_p;
+	manifold->points[0].id.key = 0;
+}
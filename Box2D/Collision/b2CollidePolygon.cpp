@@ -19,41 +19,139 @@
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 
+// Separation of poly2 from edge i of poly1. The transform takes poly1 into the frame of poly2.
+static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform& xf, int32 i,
+								const b2PolygonShape* poly2)
+{
+	int32 count2 = poly2->m_count;
+	const b2Vec2* v2s = poly2->m_vertices;
+
+	// Get poly1 normal in frame2.
+	b2Vec2 n = b2Mul(xf.q, poly1->m_normals[i]);
+	b2Vec2 v1 = b2Mul(xf, poly1->m_vertices[i]);
+
+	// Find deepest point for normal i.
+	float32 si = b2_maxFloat;
+	for (int32 j = 0; j < count2; ++j)
+	{
+		float32 sij = b2Dot(n, v2s[j] - v1);
+		if (sij < si)
+		{
+			si = sij;
+		}
+	}
+
+	return si;
+}
+
 // Find the max separation between poly1 and poly2 using edge normals from poly1.
 static float32 b2FindMaxSeparation(int32* edgeIndex,
 								 const b2PolygonShape* poly1, const b2Transform& xf1,
 								 const b2PolygonShape* poly2, const b2Transform& xf2)
 {
 	int32 count1 = poly1->m_count;
-	int32 count2 = poly2->m_count;
-	const b2Vec2* n1s = poly1->m_normals;
-	const b2Vec2* v1s = poly1->m_vertices;
-	const b2Vec2* v2s = poly2->m_vertices;
 	b2Transform xf = b2MulT(xf2, xf1);
 
 	int32 bestIndex = 0;
 	float32 maxSeparation = -b2_maxFloat;
 	for (int32 i = 0; i < count1; ++i)
 	{
-		// Get poly1 normal in frame2.
-		b2Vec2 n = b2Mul(xf.q, n1s[i]);
-		b2Vec2 v1 = b2Mul(xf, v1s[i]);
+		float32 si = b2EdgeSeparation(poly1, xf, i, poly2);
+		if (si > maxSeparation)
+		{
+			maxSeparation = si;
+			bestIndex = i;
+		}
+	}
+
+	*edgeIndex = bestIndex;
+	return maxSeparation;
+}
+
+// The same search started from the edge found by the last call. The separation of an
+// edge is at most that of the centroid of poly2, which rejects most other edges without
+// visiting poly2. Edges that pass are searched by walking to a local maximum first, which
+// raises the bound. Ties go to the lowest index as in the full search, so the result is
+// the same. The transform takes poly1 into the frame of poly2.
+static float32 b2FindMaxSeparation(int32* edgeIndex, b2PolygonCacheResult* result,
+								 const b2PolygonShape* poly1, const b2Transform& xf,
+								 const b2PolygonShape* poly2, int32 hint, float32 hintSeparation)
+{
+	int32 count1 = poly1->m_count;
+	b2Vec2 c2 = poly2->m_centroid;
+
+	// Upper bounds of the other edges. The slop covers round-off.
+	float32 bounds[b2_maxPolygonVertices];
+	bool pass = false;
+	for (int32 i = 0; i < count1; ++i)
+	{
+		b2Vec2 n = b2Mul(xf.q, poly1->m_normals[i]);
+		b2Vec2 v1 = b2Mul(xf, poly1->m_vertices[i]);
+		bounds[i] = b2Dot(n, c2 - v1) + b2_linearSlop;
+		pass = pass || (i != hint && bounds[i] >= hintSeparation);
+	}
+
+	*edgeIndex = hint;
+	*result = b2_polygonCacheHit;
+	if (pass == false)
+	{
+		return hintSeparation;
+	}
+
+	int32 bestIndex = hint;
+	float32 maxSeparation = hintSeparation;
+	uint32 visited = 1u << hint;
+
+	// Climb to a local maximum.
+	for (;;)
+	{
+		int32 prev = bestIndex > 0 ? bestIndex - 1 : count1 - 1;
+		int32 next = bestIndex + 1 < count1 ? bestIndex + 1 : 0;
+		int32 neighbors[2] = {prev, next};
 
-		// Find deepest point for normal i.
-		float32 si = b2_maxFloat;
-		for (int32 j = 0; j < count2; ++j)
+		int32 index = bestIndex;
+		float32 separation = maxSeparation;
+		for (int32 k = 0; k < 2; ++k)
 		{
-			float32 sij = b2Dot(n, v2s[j] - v1);
-			if (sij < si)
+			int32 i = neighbors[k];
+			if ((visited & (1u << i)) || bounds[i] < separation)
+			{
+				continue;
+			}
+
+			visited |= 1u << i;
+			float32 si = b2EdgeSeparation(poly1, xf, i, poly2);
+			if (si > separation || (si == separation && i < index))
 			{
-				si = sij;
+				separation = si;
+				index = i;
 			}
 		}
 
-		if (si > maxSeparation)
+		if (index == bestIndex)
+		{
+			break;
+		}
+
+		bestIndex = index;
+		maxSeparation = separation;
+		*result = b2_polygonCacheClimb;
+	}
+
+	// Search the edges the bound can not reject.
+	for (int32 i = 0; i < count1; ++i)
+	{
+		if ((visited & (1u << i)) || bounds[i] < maxSeparation)
+		{
+			continue;
+		}
+
+		float32 si = b2EdgeSeparation(poly1, xf, i, poly2);
+		if (si > maxSeparation || (si == maxSeparation && i < bestIndex))
 		{
 			maxSeparation = si;
 			bestIndex = i;
+			*result = b2_polygonCacheMiss;
 		}
 	}
 
@@ -61,9 +159,9 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 	return maxSeparation;
 }
 
-static void b2FindIncidentEdge(b2ClipVertex c[2],
+static int32 b2FindIncidentEdge(b2ClipVertex c[2],
 							 const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
-							 const b2PolygonShape* poly2, const b2Transform& xf2)
+							 const b2PolygonShape* poly2, const b2Transform& xf2, int32 hint)
 {
 	const b2Vec2* normals1 = poly1->m_normals;
 
@@ -76,16 +174,32 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 	// Get the normal of the reference edge in poly2's frame.
 	b2Vec2 normal1 = b2MulT(xf2.q, b2Mul(xf1.q, normals1[edge1]));
 
-	// Find the incident edge on poly2.
-	int32 index = 0;
-	float32 minDot = b2_maxFloat;
-	for (int32 i = 0; i < count2; ++i)
+	// Find the incident edge on poly2. The dot product falls and then rises around
+	// the polygon, so a strict local minimum below zero is the minimum.
+	int32 index = -1;
+	if (hint != -1)
+	{
+		int32 prev = hint > 0 ? hint - 1 : count2 - 1;
+		int32 next = hint + 1 < count2 ? hint + 1 : 0;
+		float32 dot = b2Dot(normal1, normals2[hint]);
+		if (dot <= 0.0f && dot < b2Dot(normal1, normals2[prev]) && dot < b2Dot(normal1, normals2[next]))
+		{
+			index = hint;
+		}
+	}
+
+	if (index == -1)
 	{
-		float32 dot = b2Dot(normal1, normals2[i]);
-		if (dot < minDot)
+		index = 0;
+		float32 minDot = b2_maxFloat;
+		for (int32 i = 0; i < count2; ++i)
 		{
-			minDot = dot;
-			index = i;
+			float32 dot = b2Dot(normal1, normals2[i]);
+			if (dot < minDot)
+			{
+				minDot = dot;
+				index = i;
+			}
 		}
 	}
 
@@ -104,6 +218,8 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 	c[1].id.cf.indexB = (uint8)i2;
 	c[1].id.cf.typeA = b2ContactFeature::e_face;
 	c[1].id.cf.typeB = b2ContactFeature::e_vertex;
+
+	return index;
 }
 
 // Find edge normal of max separation on A - return if separating axis is found
@@ -115,20 +231,83 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 // The normal points from 1 to 2
 void b2CollidePolygons(b2Manifold* manifold,
 					  const b2PolygonShape* polyA, const b2Transform& xfA,
-					  const b2PolygonShape* polyB, const b2Transform& xfB)
+					  const b2PolygonShape* polyB, const b2Transform& xfB,
+					  float32 speculativeDistance, b2PolygonCache* cache)
 {
 	manifold->pointCount = 0;
 	float32 totalRadius = polyA->m_radius + polyB->m_radius;
+	float32 maxSeparation = totalRadius + speculativeDistance;
 
 	int32 edgeA = 0;
-	float32 separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
-	if (separationA > totalRadius)
-		return;
-
 	int32 edgeB = 0;
-	float32 separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
-	if (separationB > totalRadius)
-		return;
+	float32 separationA, separationB;
+	int32 incidentHint = -1;
+
+	if (cache && cache->valid && cache->edgeA < polyA->m_count && cache->edgeB < polyB->m_count)
+	{
+
+		// Is the last separating axis still separating?
+		b2Transform xfAB = b2MulT(xfB, xfA);
+		float32 hintSeparationA = b2EdgeSeparation(polyA, xfAB, cache->edgeA, polyB);
+		if (hintSeparationA > maxSeparation)
+		{
+			cache->result = (uint8)b2_polygonCacheHit;
+			return;
+		}
+
+		b2Transform xfBA = b2MulT(xfA, xfB);
+		float32 hintSeparationB = b2EdgeSeparation(polyB, xfBA, cache->edgeB, polyA);
+		if (hintSeparationB > maxSeparation)
+		{
+			cache->result = (uint8)b2_polygonCacheHit;
+			return;
+		}
+
+		b2PolygonCacheResult resultA, resultB;
+		separationA = b2FindMaxSeparation(&edgeA, &resultA, polyA, xfAB, polyB, cache->edgeA, hintSeparationA);
+		cache->edgeA = (uint8)edgeA;
+		if (separationA > maxSeparation)
+		{
+			cache->result = (uint8)resultA;
+			return;
+		}
+
+		separationB = b2FindMaxSeparation(&edgeB, &resultB, polyB, xfBA, polyA, cache->edgeB, hintSeparationB);
+		cache->edgeB = (uint8)edgeB;
+		cache->result = (uint8)b2Max(resultA, resultB);
+
+		if (separationB > maxSeparation)
+		{
+			return;
+		}
+
+		incidentHint = cache->incidentEdge;
+	}
+	else
+	{
+		separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
+		if (cache)
+		{
+			cache->valid = 1;
+			cache->result = (uint8)b2_polygonCacheNone;
+			cache->edgeA = (uint8)edgeA;
+			cache->edgeB = 0;
+			cache->flip = 0;
+			cache->incidentEdge = 0;
+		}
+
+		if (separationA > maxSeparation)
+			return;
+
+		separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
+		if (cache)
+		{
+			cache->edgeB = (uint8)edgeB;
+		}
+
+		if (separationB > maxSeparation)
+			return;
+	}
 
 	const b2PolygonShape* poly1;	// reference polygon
 	const b2PolygonShape* poly2;	// incident polygon
@@ -158,8 +337,19 @@ void b2CollidePolygons(b2Manifold* manifold,
 		flip = 0;
 	}
 
+	if (cache == nullptr || cache->flip != flip || incidentHint >= poly2->m_count)
+	{
+		incidentHint = -1;
+	}
+
 	b2ClipVertex incidentEdge[2];
-	b2FindIncidentEdge(incidentEdge, poly1, xf1, edge1, poly2, xf2);
+	int32 incidentIndex = b2FindIncidentEdge(incidentEdge, poly1, xf1, edge1, poly2, xf2, incidentHint);
+
+	if (cache)
+	{
+		cache->flip = flip;
+		cache->incidentEdge = (uint8)incidentIndex;
+	}
 
 	int32 count1 = poly1->m_count;
 	const b2Vec2* vertices1 = poly1->m_vertices;
@@ -217,7 +407,7 @@ void b2CollidePolygons(b2Manifold* manifold,
 	{
 		float32 separation = b2Dot(normal, clipPoints2[i].v) - frontOffset;
 
-		if (separation <= totalRadius)
+		if (separation <= maxSeparation)
 		{
 			b2ManifoldPoint* cp = manifold->points + pointCount;
 			cp->localPoint = b2MulT(xf2, clipPoints2[i].v);
@@ -233,6 +233,18 @@ int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 					const b2Shape* shapeB, int32 indexB,
 					const b2Transform& xfA, const b2Transform& xfB)
+{
+	b2SimplexCache cache;
+	cache.count = 0;
+
+	int32 iterations;
+	return b2TestOverlap(shapeA, indexA, shapeB, indexB, xfA, xfB, &cache, &iterations);
+}
+
+bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
+					const b2Shape* shapeB, int32 indexB,
+					const b2Transform& xfA, const b2Transform& xfB,
+					b2SimplexCache* cache, int32* iterations)
 {
 	b2DistanceInput input;
 	input.proxyA.Set(shapeA, indexA);
@@ -241,12 +253,10 @@ bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 	input.transformB = xfB;
 	input.useRadii = true;
 
-	b2SimplexCache cache;
-	cache.count = 0;
-
 	b2DistanceOutput output;
 
-	b2Distance(&output, &cache, &input);
+	b2Distance(&output, cache, &input);
 
+	*iterations = output.iterations;
 	return output.distance < 10.0f * b2_epsilon;
 }
@@ -30,6 +30,9 @@ class b2Shape;
 class b2CircleShape;
 class b2EdgeShape;
 class b2PolygonShape;
+class b2CapsuleShape;
+class b2DistanceFieldShape;
+struct b2SimplexCache;
 
 const uint8 b2_nullFeature = UCHAR_MAX;
 
@@ -215,30 +218,92 @@ struct b2AABB
 	b2Vec2 upperBound;	///< the upper vertex
 };
 
+/// How b2CollidePolygons found the separating edges of a pair.
+enum b2PolygonCacheResult
+{
+	b2_polygonCacheNone,	///< the cache was not valid, so all edges were searched
+	b2_polygonCacheHit,		///< the cached edges were still best or still separating
+	b2_polygonCacheClimb,	///< the edges were found by walking to neighbor edges
+	b2_polygonCacheMiss		///< other edges had to be searched
+};
+
+/// Used to warm start b2CollidePolygons. Set valid to zero on first call.
+/// The cache only speeds up the search, the manifold does not depend on it.
+struct b2PolygonCache
+{
+	uint8 valid;
+	uint8 edgeA;		///< edge of polygon A with the largest separation
+	uint8 edgeB;		///< edge of polygon B with the largest separation
+	uint8 flip;			///< 1 if the reference face was on polygon B
+	uint8 incidentEdge;	///< incident edge on the other polygon
+	uint8 result;		///< b2PolygonCacheResult of the last call
+};
+
+// The collide functions also keep points separated by up to speculativeDistance.
+// The solver lets such speculative points approach until they touch.
+
 /// Compute the collision manifold between two circles.
 void b2CollideCircles(b2Manifold* manifold,
 					  const b2CircleShape* circleA, const b2Transform& xfA,
-					  const b2CircleShape* circleB, const b2Transform& xfB);
+					  const b2CircleShape* circleB, const b2Transform& xfB,
+					  float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between a polygon and a circle.
 void b2CollidePolygonAndCircle(b2Manifold* manifold,
 							   const b2PolygonShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
-/// Compute the collision manifold between two polygons.
+/// Compute the collision manifold between two polygons. The optional cache
+/// carries the features found by the last call for the same pair.
 void b2CollidePolygons(b2Manifold* manifold,
 					   const b2PolygonShape* polygonA, const b2Transform& xfA,
-					   const b2PolygonShape* polygonB, const b2Transform& xfB);
+					   const b2PolygonShape* polygonB, const b2Transform& xfB,
+					   float32 speculativeDistance = 0.0f, b2PolygonCache* cache = nullptr);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndCircle(b2Manifold* manifold,
 							   const b2EdgeShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndPolygon(b2Manifold* manifold,
 							   const b2EdgeShape* edgeA, const b2Transform& xfA,
-							   const b2PolygonShape* circleB, const b2Transform& xfB);
+							   const b2PolygonShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
+
+/// Compute the collision manifold between a capsule and a circle.
+void b2CollideCapsuleAndCircle(b2Manifold* manifold,
+							   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
+
+/// Compute the collision manifold between two capsules.
+void b2CollideCapsules(b2Manifold* manifold,
+					   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+					   const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+					   float32 speculativeDistance = 0.0f);
+
+/// Compute the collision manifold between a polygon and a capsule.
+void b2CollidePolygonAndCapsule(b2Manifold* manifold,
+								const b2PolygonShape* polygonA, const b2Transform& xfA,
+								const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+								float32 speculativeDistance = 0.0f);
+
+/// Compute the collision manifold between an edge and a capsule. The edge is
+/// treated as an isolated segment, so edge connectivity is not used.
+void b2CollideEdgeAndCapsule(b2Manifold* manifold,
+							 const b2EdgeShape* edgeA, const b2Transform& xfA,
+							 const b2CapsuleShape* capsuleB, const b2Transform& xfB,
+							 float32 speculativeDistance = 0.0f);
+
+/// Compute the collision manifold between a distance field and a circle. The normal
+/// is the gradient of the field at the circle center.
+void b2CollideDistanceFieldAndCircle(b2Manifold* manifold,
+									 const b2DistanceFieldShape* fieldA, const b2Transform& xfA,
+									 const b2CircleShape* circleB, const b2Transform& xfB,
+									 float32 speculativeDistance = 0.0f);
 
 /// Clipping for contact manifolds.
 int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
@@ -249,6 +314,15 @@ bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 					const b2Shape* shapeB, int32 indexB,
 					const b2Transform& xfA, const b2Transform& xfB);
 
+/// Determine if two generic shapes overlap, warm starting the distance query with a
+/// simplex cache. The cache is input/output as in b2Distance. On the first call set the
+/// count to zero.
+/// @param iterations returns the number of GJK iterations used.
+bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
+					const b2Shape* shapeB, int32 indexB,
+					const b2Transform& xfA, const b2Transform& xfB,
+					b2SimplexCache* cache, int32* iterations);
+
 // ---------------- Inline Functions ------------------------------------------
 
 inline bool b2AABB::IsValid() const
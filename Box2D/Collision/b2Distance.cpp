@@ -21,9 +21,8 @@
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
-
-// GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
-int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
 
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 {
@@ -77,6 +76,27 @@ void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 		}
 		break;
 
+	case b2Shape::e_capsule:
+		{
+			const b2CapsuleShape* capsule = static_cast<const b2CapsuleShape*>(shape);
+			m_vertices = &capsule->m_vertex1;
+			m_count = 2;
+			m_radius = capsule->m_radius;
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			const b2TerrainShape* terrain = static_cast<const b2TerrainShape*>(shape);
+			b2Assert(0 <= index && index < terrain->m_count - 1);
+
+			// The index is a segment, whose vertices are adjacent.
+			m_vertices = terrain->m_vertices + index;
+			m_count = 2;
+			m_radius = terrain->m_radius;
+		}
+		break;
+
 	default:
 		b2Assert(false);
 	}
@@ -447,12 +467,11 @@ void b2Simplex::Solve3()
 	m_count = 3;
 }
 
+// GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
 void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
-
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
 
@@ -533,7 +552,6 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -556,8 +574,6 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
-
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
 	output->distance = b2Distance(output->pointA, output->pointB);
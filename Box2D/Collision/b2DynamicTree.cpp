@@ -17,15 +17,18 @@
 */
 
 #include "Box2D/Collision/b2DynamicTree.h"
+#include <algorithm>
 #include <string.h>
 
-b2DynamicTree::b2DynamicTree()
+b2DynamicTree::b2DynamicTree(b2AllocatorInterface* allocator)
 {
+	m_allocator = allocator;
+
 	m_root = b2_nullNode;
 
 	m_nodeCapacity = 16;
 	m_nodeCount = 0;
-	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
 	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
 
 	// Build a linked list for the free list.
@@ -38,15 +41,55 @@ b2DynamicTree::b2DynamicTree()
 	m_nodes[m_nodeCapacity-1].height = -1;
 	m_freeList = 0;
 
+	m_proxyCapacity = 16;
+	m_proxyCount = 0;
+	m_proxies = (b2TreeProxy*)b2Alloc(m_allocator, m_proxyCapacity * sizeof(b2TreeProxy), b2_treeMemory);
+	memset(m_proxies, 0, m_proxyCapacity * sizeof(b2TreeProxy));
+
+	// Build a linked list for the proxy free list.
+	for (int32 i = 0; i < m_proxyCapacity - 1; ++i)
+	{
+		m_proxies[i].next = i + 1;
+	}
+	m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+	m_proxyFreeList = 0;
+
 	m_path = 0;
 
 	m_insertionCount = 0;
+	m_reinsertCount = 0;
+
+	m_minExtension = b2_minAABBExtension;
+	m_maxExtension = b2_maxAABBExtension;
 }
 
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	b2Free(m_allocator, m_nodes, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
+	b2Free(m_allocator, m_proxies, m_proxyCapacity * sizeof(b2TreeProxy), b2_treeMemory);
+}
+
+void b2DynamicTree::Clear()
+{
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		m_nodes[i].next = i + 1 < m_nodeCapacity ? i + 1 : b2_nullNode;
+		m_nodes[i].height = -1;
+	}
+	m_freeList = 0;
+
+	m_proxyCount = 0;
+	memset(m_proxies, 0, m_proxyCapacity * sizeof(b2TreeProxy));
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].next = i + 1 < m_proxyCapacity ? i + 1 : b2_nullNode;
+	}
+	m_proxyFreeList = 0;
+
+	m_path = 0;
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -60,9 +103,9 @@ int32 b2DynamicTree::AllocateNode()
 		// The free list is empty. Rebuild a bigger pool.
 		b2TreeNode* oldNodes = m_nodes;
 		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+		m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
+		b2Free(m_allocator, oldNodes, m_nodeCount * sizeof(b2TreeNode), b2_treeMemory);
 
 		// Build a linked list for the free list. The parent
 		// pointer becomes the "next" pointer.
@@ -83,7 +126,6 @@ int32 b2DynamicTree::AllocateNode()
 	m_nodes[nodeId].child1 = b2_nullNode;
 	m_nodes[nodeId].child2 = b2_nullNode;
 	m_nodes[nodeId].height = 0;
-	m_nodes[nodeId].userData = nullptr;
 	++m_nodeCount;
 	return nodeId;
 }
@@ -99,50 +141,144 @@ void b2DynamicTree::FreeNode(int32 nodeId)
 	--m_nodeCount;
 }
 
-// Create a proxy in the tree as a leaf node. We return the index
-// of the node instead of a pointer so that we can grow
+// Allocate a proxy from the pool. Grow the pool if necessary.
+int32 b2DynamicTree::AllocateProxy()
+{
+	if (m_proxyFreeList == b2_nullNode)
+	{
+		b2Assert(m_proxyCount == m_proxyCapacity);
+
+		// The free list is empty. Rebuild a bigger pool.
+		b2TreeProxy* oldProxies = m_proxies;
+		m_proxyCapacity *= 2;
+		m_proxies = (b2TreeProxy*)b2Alloc(m_allocator, m_proxyCapacity * sizeof(b2TreeProxy), b2_treeMemory);
+		memcpy(m_proxies, oldProxies, m_proxyCount * sizeof(b2TreeProxy));
+		b2Free(m_allocator, oldProxies, m_proxyCount * sizeof(b2TreeProxy), b2_treeMemory);
+
+		for (int32 i = m_proxyCount; i < m_proxyCapacity - 1; ++i)
+		{
+			m_proxies[i].next = i + 1;
+		}
+		m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+		m_proxyFreeList = m_proxyCount;
+	}
+
+	int32 proxyId = m_proxyFreeList;
+	m_proxyFreeList = m_proxies[proxyId].next;
+	m_proxies[proxyId].node = b2_nullNode;
+	m_proxies[proxyId].userData = nullptr;
+	m_proxies[proxyId].extension = 0.0f;
+	m_proxies[proxyId].displacement = 0.0f;
+	++m_proxyCount;
+	return proxyId;
+}
+
+// Return a proxy to the pool.
+void b2DynamicTree::FreeProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(0 < m_proxyCount);
+	m_proxies[proxyId].next = m_proxyFreeList;
+	m_proxies[proxyId].userData = nullptr;
+	m_proxyFreeList = proxyId;
+	--m_proxyCount;
+}
+
+// Create a proxy in the tree as a leaf node. We return the proxy id
+// instead of a pointer so that we can grow and reorder
 // the node pool.
 int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 {
-	int32 proxyId = AllocateNode();
+	int32 proxyId = CreateLeaf(aabb, userData);
+	InsertLeaf(m_proxies[proxyId].node);
+	return proxyId;
+}
+
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		proxyIds[i] = CreateLeaf(aabbs[i], userData[i]);
+	}
+
+	// Inserting costs O(log n) per proxy and rebuilding O(n log n) for the tree.
+	if (count < m_proxyCount - count)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			InsertLeaf(m_proxies[proxyIds[i]].node);
+		}
+		return;
+	}
+
+	RebuildTopDown();
+}
+
+// Allocate a proxy and its leaf without inserting the leaf in the tree.
+int32 b2DynamicTree::CreateLeaf(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = AllocateProxy();
+	int32 leaf = AllocateNode();
 
-	// Fatten the aabb.
-	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
-	m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
-	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
-	m_nodes[proxyId].userData = userData;
-	m_nodes[proxyId].height = 0;
+	// Fatten the aabb. There is no displacement history yet.
+	float32 extension = b2Clamp(b2_aabbExtension, m_minExtension, m_maxExtension);
+	b2Vec2 r(extension, extension);
+	m_nodes[leaf].aabb.lowerBound = aabb.lowerBound - r;
+	m_nodes[leaf].aabb.upperBound = aabb.upperBound + r;
+	m_nodes[leaf].proxyId = proxyId;
+	m_nodes[leaf].height = 0;
 
-	InsertLeaf(proxyId);
+	m_proxies[proxyId].node = leaf;
+	m_proxies[proxyId].userData = userData;
+	m_proxies[proxyId].extension = extension;
 
 	return proxyId;
 }
 
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
-	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
-	b2Assert(m_nodes[proxyId].IsLeaf());
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	int32 leaf = m_proxies[proxyId].node;
+	b2Assert(m_nodes[leaf].IsLeaf());
 
-	RemoveLeaf(proxyId);
-	FreeNode(proxyId);
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	FreeProxy(proxyId);
 }
 
 bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
-
-	b2Assert(m_nodes[proxyId].IsLeaf());
-
-	if (m_nodes[proxyId].aabb.Contains(aabb))
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+
+	b2TreeProxy* proxy = m_proxies + proxyId;
+	int32 leaf = proxy->node;
+	b2Assert(m_nodes[leaf].IsLeaf());
+
+	// Track the recent displacement with a decaying peak. This keeps fast
+	// bouncing proxies from shrinking between impacts.
+	float32 distance = b2Max(b2Abs(displacement.x), b2Abs(displacement.y));
+	proxy->displacement = b2Max(distance, 0.9f * proxy->displacement);
+
+	// Size the extension to absorb several steps of recent displacement
+	// plus a small fraction of the proxy size.
+	b2Vec2 h = aabb.GetExtents();
+	float32 extension = b2_aabbSizeRatio * b2Min(h.x, h.y) + b2_aabbDisplacementSteps * proxy->displacement;
+	extension = b2Clamp(extension, m_minExtension, m_maxExtension);
+
+	// Keep the fat AABB unless the proxy left it or slowed down enough that the
+	// margin only produces extra pairs, e.g. a fast body that came to rest.
+	if (m_nodes[leaf].aabb.Contains(aabb) && extension > b2_aabbShrinkRatio * proxy->extension)
 	{
 		return false;
 	}
 
-	RemoveLeaf(proxyId);
+	RemoveLeaf(leaf);
+
+	proxy->extension = extension;
 
 	// Extend AABB.
 	b2AABB b = aabb;
-	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b2Vec2 r(extension, extension);
 	b.lowerBound = b.lowerBound - r;
 	b.upperBound = b.upperBound + r;
 
@@ -167,12 +303,20 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 		b.upperBound.y += d.y;
 	}
 
-	m_nodes[proxyId].aabb = b;
+	m_nodes[leaf].aabb = b;
 
-	InsertLeaf(proxyId);
+	InsertLeaf(leaf);
+	++m_reinsertCount;
 	return true;
 }
 
+void b2DynamicTree::SetExtensionLimits(float32 minExtension, float32 maxExtension)
+{
+	b2Assert(0.0f <= minExtension && minExtension <= maxExtension);
+	m_minExtension = minExtension;
+	m_maxExtension = maxExtension;
+}
+
 void b2DynamicTree::InsertLeaf(int32 leaf)
 {
 	++m_insertionCount;
@@ -261,7 +405,6 @@ void b2DynamicTree::InsertLeaf(int32 leaf)
 	int32 oldParent = m_nodes[sibling].parent;
 	int32 newParent = AllocateNode();
 	m_nodes[newParent].parent = oldParent;
-	m_nodes[newParent].userData = nullptr;
 	m_nodes[newParent].aabb.Combine(leafAABB, m_nodes[sibling].aabb);
 	m_nodes[newParent].height = m_nodes[sibling].height + 1;
 
@@ -595,8 +738,8 @@ void b2DynamicTree::ValidateStructure(int32 index) const
 
 	if (node->IsLeaf())
 	{
-		b2Assert(child1 == b2_nullNode);
-		b2Assert(child2 == b2_nullNode);
+		b2Assert(0 <= node->proxyId && node->proxyId < m_proxyCapacity);
+		b2Assert(m_proxies[node->proxyId].node == index);
 		b2Assert(node->height == 0);
 		return;
 	}
@@ -625,8 +768,6 @@ void b2DynamicTree::ValidateMetrics(int32 index) const
 
 	if (node->IsLeaf())
 	{
-		b2Assert(child1 == b2_nullNode);
-		b2Assert(child2 == b2_nullNode);
 		b2Assert(node->height == 0);
 		return;
 	}
@@ -668,6 +809,17 @@ void b2DynamicTree::Validate() const
 	b2Assert(GetHeight() == ComputeHeight());
 
 	b2Assert(m_nodeCount + freeCount == m_nodeCapacity);
+
+	int32 freeProxyCount = 0;
+	int32 freeProxy = m_proxyFreeList;
+	while (freeProxy != b2_nullNode)
+	{
+		b2Assert(0 <= freeProxy && freeProxy < m_proxyCapacity);
+		freeProxy = m_proxies[freeProxy].next;
+		++freeProxyCount;
+	}
+
+	b2Assert(m_proxyCount + freeProxyCount == m_proxyCapacity);
 #endif
 }
 
@@ -695,7 +847,8 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
-	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 nodesSize = m_nodeCount * sizeof(int32);
+	int32* nodes = (int32*)b2Alloc(m_allocator, nodesSize, b2_treeMemory);
 	int32 count = 0;
 
 	// Build array of leaves. Free the rest.
@@ -764,11 +917,527 @@ void b2DynamicTree::RebuildBottomUp()
 	}
 
 	m_root = nodes[0];
-	b2Free(nodes);
+	b2Free(m_allocator, nodes, nodesSize, b2_treeMemory);
 
 	Validate();
 }
 
+// Orders build items by their center along an axis.
+struct b2TreeBuildItemLess
+{
+	bool operator()(const b2TreeBuildItem& a, const b2TreeBuildItem& b) const
+	{
+		return a.center(axis) < b.center(axis);
+	}
+
+	int32 axis;
+};
+
+void b2DynamicTree::RebuildTopDown()
+{
+	int32 itemsSize = m_nodeCount * sizeof(b2TreeBuildItem);
+	b2TreeBuildItem* items = (b2TreeBuildItem*)b2Alloc(m_allocator, itemsSize, b2_treeMemory);
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest. Leaves that were never inserted are
+	// picked up as well.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			items[count].center = m_nodes[i].aabb.GetCenter();
+			items[count].node = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = b2_nullNode;
+	if (count > 0)
+	{
+		m_root = BuildTopDown(items, count);
+		m_nodes[m_root].parent = b2_nullNode;
+	}
+
+	b2Free(m_allocator, items, itemsSize, b2_treeMemory);
+}
+
+// Build a sub-tree over the items and return its root. The centers are copied into
+// the items so that partitioning does not touch the node pool.
+int32 b2DynamicTree::BuildTopDown(b2TreeBuildItem* items, int32 count)
+{
+	if (count == 1)
+	{
+		return items[0].node;
+	}
+
+	// Split along the longest axis of the box around the centers.
+	b2Vec2 lower = items[0].center;
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, items[i].center);
+		upper = b2Max(upper, items[i].center);
+	}
+
+	b2TreeBuildItemLess less;
+	less.axis = upper.x - lower.x >= upper.y - lower.y ? 0 : 1;
+
+	int32 half = count / 2;
+	std::nth_element(items, items + half, items + count, less);
+
+	int32 child1 = BuildTopDown(items, half);
+	int32 child2 = BuildTopDown(items + half, count - half);
+
+	// Parents are allocated after their children, so the pool may have grown.
+	int32 parent = AllocateNode();
+	m_nodes[parent].child1 = child1;
+	m_nodes[parent].child2 = child2;
+	m_nodes[parent].height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+	m_nodes[parent].aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	m_nodes[child1].parent = parent;
+	m_nodes[child2].parent = parent;
+	return parent;
+}
+
+// Lay out the top levels of a sub-tree recursively: the upper half of the levels
+// first, followed by each sub-tree hanging below it.
+void b2DynamicTree::LayoutVanEmdeBoas(int32 root, int32 levels, int32* order, int32* count) const
+{
+	if (levels == 1 || m_nodes[root].IsLeaf())
+	{
+		order[(*count)++] = root;
+		return;
+	}
+
+	int32 topLevels = levels / 2;
+	int32 bottomLevels = levels - topLevels;
+
+	LayoutVanEmdeBoas(root, topLevels, order, count);
+
+	b2GrowableStack<int32, 64> stack;
+	b2GrowableStack<int32, 64> depths;
+	stack.Push(root);
+	depths.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 index = stack.Pop();
+		int32 depth = depths.Pop();
+
+		if (depth == topLevels)
+		{
+			LayoutVanEmdeBoas(index, bottomLevels, order, count);
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + index;
+		if (node->IsLeaf())
+		{
+			continue;
+		}
+
+		// Push child2 first so that child1 is laid out first.
+		stack.Push(node->child2);
+		depths.Push(depth + 1);
+		stack.Push(node->child1);
+		depths.Push(depth + 1);
+	}
+}
+
+void b2DynamicTree::Reorder(b2TreeLayout layout)
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	// Gather the old node indices in their new order.
+	int32* order = (int32*)b2Alloc(m_allocator, m_nodeCount * sizeof(int32), b2_treeMemory);
+	int32 count = 0;
+
+	if (layout == b2_vanEmdeBoasLayout)
+	{
+		LayoutVanEmdeBoas(m_root, m_nodes[m_root].height + 1, order, &count);
+	}
+	else
+	{
+		b2GrowableStack<int32, 256> stack;
+		stack.Push(m_root);
+		while (stack.GetCount() > 0)
+		{
+			int32 index = stack.Pop();
+			order[count++] = index;
+
+			const b2TreeNode* node = m_nodes + index;
+			if (node->IsLeaf() == false)
+			{
+				stack.Push(node->child2);
+				stack.Push(node->child1);
+			}
+		}
+	}
+
+	b2Assert(count == m_nodeCount);
+
+	int32* remap = (int32*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(int32), b2_treeMemory);
+	for (int32 i = 0; i < count; ++i)
+	{
+		remap[order[i]] = i;
+	}
+
+	// Copy the nodes into a new pool and fix up the links.
+	b2TreeNode* nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2TreeNode* node = nodes + i;
+		*node = m_nodes[order[i]];
+
+		if (node->parent != b2_nullNode)
+		{
+			node->parent = remap[node->parent];
+		}
+
+		if (node->IsLeaf())
+		{
+			m_proxies[node->proxyId].node = i;
+		}
+		else
+		{
+			node->child1 = remap[node->child1];
+			node->child2 = remap[node->child2];
+		}
+	}
+
+	// The free nodes go at the end.
+	for (int32 i = count; i < m_nodeCapacity; ++i)
+	{
+		nodes[i].next = i + 1 < m_nodeCapacity ? i + 1 : b2_nullNode;
+		nodes[i].height = -1;
+	}
+	m_freeList = count < m_nodeCapacity ? count : b2_nullNode;
+
+	m_root = remap[m_root];
+
+	b2Free(m_allocator, m_nodes, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
+	m_nodes = nodes;
+
+	b2Free(m_allocator, remap, m_nodeCapacity * sizeof(int32), b2_treeMemory);
+	b2Free(m_allocator, order, m_nodeCount * sizeof(int32), b2_treeMemory);
+
+	Validate();
+}
+
+void b2DynamicTree::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_root);
+	writer->Write(m_nodeCount);
+	writer->Write(m_nodeCapacity);
+	writer->Write(m_freeList);
+	writer->Write(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+
+	writer->Write(m_proxyCount);
+	writer->Write(m_proxyCapacity);
+	writer->Write(m_proxyFreeList);
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		const b2TreeProxy* proxy = m_proxies + i;
+		writer->Write(proxy->node);
+		writer->Write(proxy->extension);
+		writer->Write(proxy->displacement);
+	}
+
+	writer->Write(m_path);
+}
+
+// A tree state in a read buffer. The pools are not aligned in the buffer,
+// so nodes and proxies are copied out one at a time.
+struct b2TreeState
+{
+	b2TreeNode GetNode(int32 index) const
+	{
+		b2TreeNode node;
+		memcpy(&node, nodes + index * sizeof(b2TreeNode), sizeof(b2TreeNode));
+		return node;
+	}
+
+	// The proxy pool is written as { node, extension, displacement }.
+	int32 GetProxyNode(int32 proxyId) const
+	{
+		int32 node;
+		memcpy(&node, proxies + proxyId * b2_proxyStateSize, sizeof(int32));
+		return node;
+	}
+
+	bool IsProxy(int32 proxyId) const
+	{
+		int32 node = GetProxyNode(proxyId);
+		if (node < 0 || nodeCapacity <= node)
+		{
+			return false;
+		}
+
+		b2TreeNode leaf = GetNode(node);
+		return leaf.height == 0 && leaf.proxyId == proxyId;
+	}
+
+	static const int32 b2_proxyStateSize = sizeof(int32) + 2 * sizeof(float32);
+
+	int32 root;
+	int32 nodeCount;
+	int32 nodeCapacity;
+	int32 freeList;
+	const uint8* nodes;
+
+	int32 proxyCount;
+	int32 proxyCapacity;
+	int32 proxyFreeList;
+	const uint8* proxies;
+
+	uint32 path;
+};
+
+// Read a state written by WriteState and check that it is a well formed tree.
+// Every node must be in the tree or on the free list and every proxy must be
+// a leaf or on the proxy free list, so that the pools can be used as they are.
+static bool b2ReadTreeState(b2BinaryReader* reader, b2TreeState* state)
+{
+	reader->Read(&state->root);
+	reader->Read(&state->nodeCount);
+	reader->Read(&state->nodeCapacity);
+	reader->Read(&state->freeList);
+
+	int32 remaining = reader->GetSize() - reader->GetPosition();
+	if (reader->IsValid() == false ||
+		state->nodeCapacity <= 0 || remaining / int32(sizeof(b2TreeNode)) < state->nodeCapacity ||
+		state->nodeCount < 0 || state->nodeCapacity < state->nodeCount)
+	{
+		return false;
+	}
+
+	state->nodes = (const uint8*)reader->Skip(state->nodeCapacity * sizeof(b2TreeNode));
+
+	reader->Read(&state->proxyCount);
+	reader->Read(&state->proxyCapacity);
+	reader->Read(&state->proxyFreeList);
+
+	remaining = reader->GetSize() - reader->GetPosition();
+	if (reader->IsValid() == false ||
+		state->proxyCapacity <= 0 || remaining / b2TreeState::b2_proxyStateSize < state->proxyCapacity ||
+		state->proxyCount < 0 || state->proxyCapacity < state->proxyCount)
+	{
+		return false;
+	}
+
+	state->proxies = (const uint8*)reader->Skip(state->proxyCapacity * b2TreeState::b2_proxyStateSize);
+	reader->Read(&state->path);
+	if (reader->IsValid() == false)
+	{
+		return false;
+	}
+
+	// Walk the tree from the root. Each child must point back at its parent,
+	// so no node is reached twice.
+	int32 visitCount = 0;
+	int32 leafCount = 0;
+	if (state->root != b2_nullNode)
+	{
+		if (state->root < 0 || state->nodeCapacity <= state->root ||
+			state->GetNode(state->root).parent != b2_nullNode)
+		{
+			return false;
+		}
+
+		b2GrowableStack<int32, 256> stack;
+		stack.Push(state->root);
+		while (stack.GetCount() > 0)
+		{
+			int32 nodeId = stack.Pop();
+			b2TreeNode node = state->GetNode(nodeId);
+
+			++visitCount;
+			if (visitCount > state->nodeCount)
+			{
+				return false;
+			}
+
+			if (node.IsLeaf())
+			{
+				if (node.height != 0 ||
+					node.proxyId < 0 || state->proxyCapacity <= node.proxyId ||
+					state->GetProxyNode(node.proxyId) != nodeId)
+				{
+					return false;
+				}
+
+				++leafCount;
+				continue;
+			}
+
+			if (node.height <= 0 ||
+				node.child1 < 0 || state->nodeCapacity <= node.child1 ||
+				node.child2 < 0 || state->nodeCapacity <= node.child2 ||
+				state->GetNode(node.child1).parent != nodeId ||
+				state->GetNode(node.child2).parent != nodeId)
+			{
+				return false;
+			}
+
+			stack.Push(node.child1);
+			stack.Push(node.child2);
+		}
+	}
+
+	if (visitCount != state->nodeCount || leafCount != state->proxyCount)
+	{
+		return false;
+	}
+
+	// The free lists must hold exactly the rest of each pool.
+	int32 freeId = state->freeList;
+	for (int32 i = state->nodeCount; i < state->nodeCapacity; ++i)
+	{
+		if (freeId < 0 || state->nodeCapacity <= freeId)
+		{
+			return false;
+		}
+
+		b2TreeNode node = state->GetNode(freeId);
+		if (node.height != -1)
+		{
+			return false;
+		}
+
+		freeId = node.next;
+	}
+
+	if (freeId != b2_nullNode)
+	{
+		return false;
+	}
+
+	freeId = state->proxyFreeList;
+	for (int32 i = state->proxyCount; i < state->proxyCapacity; ++i)
+	{
+		if (freeId < 0 || state->proxyCapacity <= freeId || state->IsProxy(freeId))
+		{
+			return false;
+		}
+
+		freeId = state->GetProxyNode(freeId);
+	}
+
+	return freeId == b2_nullNode;
+}
+
+bool b2DynamicTree::CheckState(b2BinaryReader* reader, bool sameProxies) const
+{
+	b2TreeState state;
+	if (b2ReadTreeState(reader, &state) == false)
+	{
+		return false;
+	}
+
+	if (sameProxies == false)
+	{
+		return true;
+	}
+
+	if (state.proxyCount != m_proxyCount)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < state.proxyCapacity; ++i)
+	{
+		if (state.IsProxy(i) && IsProxy(i) == false)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool b2DynamicTree::ReadState(b2BinaryReader* reader)
+{
+	b2TreeState state;
+	if (b2ReadTreeState(reader, &state) == false)
+	{
+		return false;
+	}
+
+	m_root = state.root;
+	m_nodeCount = state.nodeCount;
+	m_freeList = state.freeList;
+
+	if (state.nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_allocator, m_nodes, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
+		m_nodeCapacity = state.nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_treeMemory);
+	}
+
+	memcpy(m_nodes, state.nodes, m_nodeCapacity * sizeof(b2TreeNode));
+
+	m_proxyCount = state.proxyCount;
+	m_proxyFreeList = state.proxyFreeList;
+
+	if (state.proxyCapacity != m_proxyCapacity)
+	{
+		// Carry the user data over to the new pool.
+		b2TreeProxy* oldProxies = m_proxies;
+		m_proxies = (b2TreeProxy*)b2Alloc(m_allocator, state.proxyCapacity * sizeof(b2TreeProxy), b2_treeMemory);
+		memset(m_proxies, 0, state.proxyCapacity * sizeof(b2TreeProxy));
+		int32 count = b2Min(state.proxyCapacity, m_proxyCapacity);
+		for (int32 i = 0; i < count; ++i)
+		{
+			m_proxies[i].userData = oldProxies[i].userData;
+		}
+		b2Free(m_allocator, oldProxies, m_proxyCapacity * sizeof(b2TreeProxy), b2_treeMemory);
+		m_proxyCapacity = state.proxyCapacity;
+	}
+
+	const uint8* data = state.proxies;
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		b2TreeProxy* proxy = m_proxies + i;
+		memcpy(&proxy->node, data, sizeof(int32));
+		memcpy(&proxy->extension, data + sizeof(int32), sizeof(float32));
+		memcpy(&proxy->displacement, data + sizeof(int32) + sizeof(float32), sizeof(float32));
+		data += b2TreeState::b2_proxyStateSize;
+	}
+
+	m_path = state.path;
+	return true;
+}
+
+bool b2DynamicTree::IsProxy(int32 proxyId) const
+{
+	if (proxyId < 0 || m_proxyCapacity <= proxyId)
+	{
+		return false;
+	}
+
+	int32 node = m_proxies[proxyId].node;
+	if (node < 0 || m_nodeCapacity <= node)
+	{
+		return false;
+	}
+
+	const b2TreeNode* leaf = m_nodes + node;
+	return leaf->height == 0 && leaf->proxyId == proxyId;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
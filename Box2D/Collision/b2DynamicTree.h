@@ -21,10 +21,14 @@
 
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Common/b2GrowableStack.h"
+#include "Box2D/Common/b2AllocatorInterface.h"
+#include "Box2D/Common/b2BinaryStream.h"
 
 #define b2_nullNode (-1)
 
 /// A node in the dynamic tree. The client does not interact with this directly.
+/// This holds only the data touched by traversals so that a node fits in half a
+/// cache line. Per proxy data lives in b2TreeProxy.
 struct b2TreeNode
 {
 	bool IsLeaf() const
@@ -35,8 +39,6 @@ struct b2TreeNode
 	/// Enlarged AABB
 	b2AABB aabb;
 
-	void* userData;
-
 	union
 	{
 		int32 parent;
@@ -44,25 +46,67 @@ struct b2TreeNode
 	};
 
 	int32 child1;
-	int32 child2;
+
+	union
+	{
+		int32 child2;
+		int32 proxyId;	// leaves only
+	};
 
 	// leaf = 0, free node = -1
 	int32 height;
 };
 
+/// Proxy data stored apart from the tree nodes. Proxy ids index this pool and stay
+/// valid when the nodes are reordered. The client does not interact with this directly.
+struct b2TreeProxy
+{
+	union
+	{
+		int32 node;
+		int32 next;
+	};
+
+	void* userData;
+
+	/// Extension of the fat AABB
+	float32 extension;
+
+	/// Decaying peak of the per-step displacement
+	float32 displacement;
+};
+
+/// Memory layouts for b2DynamicTree::Reorder.
+enum b2TreeLayout
+{
+	b2_depthFirstLayout,
+	b2_vanEmdeBoasLayout
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
-/// with an AABB. In the tree we expand the proxy AABB by b2_fatAABBFactor
+/// with an AABB. In the tree we expand the proxy AABB by an extension
 /// so that the proxy AABB is bigger than the client object. This allows the client
 /// object to move by small amounts without triggering a tree update.
+/// The extension adapts per proxy to its size and recent displacement.
 ///
 /// Nodes are pooled and relocatable, so we use node indices rather than pointers.
+/// A leaf and the center of its box, used to build a tree top-down.
+struct b2TreeBuildItem
+{
+	b2Vec2 center;
+	int32 node;
+};
+
+/// Proxy ids map to nodes through an indirection table so the node pool can be
+/// reordered for cache locality without invalidating proxy ids.
 class b2DynamicTree
 {
 public:
-	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// Constructing the tree initializes the node pool. The pools come
+	/// from the optional allocator interface as b2_treeMemory.
+	b2DynamicTree(b2AllocatorInterface* allocator = nullptr);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -70,6 +114,12 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create many proxies at once. A batch that is small next to the tree is
+	/// inserted one proxy at a time. Otherwise the whole tree is rebuilt top-down,
+	/// which is much faster than inserting each proxy.
+	/// @param proxyIds receives the proxy ids in order
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
@@ -79,6 +129,12 @@ public:
 	/// @return true if the proxy was re-inserted.
 	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
 
+	/// Set proxy user data.
+	void SetUserData(int32 proxyId, void* userData);
+
+	/// Get the number of proxies.
+	int32 GetProxyCount() const;
+
 	/// Get proxy user data.
 	/// @return the proxy user data or 0 if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
@@ -86,6 +142,13 @@ public:
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
+	/// Set the limits of the adaptive fat AABB extension. This applies to
+	/// proxies as they are re-inserted.
+	void SetExtensionLimits(float32 minExtension, float32 maxExtension);
+
+	/// Get the number of proxies re-inserted by MoveProxy since construction.
+	int32 GetReinsertCount() const;
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
@@ -118,16 +181,51 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build a tree by splitting the proxies at the median along the longest axis.
+	/// This is O(n log n) and usually gives a better tree than incremental insertion.
+	void RebuildTopDown();
+
+	/// Move the nodes in memory so that traversals walk the pool mostly forward.
+	/// Proxy ids are preserved. This is O(n), so call it during quiet frames.
+	void Reorder(b2TreeLayout layout);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Destroy all proxies at once. The pools are kept.
+	void Clear();
+
+	/// Write the node and proxy pools. User data is not written.
+	void WriteState(b2BinaryWriter* writer) const;
+
+	/// Check a state written by WriteState and skip past it. The tree is not changed.
+	/// @param sameProxies also require the state to use the proxy ids of this tree
+	/// @return false if the state is not a well formed tree
+	bool CheckState(b2BinaryReader* reader, bool sameProxies) const;
+
+	/// Replace the pools with ones written by WriteState. The user data of
+	/// each proxy id is kept, so the tree must hold the same proxy ids.
+	/// @return false and leave the tree unchanged if the state is not a well formed tree
+	bool ReadState(b2BinaryReader* reader);
+
+	/// Is this a proxy id in use? Any value may be passed.
+	bool IsProxy(int32 proxyId) const;
+
 private:
 
 	int32 AllocateNode();
 	void FreeNode(int32 node);
 
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	int32 CreateLeaf(const b2AABB& aabb, void* userData);
+	int32 BuildTopDown(b2TreeBuildItem* items, int32 count);
+
+	void LayoutVanEmdeBoas(int32 root, int32 levels, int32* order, int32* count) const;
+
 	void InsertLeaf(int32 node);
 	void RemoveLeaf(int32 node);
 
@@ -139,6 +237,8 @@ private:
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	b2AllocatorInterface* m_allocator;
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
@@ -147,22 +247,48 @@ private:
 
 	int32 m_freeList;
 
+	b2TreeProxy* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+
+	int32 m_proxyFreeList;
+
 	/// This is used to incrementally traverse the tree for re-balancing.
 	uint32 m_path;
 
 	int32 m_insertionCount;
+	int32 m_reinsertCount;
+
+	float32 m_minExtension;
+	float32 m_maxExtension;
 };
 
+inline void b2DynamicTree::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	m_proxies[proxyId].userData = userData;
+}
+
+inline int32 b2DynamicTree::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 {
-	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
-	return m_nodes[proxyId].userData;
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
 }
 
 inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 {
-	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
-	return m_nodes[proxyId].aabb;
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_nodes[m_proxies[proxyId].node].aabb;
+}
+
+inline int32 b2DynamicTree::GetReinsertCount() const
+{
+	return m_reinsertCount;
 }
 
 template <typename T>
@@ -185,7 +311,7 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 		{
 			if (node->IsLeaf())
 			{
-				bool proceed = callback->QueryCallback(nodeId);
+				bool proceed = callback->QueryCallback(node->proxyId);
 				if (proceed == false)
 				{
 					return;
@@ -261,7 +387,7 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 			subInput.p2 = input.p2;
 			subInput.maxFraction = maxFraction;
 
-			float32 value = callback->RayCastCallback(subInput, nodeId);
+			float32 value = callback->RayCastCallback(subInput, node->proxyId);
 
 			if (value == 0.0f)
 			{
@@ -20,15 +20,11 @@
 #include "Box2D/Collision/b2Distance.h"
 #include "Box2D/Collision/b2TimeOfImpact.h"
 #include "Box2D/Collision/Shapes/b2CircleShape.h"
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
-#include "Box2D/Common/b2Timer.h"
 
 #include <stdio.h>
 
-float32 b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-int32 b2_toiRootIters, b2_toiMaxRootIters;
-
 //
 struct b2SeparationFunction
 {
@@ -253,12 +249,19 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	b2Timer timer;
-
-	++b2_toiCalls;
+	b2SimplexCache cache;
+	cache.count = 0;
+	b2TimeOfImpact(output, input, &cache);
+}
 
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache)
+{
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
+	output->iterations = 0;
+	output->rootIterations = 0;
+	output->distanceCalls = 0;
+	output->distanceIterations = 0;
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -283,8 +286,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 	int32 iter = 0;
 
 	// Prepare input for distance query.
-	b2SimplexCache cache;
-	cache.count = 0;
 	b2DistanceInput distanceInput;
 	distanceInput.proxyA = input->proxyA;
 	distanceInput.proxyB = input->proxyB;
@@ -303,7 +304,9 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		distanceInput.transformA = xfA;
 		distanceInput.transformB = xfB;
 		b2DistanceOutput distanceOutput;
-		b2Distance(&distanceOutput, &cache, &distanceInput);
+		b2Distance(&distanceOutput, cache, &distanceInput);
+		++output->distanceCalls;
+		output->distanceIterations += distanceOutput.iterations;
 
 		// If the shapes are overlapped, we give up on continuous collision.
 		if (distanceOutput.distance <= 0.0f)
@@ -324,7 +327,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 
 		// Initialize the separating axis.
 		b2SeparationFunction fcn;
-		fcn.Initialize(&cache, proxyA, sweepA, proxyB, sweepB, t1);
+		fcn.Initialize(cache, proxyA, sweepA, proxyB, sweepB, t1);
 #if 0
 		// Dump the curve seen by the root finder
 		{
@@ -422,7 +425,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
 
 				float32 s = fcn.Evaluate(indexA, indexB, t);
 
@@ -451,7 +453,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			output->rootIterations += rootIterCount;
 
 			++pushBackIter;
 
@@ -462,7 +464,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
 
 		if (done)
 		{
@@ -478,9 +479,247 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	output->iterations = iter;
+}
+
+// Does the sweep describe a body at rest?
+static bool b2IsFixed(const b2Sweep& sweep)
+{
+	return sweep.c0 == sweep.c && sweep.a0 == sweep.a;
+}
+
+// Distance from a point to a proxy core. Zero if the point is inside a polygon.
+static float32 b2CoreDistance(const b2DistanceProxy* proxy, const b2Vec2& p)
+{
+	const b2Vec2* vertices = proxy->m_vertices;
+	int32 count = proxy->m_count;
+
+	if (count == 1)
+	{
+		return b2Distance(p, vertices[0]);
+	}
+
+	bool inside = count > 2;
+	float32 minDistanceSqr = b2_maxFloat;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 v1 = vertices[i];
+		b2Vec2 v2 = vertices[i + 1 < count ? i + 1 : 0];
+		b2Vec2 e = v2 - v1;
+
+		// Polygon vertices wind counter-clockwise.
+		if (b2Cross(e, p - v1) < 0.0f)
+		{
+			inside = false;
+		}
+
+		float32 u = b2Clamp(b2Dot(p - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+		minDistanceSqr = b2Min(minDistanceSqr, b2DistanceSquared(p, v1 + u * e));
+
+		if (count == 2)
+		{
+			break;
+		}
+	}
+
+	return inside ? 0.0f : b2Sqrt(minDistanceSqr);
+}
+
+bool b2TimeOfImpactCircle(b2TOIOutput* output, const b2TOIInput* input)
+{
+	const b2DistanceProxy* circle = &input->proxyA;
+	const b2DistanceProxy* proxy = &input->proxyB;
+	const b2Sweep* sweepC = &input->sweepA;
+	const b2Sweep* sweepP = &input->sweepB;
+
+	if (circle->m_count != 1 || b2IsFixed(*sweepP) == false)
+	{
+		b2Swap(circle, proxy);
+		b2Swap(sweepC, sweepP);
+	}
+
+	if (circle->m_count != 1 || b2IsFixed(*sweepP) == false)
+	{
+		return false;
+	}
+
+	// The center moves on a line unless the body rotates about another point.
+	b2Vec2 center = circle->m_vertices[0];
+	if (sweepC->a0 != sweepC->a && (center == sweepC->localCenter) == false)
+	{
+		return false;
+	}
+
+	// The closed form needs no iterations.
+	output->iterations = 0;
+	output->rootIterations = 0;
+	output->distanceCalls = 0;
+	output->distanceIterations = 0;
+
+	float32 tMax = input->tMax;
+
+	float32 totalRadius = circle->m_radius + proxy->m_radius;
+	float32 target = b2Max(b2_linearSlop, totalRadius - 3.0f * b2_linearSlop);
+	float32 tolerance = 0.25f * b2_linearSlop;
+	b2Assert(target > tolerance);
+
+	// Trace the center as the ray s + t * d in the frame of the fixed proxy.
+	b2Transform xfC0, xfC1, xfP;
+	sweepC->GetTransform(&xfC0, 0.0f);
+	sweepC->GetTransform(&xfC1, 1.0f);
+	sweepP->GetTransform(&xfP, 0.0f);
+
+	b2Vec2 p0 = b2Mul(xfC0, center);
+	b2Vec2 p1 = b2Mul(xfC1, center);
+	b2Vec2 s = b2MulT(xfP, p0);
+	b2Vec2 d = b2MulT(xfP.q, p1 - p0);
+
+	float32 distance = b2CoreDistance(proxy, s);
+	if (distance <= 0.0f)
+	{
+		output->state = b2TOIOutput::e_overlapped;
+		output->t = 0.0f;
+		return true;
+	}
+
+	if (distance < target + tolerance)
+	{
+		output->state = b2TOIOutput::e_touching;
+		output->t = 0.0f;
+		return true;
+	}
+
+	// The center hits the proxy core grown by the target distance. Its boundary is
+	// made of circles around the vertices and lines parallel to the edges.
+	const b2Vec2* vertices = proxy->m_vertices;
+	int32 count = proxy->m_count;
+	float32 dd = b2Dot(d, d);
+	float32 t = tMax;
+	bool hit = false;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 v1 = vertices[i];
+
+		// Ray against the circle around the vertex.
+		b2Vec2 m = s - v1;
+		float32 b = b2Dot(m, d);
+		float32 c = b2Dot(m, m) - target * target;
+		float32 sigma = b * b - dd * c;
+		if (b < 0.0f && sigma >= 0.0f)
+		{
+			float32 tc = (-b - b2Sqrt(sigma)) / dd;
+			if (0.0f <= tc && tc < t)
+			{
+				t = tc;
+				hit = true;
+			}
+		}
+
+		if (count == 1 || (count == 2 && i == 1))
+		{
+			continue;
+		}
+
+		// Ray against the offset line on the side of the edge facing the center.
+		b2Vec2 v2 = vertices[i + 1 < count ? i + 1 : 0];
+		b2Vec2 e = v2 - v1;
+		b2Vec2 normal = b2Cross(e, 1.0f);
+		normal.Normalize();
+
+		float32 separation = b2Dot(normal, m);
+		if (separation < 0.0f)
+		{
+			normal = -normal;
+			separation = -separation;
+		}
+
+		float32 dn = b2Dot(normal, d);
+		if (separation <= target || dn >= 0.0f)
+		{
+			continue;
+		}
+
+		float32 tl = (target - separation) / dn;
+		if (tl < t)
+		{
+			float32 u = b2Dot(s + tl * d - v1, e);
+			if (0.0f <= u && u <= b2Dot(e, e))
+			{
+				t = tl;
+				hit = true;
+			}
+		}
+	}
+
+	output->state = hit ? b2TOIOutput::e_touching : b2TOIOutput::e_separated;
+	output->t = t;
+	return true;
+}
+
+// Conservative advancement: the center cannot get closer to the surface faster than
+// it moves, so it is safe to advance by the distance left over a bound on its speed.
+void b2TimeOfImpactField(b2TOIOutput* output,
+						 const b2DistanceFieldShape* field, const b2Sweep& sweepField,
+						 const b2CircleShape* circle, const b2Sweep& sweepCircle, float32 tMax)
+{
+	b2Assert(b2IsFixed(sweepField));
+
+	output->state = b2TOIOutput::e_unknown;
+	output->t = tMax;
+	output->iterations = 0;
+	output->rootIterations = 0;
+	output->distanceCalls = 0;
+	output->distanceIterations = 0;
+
+	float32 target = b2Max(b2_linearSlop, circle->m_radius + field->m_radius - 3.0f * b2_linearSlop);
+	float32 tolerance = 0.25f * b2_linearSlop;
+	b2Assert(target > tolerance);
+
+	b2Transform xfF;
+	sweepField.GetTransform(&xfF, 0.0f);
+
+	// Bound the distance the center moves over the sweep.
+	b2Vec2 center = circle->m_p;
+	float32 speed = b2Distance(sweepCircle.c0, sweepCircle.c) +
+					b2Abs(sweepCircle.a - sweepCircle.a0) * b2Distance(center, sweepCircle.localCenter);
+
+	float32 t = 0.0f;
+	const int32 k_maxIterations = 32;
+	for (int32 i = 0; i < k_maxIterations; ++i)
+	{
+		++output->iterations;
+
+		b2Transform xfC;
+		sweepCircle.GetTransform(&xfC, t);
+		b2Vec2 p = b2MulT(xfF, b2Mul(xfC, center));
+		float32 distance = field->Sample(p, nullptr) - field->m_radius;
+
+		if (distance <= 0.0f && t == 0.0f)
+		{
+			output->state = b2TOIOutput::e_overlapped;
+			output->t = 0.0f;
+			return;
+		}
+
+		if (distance < target + tolerance)
+		{
+			output->state = b2TOIOutput::e_touching;
+			output->t = t;
+			return;
+		}
+
+		if (speed * (tMax - t) < distance - target)
+		{
+			output->state = b2TOIOutput::e_separated;
+			output->t = tMax;
+			return;
+		}
+
+		t += (distance - target) / speed;
+	}
 
-	float32 time = timer.GetMilliseconds();
-	b2_toiMaxTime = b2Max(b2_toiMaxTime, time);
-	b2_toiTime += time;
+	// The center keeps approaching at a grazing angle.
+	output->state = b2TOIOutput::e_failed;
+	output->t = t;
 }
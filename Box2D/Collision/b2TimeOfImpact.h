@@ -46,6 +46,10 @@ struct b2TOIOutput
 
 	State state;
 	float32 t;
+	int32 iterations;			///< number of separating axes tried
+	int32 rootIterations;		///< root finder iterations over all axes
+	int32 distanceCalls;		///< number of b2Distance queries
+	int32 distanceIterations;	///< GJK iterations of those queries
 };
 
 /// Compute the upper bound on time before two shapes penetrate. Time is represented as
@@ -55,4 +59,27 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Compute the time of impact, warm starting the distance queries with a simplex cache.
+/// The cache is input/output as in b2Distance, so reusing one for the same pair of proxies
+/// carries the simplex from one call to the next. On the first call set the count to zero.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache);
+
+/// Compute the time of impact of a circle against a shape that does not move, in
+/// closed form. This gives the same kind of result as b2TimeOfImpact without the
+/// root finder and is meant for balls against static geometry. Either proxy may be
+/// the circle. The other proxy must come from a shape.
+/// @return false if neither side is a circle whose center moves on a line while the
+/// other side is fixed. Use b2TimeOfImpact then.
+bool b2TimeOfImpactCircle(b2TOIOutput* output, const b2TOIInput* input);
+
+class b2CircleShape;
+class b2DistanceFieldShape;
+
+/// Compute the time of impact of a circle against a distance field that does not move.
+/// Distance fields have no proxy, so this advances the circle by the sampled distance
+/// instead of using b2TimeOfImpact.
+void b2TimeOfImpactField(b2TOIOutput* output,
+						 const b2DistanceFieldShape* field, const b2Sweep& sweepField,
+						 const b2CircleShape* circle, const b2Sweep& sweepCircle, float32 tMax);
+
 #endif
@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Common/b2AllocatorInterface.h"
+#include "Box2D/Common/b2Math.h"
+#include <string.h>
+
+static const char* b2_memoryTagNames[b2_memoryTagCount] =
+{
+	"block",
+	"tree",
+	"broad-phase",
+	"body",
+	"fixture",
+	"contact",
+	"joint",
+	"island",
+	"scratch"
+};
+
+b2AllocatorInterface::b2AllocatorInterface()
+{
+	memset(m_stats, 0, sizeof(m_stats));
+	m_totalBytes = 0;
+	m_peakTotalBytes = 0;
+}
+
+b2AllocatorInterface::~b2AllocatorInterface()
+{
+}
+
+void* b2AllocatorInterface::Allocate(int32 size, b2MemoryTag tag)
+{
+	void* mem = AllocateMemory(size, tag);
+	Track(size, tag);
+
+	m_totalBytes += size;
+	m_peakTotalBytes = b2Max(m_peakTotalBytes, m_totalBytes);
+	return mem;
+}
+
+void b2AllocatorInterface::Free(void* mem, int32 size, b2MemoryTag tag)
+{
+	if (mem == nullptr)
+	{
+		return;
+	}
+
+	Untrack(size, tag);
+	m_totalBytes -= size;
+	b2Assert(m_totalBytes >= 0);
+
+	FreeMemory(mem, size, tag);
+}
+
+void b2AllocatorInterface::Track(int32 size, b2MemoryTag tag)
+{
+	b2Assert(0 <= tag && tag < b2_memoryTagCount);
+	b2MemoryStats* stats = m_stats + tag;
+	stats->bytes += size;
+	stats->peakBytes = b2Max(stats->peakBytes, stats->bytes);
+	++stats->allocations;
+	++stats->totalAllocations;
+}
+
+void b2AllocatorInterface::Untrack(int32 size, b2MemoryTag tag, int32 count)
+{
+	b2Assert(0 <= tag && tag < b2_memoryTagCount);
+	b2MemoryStats* stats = m_stats + tag;
+	stats->bytes -= size;
+	stats->allocations -= count;
+	b2Assert(stats->bytes >= 0 && stats->allocations >= 0);
+}
+
+void b2AllocatorInterface::ResetPeaks()
+{
+	for (int32 i = 0; i < b2_memoryTagCount; ++i)
+	{
+		m_stats[i].peakBytes = m_stats[i].bytes;
+		m_stats[i].totalAllocations = 0;
+	}
+
+	m_peakTotalBytes = m_totalBytes;
+}
+
+void b2AllocatorInterface::Dump() const
+{
+	b2Log("// memory: %d bytes, %d peak\n", m_totalBytes, m_peakTotalBytes);
+	for (int32 i = 0; i < b2_memoryTagCount; ++i)
+	{
+		const b2MemoryStats& s = m_stats[i];
+		b2Log("//   %s: %d bytes, %d peak, %d live, %d total\n",
+			b2_memoryTagNames[i], s.bytes, s.peakBytes, s.allocations, s.totalAllocations);
+	}
+}
+
+void* b2AllocatorInterface::AllocateMemory(int32 size, b2MemoryTag tag)
+{
+	B2_NOT_USED(tag);
+	return b2Alloc(size);
+}
+
+void b2AllocatorInterface::FreeMemory(void* mem, int32 size, b2MemoryTag tag)
+{
+	B2_NOT_USED(size);
+	B2_NOT_USED(tag);
+	b2Free(mem);
+}
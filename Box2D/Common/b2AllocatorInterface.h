@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ALLOCATOR_INTERFACE_H
+#define B2_ALLOCATOR_INTERFACE_H
+
+#include "Box2D/Common/b2Settings.h"
+
+/// The subsystems that memory is charged to.
+enum b2MemoryTag
+{
+	b2_blockMemory,			///< chunks owned by the small block allocator
+	b2_treeMemory,			///< dynamic tree nodes, proxies and rebuild buffers
+	b2_broadPhaseMemory,	///< broad-phase move and pair buffers
+	b2_bodyMemory,			///< bodies
+	b2_fixtureMemory,		///< fixtures, their shapes and proxy arrays
+	b2_contactMemory,		///< contacts
+	b2_jointMemory,			///< joints
+	b2_islandMemory,		///< persistent islands
+	b2_scratchMemory,		///< per step stack memory for islands and the solver
+	b2_memoryTagCount
+};
+
+/// Memory counters for one subsystem.
+struct b2MemoryStats
+{
+	int32 bytes;			///< bytes currently in use
+	int32 peakBytes;		///< the largest value bytes has reached
+	int32 allocations;		///< live allocations
+	int32 totalAllocations;	///< allocations since construction or the last ResetPeaks
+};
+
+/// A world gets all of its memory through this interface. The default
+/// implementation uses b2Alloc and b2Free. Derive from it and override
+/// AllocateMemory and FreeMemory to route a world to an arena, huge pages
+/// or a tracking heap. The counters are kept by the base class.
+/// Bodies, fixtures, contacts and joints live inside block allocator chunks.
+/// Their bytes are tracked per tag but come out of b2_blockMemory, so
+/// GetTotalBytes counts them only once.
+class b2AllocatorInterface
+{
+public:
+	b2AllocatorInterface();
+	virtual ~b2AllocatorInterface();
+
+	/// Get memory from AllocateMemory and charge it to the tag.
+	void* Allocate(int32 size, b2MemoryTag tag);
+
+	/// Return memory obtained from Allocate with the same size and tag.
+	void Free(void* mem, int32 size, b2MemoryTag tag);
+
+	/// Charge memory carved out of an earlier allocation to a tag.
+	void Track(int32 size, b2MemoryTag tag);
+
+	/// Undo one or more Track calls totalling size bytes.
+	void Untrack(int32 size, b2MemoryTag tag, int32 count = 1);
+
+	/// Get the counters for a subsystem.
+	const b2MemoryStats& GetStats(b2MemoryTag tag) const;
+
+	/// Get the bytes currently obtained through AllocateMemory.
+	int32 GetTotalBytes() const;
+
+	/// Get the largest value GetTotalBytes has reached.
+	int32 GetPeakTotalBytes() const;
+
+	/// Set the peaks to the current values and clear the allocation totals.
+	void ResetPeaks();
+
+	/// Dump the counters to the log.
+	void Dump() const;
+
+protected:
+
+	/// Override this to supply memory. The tag lets an implementation
+	/// place subsystems in different pools.
+	virtual void* AllocateMemory(int32 size, b2MemoryTag tag);
+
+	/// Override this to release memory from AllocateMemory.
+	virtual void FreeMemory(void* mem, int32 size, b2MemoryTag tag);
+
+private:
+
+	b2MemoryStats m_stats[b2_memoryTagCount];
+	int32 m_totalBytes;
+	int32 m_peakTotalBytes;
+};
+
+/// Allocate through an optional allocator interface.
+inline void* b2Alloc(b2AllocatorInterface* allocator, int32 size, b2MemoryTag tag)
+{
+	if (allocator)
+	{
+		return allocator->Allocate(size, tag);
+	}
+
+	return b2Alloc(size);
+}
+
+/// Free through an optional allocator interface.
+inline void b2Free(b2AllocatorInterface* allocator, void* mem, int32 size, b2MemoryTag tag)
+{
+	if (allocator)
+	{
+		allocator->Free(mem, size, tag);
+		return;
+	}
+
+	b2Free(mem);
+}
+
+inline const b2MemoryStats& b2AllocatorInterface::GetStats(b2MemoryTag tag) const
+{
+	b2Assert(0 <= tag && tag < b2_memoryTagCount);
+	return m_stats[tag];
+}
+
+inline int32 b2AllocatorInterface::GetTotalBytes() const
+{
+	return m_totalBytes;
+}
+
+inline int32 b2AllocatorInterface::GetPeakTotalBytes() const
+{
+	return m_peakTotalBytes;
+}
+
+#endif
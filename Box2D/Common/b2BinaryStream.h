@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BINARY_STREAM_H
+#define B2_BINARY_STREAM_H
+
+#include "Box2D/Common/b2Settings.h"
+#include <string.h>
+
+/// Writes raw bytes into a caller provided buffer. Writing past the
+/// capacity is not an error: the bytes are dropped and the size keeps
+/// counting, so a writer with a null buffer measures the space needed.
+class b2BinaryWriter
+{
+public:
+	b2BinaryWriter(void* buffer, int32 capacity)
+	{
+		m_buffer = (uint8*)buffer;
+		m_capacity = buffer ? capacity : 0;
+		m_size = 0;
+	}
+
+	void Write(const void* data, int32 size)
+	{
+		if (m_size + size <= m_capacity)
+		{
+			memcpy(m_buffer + m_size, data, size);
+		}
+		m_size += size;
+	}
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	/// Overwrite bytes written earlier, for example a size field.
+	void WriteAt(int32 offset, const void* data, int32 size)
+	{
+		b2Assert(offset + size <= m_size);
+		if (offset + size <= m_capacity)
+		{
+			memcpy(m_buffer + offset, data, size);
+		}
+	}
+
+	/// Pad with zeros up to a multiple of alignment.
+	void Align(int32 alignment)
+	{
+		const uint8 zero = 0;
+		while (m_size % alignment != 0)
+		{
+			Write(&zero, 1);
+		}
+	}
+
+	/// Get the number of bytes written, or that would have been written.
+	int32 GetSize() const { return m_size; }
+
+	/// Did everything fit in the buffer?
+	bool IsValid() const { return m_size <= m_capacity; }
+
+private:
+	uint8* m_buffer;
+	int32 m_capacity;
+	int32 m_size;
+};
+
+/// Reads raw bytes from a buffer. Reading past the end zero fills the
+/// output and marks the reader invalid.
+class b2BinaryReader
+{
+public:
+	b2BinaryReader(const void* buffer, int32 size)
+	{
+		m_buffer = (const uint8*)buffer;
+		m_size = size;
+		m_position = 0;
+		m_valid = true;
+	}
+
+	void Read(void* data, int32 size)
+	{
+		if (m_valid == false || size < 0 || m_size - m_position < size)
+		{
+			memset(data, 0, size);
+			m_valid = false;
+			return;
+		}
+
+		memcpy(data, m_buffer + m_position, size);
+		m_position += size;
+	}
+
+	template <typename T>
+	void Read(T* value)
+	{
+		Read(value, sizeof(T));
+	}
+
+	template <typename T>
+	T Read()
+	{
+		T value;
+		Read(&value, sizeof(T));
+		return value;
+	}
+
+	/// Get a pointer to the next size bytes and skip them. Returns null if
+	/// there are not enough bytes left.
+	const void* Skip(int32 size)
+	{
+		if (m_valid == false || size < 0 || m_size - m_position < size)
+		{
+			m_valid = false;
+			return nullptr;
+		}
+
+		const void* data = m_buffer + m_position;
+		m_position += size;
+		return data;
+	}
+
+	const void* GetData() const { return m_buffer; }
+	int32 GetPosition() const { return m_position; }
+	int32 GetSize() const { return m_size; }
+
+	/// False if a read went past the end of the buffer.
+	bool IsValid() const { return m_valid; }
+
+private:
+	const uint8* m_buffer;
+	int32 m_size;
+	int32 m_position;
+	bool m_valid;
+};
+
+#endif
@@ -38,8 +38,6 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 	512,	// 12
 	640,	// 13
 };
-uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
-bool b2BlockAllocator::s_blockSizeLookupInitialized;
 
 struct b2Chunk
 {
@@ -52,49 +50,63 @@ struct b2Block
 	b2Block* next;
 };
 
-b2BlockAllocator::b2BlockAllocator()
+// The lookup is built on first use. The initialization of a local static is
+// thread safe, so allocators may be created on several threads at once.
+const uint8* b2BlockAllocator::GetBlockSizeLookup()
+{
+	struct b2BlockSizeLookup
+	{
+		b2BlockSizeLookup()
+		{
+			values[0] = 0;
+
+			int32 j = 0;
+			for (int32 i = 1; i <= b2_maxBlockSize; ++i)
+			{
+				b2Assert(j < b2_blockSizes);
+				if (i <= s_blockSizes[j])
+				{
+					values[i] = (uint8)j;
+				}
+				else
+				{
+					++j;
+					values[i] = (uint8)j;
+				}
+			}
+		}
+
+		uint8 values[b2_maxBlockSize + 1];
+	};
+
+	static const b2BlockSizeLookup s_lookup;
+	return s_lookup.values;
+}
+
+b2BlockAllocator::b2BlockAllocator(b2AllocatorInterface* allocator)
 {
 	b2Assert(b2_blockSizes < UCHAR_MAX);
 
+	m_allocator = allocator;
+
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
-	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+	m_chunks = (b2Chunk*)b2Alloc(m_allocator, m_chunkSpace * sizeof(b2Chunk), b2_blockMemory);
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
-
-	if (s_blockSizeLookupInitialized == false)
-	{
-		int32 j = 0;
-		for (int32 i = 1; i <= b2_maxBlockSize; ++i)
-		{
-			b2Assert(j < b2_blockSizes);
-			if (i <= s_blockSizes[j])
-			{
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-			else
-			{
-				++j;
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-		}
-
-		s_blockSizeLookupInitialized = true;
-	}
+	memset(m_trackedBytes, 0, sizeof(m_trackedBytes));
+	memset(m_trackedCounts, 0, sizeof(m_trackedCounts));
 }
 
 b2BlockAllocator::~b2BlockAllocator()
 {
-	for (int32 i = 0; i < m_chunkCount; ++i)
-	{
-		b2Free(m_chunks[i].blocks);
-	}
+	Clear();
 
-	b2Free(m_chunks);
+	b2Free(m_allocator, m_chunks, m_chunkSpace * sizeof(b2Chunk), b2_blockMemory);
 }
 
-void* b2BlockAllocator::Allocate(int32 size)
+void* b2BlockAllocator::Allocate(int32 size, b2MemoryTag tag)
 {
 	if (size == 0)
 		return nullptr;
@@ -103,12 +115,19 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		return b2Alloc(size);
+		return b2Alloc(m_allocator, size, tag);
 	}
 
-	int32 index = s_blockSizeLookup[size];
+	int32 index = GetBlockSizeLookup()[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	if (m_allocator)
+	{
+		m_allocator->Track(size, tag);
+		m_trackedBytes[tag] += size;
+		++m_trackedCounts[tag];
+	}
+
 	if (m_freeLists[index])
 	{
 		b2Block* block = m_freeLists[index];
@@ -120,15 +139,16 @@ void* b2BlockAllocator::Allocate(int32 size)
 		if (m_chunkCount == m_chunkSpace)
 		{
 			b2Chunk* oldChunks = m_chunks;
+			int32 oldSpace = m_chunkSpace;
 			m_chunkSpace += b2_chunkArrayIncrement;
-			m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+			m_chunks = (b2Chunk*)b2Alloc(m_allocator, m_chunkSpace * sizeof(b2Chunk), b2_blockMemory);
 			memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
 			memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-			b2Free(oldChunks);
+			b2Free(m_allocator, oldChunks, oldSpace * sizeof(b2Chunk), b2_blockMemory);
 		}
 
 		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+		chunk->blocks = (b2Block*)b2Alloc(m_allocator, b2_chunkSize, b2_blockMemory);
 #if defined(_DEBUG)
 		memset(chunk->blocks, 0xcd, b2_chunkSize);
 #endif
@@ -152,7 +172,7 @@ void* b2BlockAllocator::Allocate(int32 size)
 	}
 }
 
-void b2BlockAllocator::Free(void* p, int32 size)
+void b2BlockAllocator::Free(void* p, int32 size, b2MemoryTag tag)
 {
 	if (size == 0)
 	{
@@ -163,13 +183,20 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		b2Free(p);
+		b2Free(m_allocator, p, size, tag);
 		return;
 	}
 
-	int32 index = s_blockSizeLookup[size];
+	int32 index = GetBlockSizeLookup()[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	if (m_allocator)
+	{
+		m_allocator->Untrack(size, tag);
+		m_trackedBytes[tag] -= size;
+		--m_trackedCounts[tag];
+	}
+
 #ifdef _DEBUG
 	// Verify the memory address and size is valid.
 	int32 blockSize = s_blockSizes[index];
@@ -205,9 +232,21 @@ void b2BlockAllocator::Clear()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		b2Free(m_allocator, m_chunks[i].blocks, b2_chunkSize, b2_blockMemory);
 	}
 
+	// Blocks still in use vanish with their chunks.
+	if (m_allocator)
+	{
+		for (int32 i = 0; i < b2_memoryTagCount; ++i)
+		{
+			m_allocator->Untrack(m_trackedBytes[i], (b2MemoryTag)i, m_trackedCounts[i]);
+		}
+	}
+
+	memset(m_trackedBytes, 0, sizeof(m_trackedBytes));
+	memset(m_trackedCounts, 0, sizeof(m_trackedCounts));
+
 	m_chunkCount = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
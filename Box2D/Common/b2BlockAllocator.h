@@ -19,7 +19,7 @@
 #ifndef B2_BLOCK_ALLOCATOR_H
 #define B2_BLOCK_ALLOCATOR_H
 
-#include "Box2D/Common/b2Settings.h"
+#include "Box2D/Common/b2AllocatorInterface.h"
 
 const int32 b2_chunkSize = 16 * 1024;
 const int32 b2_maxBlockSize = 640;
@@ -32,31 +32,40 @@ struct b2Chunk;
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+/// Chunks come from the optional allocator interface and blocks are
+/// charged to the tag passed with each request.
 class b2BlockAllocator
 {
 public:
-	b2BlockAllocator();
+	b2BlockAllocator(b2AllocatorInterface* allocator = nullptr);
 	~b2BlockAllocator();
 
-	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
-	void* Allocate(int32 size);
+	/// Allocate memory. This will go to the allocator interface if the size is larger than b2_maxBlockSize.
+	void* Allocate(int32 size, b2MemoryTag tag);
 
-	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
-	void Free(void* p, int32 size);
+	/// Free memory. This will go to the allocator interface if the size is larger than b2_maxBlockSize.
+	void Free(void* p, int32 size, b2MemoryTag tag);
 
 	void Clear();
 
 private:
 
+	// Map a request size to the index of its block size.
+	static const uint8* GetBlockSizeLookup();
+
+	b2AllocatorInterface* m_allocator;
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	// Block bytes charged to each tag, so Clear can release them.
+	int32 m_trackedBytes[b2_memoryTagCount];
+	int32 m_trackedCounts[b2_memoryTagCount];
+
 	static int32 s_blockSizes[b2_blockSizes];
-	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
-	static bool s_blockSizeLookupInitialized;
 };
 
 #endif
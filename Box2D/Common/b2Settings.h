@@ -30,6 +30,19 @@
 #define B2_NOT_USED(x) ((void)(x))
 #define b2Assert(A) assert(A)
 
+// Hint that the memory at an address will be read soon.
+// Define B2_NO_PREFETCH to turn the hints off, for example to measure them.
+#if defined(B2_NO_PREFETCH)
+	#define b2Prefetch(p) B2_NOT_USED(p)
+#elif defined(__GNUC__) || defined(__clang__)
+	#define b2Prefetch(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <xmmintrin.h>
+	#define b2Prefetch(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+	#define b2Prefetch(p) B2_NOT_USED(p)
+#endif
+
 typedef signed char	int8;
 typedef signed short int16;
 typedef signed int int32;
@@ -53,6 +66,11 @@ typedef double float64;
 /// not change this value.
 #define b2_maxManifoldPoints	2
 
+/// With manifold reuse, a contact keeps its manifold while the relative transform of
+/// its bodies stays within these tolerances of the transform it was computed at.
+#define b2_manifoldLinearTolerance	(0.1f * b2_linearSlop)
+#define b2_manifoldAngularTolerance	(0.1f * b2_angularSlop)
+
 /// The maximum number of vertices on a convex polygon. You cannot increase
 /// this too much because b2BlockAllocator has a maximum object size.
 #define b2_maxPolygonVertices	8
@@ -67,6 +85,25 @@ typedef double float64;
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier		2.0f
 
+/// Each proxy adapts its fat AABB extension to its size and recent displacement.
+/// These are the default limits of that extension. They can be changed per world.
+/// This is in meters.
+#define b2_minAABBExtension		0.02f
+#define b2_maxAABBExtension		0.5f
+
+/// The number of steps of recent displacement that the fat AABB extension should absorb.
+/// This is a dimensionless multiplier.
+#define b2_aabbDisplacementSteps	8.0f
+
+/// A proxy that still fits its fat AABB is re-inserted once its adapted extension
+/// drops below this fraction of the extension it was inserted with.
+/// This is a dimensionless multiplier.
+#define b2_aabbShrinkRatio		0.5f
+
+/// The fraction of the smaller half-extent of a proxy that is added to its fat AABB extension.
+/// This is a dimensionless multiplier.
+#define b2_aabbSizeRatio		0.05f
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_linearSlop			0.005f
@@ -80,6 +117,10 @@ typedef double float64;
 /// Making it larger may create artifacts for vertex collision.
 #define b2_polygonRadius		(2.0f * b2_linearSlop)
 
+/// The minimum distance at which separated shapes produce speculative contact points.
+/// See b2World::SetSpeculativeContacts
+#define b2_speculativeDistance	(4.0f * b2_linearSlop)
+
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps			8
 
@@ -89,6 +130,13 @@ typedef double float64;
 /// Maximum number of contacts to be handled to solve a TOI impact.
 #define b2_maxTOIContacts			32
 
+/// Maximum number of independent TOI events solved together in parallel continuous mode.
+#define b2_maxTOIGroupSize			16
+
+/// Islands are solved in batches of up to this many bodies to share the fixed cost
+/// of a solver call. Larger islands are solved alone.
+#define b2_islandBatchSize			64
+
 /// A velocity threshold for elastic collisions. Any collision with a relative linear
 /// velocity below this threshold will be treated as inelastic.
 #define b2_velocityThreshold		1.0f
@@ -18,41 +18,102 @@
 
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Math.h"
+#include <string.h>
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(int32 capacity, b2AllocatorInterface* allocator)
 {
-	m_index = 0;
+	b2Assert(capacity > 0);
+
+	m_allocator = allocator;
+
+	m_segmentCapacity = 4;
+	m_segmentCount = 1;
+	m_segment = 0;
+	m_segments = (b2StackSegment*)b2Alloc(m_allocator, m_segmentCapacity * sizeof(b2StackSegment), b2_scratchMemory);
+	m_segments[0].data = (char*)b2Alloc(m_allocator, capacity, b2_scratchMemory);
+	m_segments[0].capacity = capacity;
+	m_segments[0].index = 0;
+
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_highWaterMark = 0;
+	m_overflowCount = 0;
+
+	m_entryCapacity = b2_maxStackEntries;
 	m_entryCount = 0;
+	m_entries = (b2StackEntry*)b2Alloc(m_allocator, m_entryCapacity * sizeof(b2StackEntry), b2_scratchMemory);
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
-	b2Assert(m_index == 0);
+	b2Assert(m_allocation == 0);
 	b2Assert(m_entryCount == 0);
+
+	for (int32 i = 0; i < m_segmentCount; ++i)
+	{
+		b2Free(m_allocator, m_segments[i].data, m_segments[i].capacity, b2_scratchMemory);
+	}
+	b2Free(m_allocator, m_segments, m_segmentCapacity * sizeof(b2StackSegment), b2_scratchMemory);
+	b2Free(m_allocator, m_entries, m_entryCapacity * sizeof(b2StackEntry), b2_scratchMemory);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
-	b2Assert(m_entryCount < b2_maxStackEntries);
+	size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
 
-	b2StackEntry* entry = m_entries + m_entryCount;
-	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_entryCount == m_entryCapacity)
 	{
-		entry->data = (char*)b2Alloc(size);
-		entry->usedMalloc = true;
+		b2StackEntry* oldEntries = m_entries;
+		m_entryCapacity *= 2;
+		m_entries = (b2StackEntry*)b2Alloc(m_allocator, m_entryCapacity * sizeof(b2StackEntry), b2_scratchMemory);
+		memcpy(m_entries, oldEntries, m_entryCount * sizeof(b2StackEntry));
+		b2Free(m_allocator, oldEntries, m_entryCount * sizeof(b2StackEntry), b2_scratchMemory);
 	}
-	else
+
+	// Move to the next segment if the current one is full. The segments
+	// above the current one are empty, so they can be replaced freely.
+	b2StackSegment* segment = m_segments + m_segment;
+	if (segment->index + size > segment->capacity)
 	{
-		entry->data = m_data + m_index;
-		entry->usedMalloc = false;
-		m_index += size;
+		++m_segment;
+		++m_overflowCount;
+
+		if (m_segment == m_segmentCount)
+		{
+			if (m_segmentCount == m_segmentCapacity)
+			{
+				b2StackSegment* oldSegments = m_segments;
+				m_segmentCapacity *= 2;
+				m_segments = (b2StackSegment*)b2Alloc(m_allocator, m_segmentCapacity * sizeof(b2StackSegment), b2_scratchMemory);
+				memcpy(m_segments, oldSegments, m_segmentCount * sizeof(b2StackSegment));
+				b2Free(m_allocator, oldSegments, m_segmentCount * sizeof(b2StackSegment), b2_scratchMemory);
+			}
+
+			m_segments[m_segment].data = nullptr;
+			m_segments[m_segment].capacity = 0;
+			m_segments[m_segment].index = 0;
+			++m_segmentCount;
+		}
+
+		segment = m_segments + m_segment;
+		b2Assert(segment->index == 0);
+		if (segment->capacity < size)
+		{
+			b2Free(m_allocator, segment->data, segment->capacity, b2_scratchMemory);
+			segment->capacity = b2Max(size, m_segments[0].capacity);
+			segment->data = (char*)b2Alloc(m_allocator, segment->capacity, b2_scratchMemory);
+		}
 	}
 
+	b2StackEntry* entry = m_entries + m_entryCount;
+	entry->data = segment->data + segment->index;
+	entry->size = size;
+	entry->segment = m_segment;
+	segment->index += size;
+
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+	m_highWaterMark = b2Max(m_highWaterMark, m_allocation);
 	++m_entryCount;
 
 	return entry->data;
@@ -63,21 +124,54 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(m_entryCount > 0);
 	b2StackEntry* entry = m_entries + m_entryCount - 1;
 	b2Assert(p == entry->data);
-	if (entry->usedMalloc)
+	b2StackSegment* segment = m_segments + entry->segment;
+	segment->index -= entry->size;
+	m_allocation -= entry->size;
+	--m_entryCount;
+
+	// Fall back to the segment holding the new top entry.
+	m_segment = m_entryCount > 0 ? m_entries[m_entryCount - 1].segment : 0;
+
+	p = nullptr;
+}
+
+void b2StackAllocator::Reset()
+{
+	b2Assert(m_entryCount == 0);
+
+	if (m_segmentCount > 1)
 	{
-		b2Free(p);
+		// Replace the segments with one that fits everything this step used.
+		SetCapacity(b2Max(m_segments[0].capacity, m_highWaterMark));
 	}
-	else
+
+	m_highWaterMark = 0;
+	m_overflowCount = 0;
+}
+
+void b2StackAllocator::SetCapacity(int32 capacity)
+{
+	b2Assert(capacity > 0);
+	b2Assert(m_entryCount == 0);
+
+	for (int32 i = 0; i < m_segmentCount; ++i)
 	{
-		m_index -= entry->size;
+		b2Free(m_allocator, m_segments[i].data, m_segments[i].capacity, b2_scratchMemory);
 	}
-	m_allocation -= entry->size;
-	--m_entryCount;
 
-	p = nullptr;
+	m_segmentCount = 1;
+	m_segment = 0;
+	m_segments[0].data = (char*)b2Alloc(m_allocator, capacity, b2_scratchMemory);
+	m_segments[0].capacity = capacity;
+	m_segments[0].index = 0;
 }
 
-int32 b2StackAllocator::GetMaxAllocation() const
+int32 b2StackAllocator::GetCapacity() const
 {
-	return m_maxAllocation;
+	int32 capacity = 0;
+	for (int32 i = 0; i < m_segmentCount; ++i)
+	{
+		capacity += m_segments[i].capacity;
+	}
+	return capacity;
 }
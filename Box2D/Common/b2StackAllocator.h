@@ -19,42 +19,93 @@
 #ifndef B2_STACK_ALLOCATOR_H
 #define B2_STACK_ALLOCATOR_H
 
-#include "Box2D/Common/b2Settings.h"
+#include "Box2D/Common/b2AllocatorInterface.h"
 
 const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackAlignment = 8;
 const int32 b2_maxStackEntries = 32;
 
 struct b2StackEntry
 {
 	char* data;
 	int32 size;
-	bool usedMalloc;
+	int32 segment;
+};
+
+struct b2StackSegment
+{
+	char* data;
+	int32 capacity;
+	int32 index;
 };
 
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// When the current segment is full the stack grows by adding a segment.
+// Call Reset between steps to merge the segments into one that fits
+// the high water mark, so later steps do not allocate.
+// Segments come from the optional allocator interface as b2_scratchMemory.
+// Sizes are rounded up to b2_stackAlignment so blocks stay aligned.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	b2StackAllocator(int32 capacity = b2_stackSize, b2AllocatorInterface* allocator = nullptr);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Merge overflow segments and clear the per step counters. The stack must be empty.
+	void Reset();
+
+	/// Change the capacity. The stack must be empty.
+	void SetCapacity(int32 capacity);
+
+	/// Get the capacity of the stack in bytes, including overflow segments.
+	int32 GetCapacity() const;
+
+	/// Get the largest allocation total since construction.
 	int32 GetMaxAllocation() const;
 
+	/// Get the largest allocation total since the last reset.
+	int32 GetHighWaterMark() const;
+
+	/// Get the number of times a segment was added since the last reset.
+	int32 GetOverflowCount() const;
+
 private:
 
-	char m_data[b2_stackSize];
-	int32 m_index;
+	b2AllocatorInterface* m_allocator;
+
+	b2StackSegment* m_segments;
+	int32 m_segmentCount;
+	int32 m_segmentCapacity;
+	int32 m_segment;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_highWaterMark;
+	int32 m_overflowCount;
 
-	b2StackEntry m_entries[b2_maxStackEntries];
+	b2StackEntry* m_entries;
 	int32 m_entryCount;
+	int32 m_entryCapacity;
 };
 
+inline int32 b2StackAllocator::GetMaxAllocation() const
+{
+	return m_maxAllocation;
+}
+
+inline int32 b2StackAllocator::GetHighWaterMark() const
+{
+	return m_highWaterMark;
+}
+
+inline int32 b2StackAllocator::GetOverflowCount() const
+{
+	return m_overflowCount;
+}
+
 #endif
@@ -27,14 +27,14 @@
 
 b2Contact* b2CircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
 {
-	void* mem = allocator->Allocate(sizeof(b2CircleContact));
+	void* mem = allocator->Allocate(sizeof(b2CircleContact), b2_contactMemory);
 	return new (mem) b2CircleContact(fixtureA, fixtureB);
 }
 
 void b2CircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 {
 	((b2CircleContact*)contact)->~b2CircleContact();
-	allocator->Free(contact, sizeof(b2CircleContact));
+	allocator->Free(contact, sizeof(b2CircleContact), b2_contactMemory);
 }
 
 b2CircleContact::b2CircleContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
@@ -48,5 +48,6 @@ void b2CircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, con
 {
 	b2CollideCircles(manifold,
 					(b2CircleShape*)m_fixtureA->GetShape(), xfA,
-					(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+					(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+					m_speculativeDistance);
 }
@@ -24,6 +24,15 @@
 #include "Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h"
 #include "Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h"
 #include "Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h"
+#include "Box2D/Dynamics/Contacts/b2CapsuleAndCircleContact.h"
+#include "Box2D/Dynamics/Contacts/b2CapsuleContact.h"
+#include "Box2D/Dynamics/Contacts/b2PolygonAndCapsuleContact.h"
+#include "Box2D/Dynamics/Contacts/b2EdgeAndCapsuleContact.h"
+#include "Box2D/Dynamics/Contacts/b2ChainAndCapsuleContact.h"
+#include "Box2D/Dynamics/Contacts/b2TerrainAndCircleContact.h"
+#include "Box2D/Dynamics/Contacts/b2TerrainAndPolygonContact.h"
+#include "Box2D/Dynamics/Contacts/b2TerrainAndCapsuleContact.h"
+#include "Box2D/Dynamics/Contacts/b2DistanceFieldAndCircleContact.h"
 #include "Box2D/Dynamics/Contacts/b2ContactSolver.h"
 
 #include "Box2D/Collision/b2Collision.h"
@@ -34,10 +43,12 @@
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2World.h"
 
+#include <string.h>
+
 b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 bool b2Contact::s_initialized = false;
 
-void b2Contact::InitializeRegisters()
+bool b2Contact::InitializeRegisters()
 {
 	AddType(b2CircleContact::Create, b2CircleContact::Destroy, b2Shape::e_circle, b2Shape::e_circle);
 	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, b2Shape::e_polygon, b2Shape::e_circle);
@@ -46,6 +57,18 @@ void b2Contact::InitializeRegisters()
 	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
 	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
 	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+	AddType(b2CapsuleAndCircleContact::Create, b2CapsuleAndCircleContact::Destroy, b2Shape::e_capsule, b2Shape::e_circle);
+	AddType(b2CapsuleContact::Create, b2CapsuleContact::Destroy, b2Shape::e_capsule, b2Shape::e_capsule);
+	AddType(b2PolygonAndCapsuleContact::Create, b2PolygonAndCapsuleContact::Destroy, b2Shape::e_polygon, b2Shape::e_capsule);
+	AddType(b2EdgeAndCapsuleContact::Create, b2EdgeAndCapsuleContact::Destroy, b2Shape::e_edge, b2Shape::e_capsule);
+	AddType(b2ChainAndCapsuleContact::Create, b2ChainAndCapsuleContact::Destroy, b2Shape::e_chain, b2Shape::e_capsule);
+	AddType(b2TerrainAndCircleContact::Create, b2TerrainAndCircleContact::Destroy, b2Shape::e_terrain, b2Shape::e_circle);
+	AddType(b2TerrainAndPolygonContact::Create, b2TerrainAndPolygonContact::Destroy, b2Shape::e_terrain, b2Shape::e_polygon);
+	AddType(b2TerrainAndCapsuleContact::Create, b2TerrainAndCapsuleContact::Destroy, b2Shape::e_terrain, b2Shape::e_capsule);
+	AddType(b2DistanceFieldAndCircleContact::Create, b2DistanceFieldAndCircleContact::Destroy, b2Shape::e_distanceField, b2Shape::e_circle);
+
+	s_initialized = true;
+	return true;
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -66,24 +89,25 @@ void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* dest
 	}
 }
 
-b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+const b2ContactRegister* b2Contact::GetRegister(b2Shape::Type type1, b2Shape::Type type2)
 {
-	if (s_initialized == false)
-	{
-		InitializeRegisters();
-		s_initialized = true;
-	}
-
-	b2Shape::Type type1 = fixtureA->GetType();
-	b2Shape::Type type2 = fixtureB->GetType();
+	// Register the contact types on first use. The initialization of a local
+	// static is thread safe, so contacts may be created on several threads at once.
+	static const bool registersInitialized = InitializeRegisters();
+	B2_NOT_USED(registersInitialized);
 
 	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
 	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
-	
-	b2ContactCreateFcn* createFcn = s_registers[type1][type2].createFcn;
+	return &s_registers[type1][type2];
+}
+
+b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+{
+	const b2ContactRegister* reg = GetRegister(fixtureA->GetType(), fixtureB->GetType());
+	b2ContactCreateFcn* createFcn = reg->createFcn;
 	if (createFcn)
 	{
-		if (s_registers[type1][type2].primary)
+		if (reg->primary)
 		{
 			return createFcn(fixtureA, indexA, fixtureB, indexB, allocator);
 		}
@@ -148,12 +172,84 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.next = nullptr;
 	m_nodeB.other = nullptr;
 
+	m_island = nullptr;
+	m_islandPrev = nullptr;
+	m_islandNext = nullptr;
+
+	m_awakeIndex = -1;
+
 	m_toiCount = 0;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
 
 	m_tangentSpeed = 0.0f;
+
+	m_speculativeDistance = 0.0f;
+
+	m_relativeXf.SetIdentity();
+	m_evaluatedDistance = 0.0f;
+
+	memset(&m_simplexCache, 0, sizeof(b2SimplexCache));
+}
+
+b2Profile* b2Contact::GetProfile()
+{
+	return &m_fixtureA->GetBody()->m_world->m_profile;
+}
+
+// The approach speed is the closing velocity of the bodies along the normal before
+// the solver runs. A point is closed if it is within the slop or closes its gap this
+// step. A contact reports one hit when it closes and none while it stays closed,
+// so resting contacts and the TOI updates within a step do not repeat the hit.
+void b2Contact::ReportHit(b2EventBuffer* buffer, float32 threshold, float32 speculativeTime)
+{
+	b2Body* bodyA = m_fixtureA->GetBody();
+	b2Body* bodyB = m_fixtureB->GetBody();
+
+	b2WorldManifold worldManifold;
+	worldManifold.Initialize(&m_manifold, bodyA->GetTransform(), m_fixtureA->GetShape()->m_radius,
+							 bodyB->GetTransform(), m_fixtureB->GetShape()->m_radius);
+
+	b2ContactHitEvent event;
+	event.approachSpeed = threshold;
+	bool closed = false;
+	bool hit = false;
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		b2Vec2 point = worldManifold.points[i];
+		b2Vec2 vA = bodyA->m_linearVelocity + b2Cross(bodyA->m_angularVelocity, point - bodyA->m_sweep.c);
+		b2Vec2 vB = bodyB->m_linearVelocity + b2Cross(bodyB->m_angularVelocity, point - bodyB->m_sweep.c);
+		float32 approachSpeed = -b2Dot(vB - vA, worldManifold.normal);
+
+		if (worldManifold.separations[i] > b2_linearSlop + speculativeTime * b2Max(approachSpeed, 0.0f))
+		{
+			continue;
+		}
+
+		closed = true;
+		if (approachSpeed > event.approachSpeed)
+		{
+			event.approachSpeed = approachSpeed;
+			event.point = point;
+			hit = true;
+		}
+	}
+
+	if (closed == false)
+	{
+		m_flags &= ~e_hitFlag;
+		return;
+	}
+
+	if (hit && (m_flags & e_hitFlag) == 0)
+	{
+		m_flags |= e_hitFlag;
+		event.fixtureA = m_fixtureA;
+		event.fixtureB = m_fixtureB;
+		event.normal = worldManifold.normal;
+		buffer->AddHit(event);
+	}
 }
 
 // Update the contact manifold and touching status.
@@ -182,38 +278,108 @@ void b2Contact::Update(b2ContactListener* listener)
 	{
 		const b2Shape* shapeA = m_fixtureA->GetShape();
 		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+		if (shapeA->m_type == b2Shape::e_distanceField)
+		{
+			// GJK cannot take a distance field, so look up the field instead.
+			b2Manifold manifold;
+			m_speculativeDistance = 0.0f;
+			Evaluate(&manifold, xfA, xfB);
+			touching = manifold.pointCount > 0;
+		}
+		else
+		{
+			int32 iterations;
+			touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB, &m_simplexCache, &iterations);
+
+			b2Profile& profile = bodyA->m_world->m_profile;
+			++profile.gjkCalls;
+			profile.gjkIters += iterations;
+			profile.gjkMaxIters = b2Max(profile.gjkMaxIters, iterations);
+		}
 
 		// Sensors don't generate manifolds.
 		m_manifold.pointCount = 0;
+		m_flags &= ~e_relativeXfFlag;
 	}
 	else
 	{
-		Evaluate(&m_manifold, xfA, xfB);
-		touching = m_manifold.pointCount > 0;
+		// Keep points the bodies may close during the next step, so the solver can
+		// stop fast bodies before they pass through.
+		float32 speculativeTime = bodyA->m_world->m_speculativeTime;
+		if (speculativeTime > 0.0f)
+		{
+			b2Vec2 dv = bodyB->m_linearVelocity - bodyA->m_linearVelocity;
+			m_speculativeDistance = b2_speculativeDistance + speculativeTime * dv.Length();
+		}
+		else
+		{
+			m_speculativeDistance = 0.0f;
+		}
+
+		// Keep the manifold and its impulses if the bodies barely moved relative to
+		// each other since it was computed. Bodies that are still moving faster than
+		// the sleep tolerances get fresh points, otherwise stale impulses keep piles
+		// from settling and falling asleep.
+		bool reuse = false;
+		if (bodyA->m_world->m_manifoldReuse)
+		{
+			b2Transform relativeXf = b2MulT(xfA, xfB);
+			const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
+			const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+			bool slow = b2Dot(bodyA->m_linearVelocity, bodyA->m_linearVelocity) <= linTolSqr &&
+						bodyA->m_angularVelocity * bodyA->m_angularVelocity <= angTolSqr &&
+						b2Dot(bodyB->m_linearVelocity, bodyB->m_linearVelocity) <= linTolSqr &&
+						bodyB->m_angularVelocity * bodyB->m_angularVelocity <= angTolSqr;
+
+			if ((m_flags & e_relativeXfFlag) && slow)
+			{
+				b2Rot dq = b2MulT(m_relativeXf.q, relativeXf.q);
+				reuse = b2DistanceSquared(relativeXf.p, m_relativeXf.p) <= b2_manifoldLinearTolerance * b2_manifoldLinearTolerance &&
+						dq.c > 0.0f && b2Abs(dq.s) <= b2_manifoldAngularTolerance &&
+						b2Abs(m_speculativeDistance - m_evaluatedDistance) <= b2_manifoldLinearTolerance;
+			}
 
-		// Match old contact ids to new contact ids and copy the
-		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
+			if (reuse == false)
+			{
+				m_relativeXf = relativeXf;
+				m_evaluatedDistance = m_speculativeDistance;
+				m_flags |= e_relativeXfFlag;
+			}
+		}
+		else
 		{
-			b2ManifoldPoint* mp2 = m_manifold.points + i;
-			mp2->normalImpulse = 0.0f;
-			mp2->tangentImpulse = 0.0f;
-			b2ContactID id2 = mp2->id;
+			m_flags &= ~e_relativeXfFlag;
+		}
 
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
+		if (reuse == false)
+		{
+			Evaluate(&m_manifold, xfA, xfB);
+
+			// Match old contact ids to new contact ids and copy the
+			// stored impulses to warm start the solver.
+			for (int32 i = 0; i < m_manifold.pointCount; ++i)
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
+				b2ManifoldPoint* mp2 = m_manifold.points + i;
+				mp2->normalImpulse = 0.0f;
+				mp2->tangentImpulse = 0.0f;
+				b2ContactID id2 = mp2->id;
 
-				if (mp1->id.key == id2.key)
+				for (int32 j = 0; j < oldManifold.pointCount; ++j)
 				{
-					mp2->normalImpulse = mp1->normalImpulse;
-					mp2->tangentImpulse = mp1->tangentImpulse;
-					break;
+					b2ManifoldPoint* mp1 = oldManifold.points + j;
+
+					if (mp1->id.key == id2.key)
+					{
+						mp2->normalImpulse = mp1->normalImpulse;
+						mp2->tangentImpulse = mp1->tangentImpulse;
+						break;
+					}
 				}
 			}
 		}
 
+		touching = m_manifold.pointCount > 0;
+
 		if (touching != wasTouching)
 		{
 			bodyA->SetAwake(true);
@@ -230,17 +396,59 @@ void b2Contact::Update(b2ContactListener* listener)
 		m_flags &= ~e_touchingFlag;
 	}
 
-	if (wasTouching == false && touching == true && listener)
+	// Solid touching contacts connect islands.
+	bool linked = touching && sensor == false;
+	if (linked != (m_island != nullptr))
+	{
+		b2IslandGraph* islandGraph = &bodyA->m_world->m_islandGraph;
+		if (linked)
+		{
+			islandGraph->LinkContact(this);
+		}
+		else
+		{
+			islandGraph->UnlinkContact(this);
+		}
+	}
+
+	uint16 events = GetContactEvents();
+
+	// Step events are gathered during the step only. Contacts destroyed with a
+	// fixture outside of the step would leave dangling fixtures in the arrays.
+	b2World* world = bodyA->m_world;
+	if (world->IsLocked())
+	{
+		if (touching != wasTouching && (events & b2_beginEndEvents))
+		{
+			world->m_eventBuffer.AddTouch(m_fixtureA, m_fixtureB, sensorA, sensorB, touching);
+		}
+
+		if (sensor == false && touching && (events & b2_hitEvents))
+		{
+			ReportHit(&world->m_eventBuffer, world->m_hitEventThreshold, world->m_speculativeTime);
+		}
+		else
+		{
+			m_flags &= ~e_hitFlag;
+		}
+	}
+
+	if (listener == nullptr)
+	{
+		return;
+	}
+
+	if (wasTouching == false && touching == true && (events & b2_beginEndEvents))
 	{
 		listener->BeginContact(this);
 	}
 
-	if (wasTouching == true && touching == false && listener)
+	if (wasTouching == true && touching == false && (events & b2_beginEndEvents))
 	{
 		listener->EndContact(this);
 	}
 
-	if (sensor == false && touching && listener)
+	if (sensor == false && touching && (events & b2_preSolveEvents))
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
@@ -21,6 +21,7 @@
 
 #include "Box2D/Common/b2Math.h"
 #include "Box2D/Collision/b2Collision.h"
+#include "Box2D/Collision/b2Distance.h"
 #include "Box2D/Collision/Shapes/b2Shape.h"
 #include "Box2D/Dynamics/b2Fixture.h"
 
@@ -31,6 +32,9 @@ class b2World;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2ContactListener;
+struct b2Profile;
+class b2EventBuffer;
+struct b2PersistentIsland;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the friction to zero.
 /// For example, anything slides on ice.
@@ -115,6 +119,10 @@ public:
 	/// Get the child primitive index for fixture B.
 	int32 GetChildIndexB() const;
 
+	/// Get the listener events of this contact. These are the events asked for
+	/// by either fixture, see b2ContactEventFlags.
+	uint16 GetContactEvents() const;
+
 	/// Override the default friction mixture. You can call this in b2ContactListener::PreSolve.
 	/// This value persists until set or reset.
 	void SetFriction(float32 friction);
@@ -141,12 +149,14 @@ public:
 	/// Get the desired tangent speed. In meters per second.
 	float32 GetTangentSpeed() const;
 
-	/// Evaluate this contact with your own manifold and transforms.
+	/// Evaluate this contact with your own manifold and transforms. This keeps
+	/// speculative points within the distance computed by the last update.
 	virtual void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB) = 0;
 
 protected:
 	friend class b2ContactManager;
 	friend class b2World;
+	friend class b2IslandGraph;
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
@@ -170,7 +180,13 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// The manifold was computed at m_relativeXf and can be reused
+		e_relativeXfFlag	= 0x0040,
+
+		// This contact reported a hit and has stayed closed since
+		e_hitFlag			= 0x0080
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
@@ -178,7 +194,8 @@ protected:
 
 	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
 						b2Shape::Type typeA, b2Shape::Type typeB);
-	static void InitializeRegisters();
+	static bool InitializeRegisters();
+	static const b2ContactRegister* GetRegister(b2Shape::Type typeA, b2Shape::Type typeB);
 	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
@@ -189,6 +206,12 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// The profile of the world, for the counters of the narrow-phase.
+	b2Profile* GetProfile();
+
+	// Add a hit event if a point of the manifold closes its gap faster than the threshold.
+	void ReportHit(b2EventBuffer* buffer, float32 threshold, float32 speculativeTime);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
@@ -202,6 +225,14 @@ protected:
 	b2ContactEdge m_nodeA;
 	b2ContactEdge m_nodeB;
 
+	// The persistent island, set while touching unless this is a sensor.
+	b2PersistentIsland* m_island;
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
+
+	// Index in the awake contact array or -1 if the contact sleeps.
+	int32 m_awakeIndex;
+
 	b2Fixture* m_fixtureA;
 	b2Fixture* m_fixtureB;
 
@@ -210,6 +241,17 @@ protected:
 
 	b2Manifold m_manifold;
 
+	// Separated points closer than this are kept as speculative points.
+	float32 m_speculativeDistance;
+
+	// The relative transform of the bodies and the speculative distance the
+	// manifold was computed at. Only kept with manifold reuse.
+	b2Transform m_relativeXf;
+	float32 m_evaluatedDistance;
+
+	// Warm starts the sensor overlap and time of impact queries of this pair.
+	b2SimplexCache m_simplexCache;
+
 	int32 m_toiCount;
 	float32 m_toi;
 
@@ -301,6 +343,11 @@ inline int32 b2Contact::GetChildIndexB() const
 	return m_indexB;
 }
 
+inline uint16 b2Contact::GetContactEvents() const
+{
+	return m_fixtureA->GetContactEvents() | m_fixtureB->GetContactEvents();
+}
+
 inline void b2Contact::FlagForFiltering()
 {
 	m_flags |= e_filterFlag;
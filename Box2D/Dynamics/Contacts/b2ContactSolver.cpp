@@ -209,7 +209,13 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
 			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
-			if (vRel < -b2_velocityThreshold)
+			float32 separation = worldManifold.separations[j];
+			if (m_step.speculative && separation > 0.0f)
+			{
+				// Speculative point: allow the bodies to close the gap within the step.
+				vcp->velocityBias = -separation * m_step.inv_dt;
+			}
+			else if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
 			}
@@ -668,11 +674,12 @@ struct b2PositionSolverManifold
 };
 
 // Sequential solver.
-bool b2ContactSolver::SolvePositionConstraints()
+bool b2ContactSolver::SolvePositionConstraints(int32 first, int32 count)
 {
+	b2Assert(0 <= first && first + count <= m_count);
 	float32 minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = first; i < first + count; ++i)
 	{
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
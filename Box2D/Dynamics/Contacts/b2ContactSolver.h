@@ -78,7 +78,8 @@ public:
 	void SolveVelocityConstraints();
 	void StoreImpulses();
 
-	bool SolvePositionConstraints();
+	// Solve the position constraints of the contacts in [first, first + count).
+	bool SolvePositionConstraints(int32 first, int32 count);
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
 	b2TimeStep m_step;
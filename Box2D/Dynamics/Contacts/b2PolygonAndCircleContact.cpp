@@ -24,14 +24,14 @@
 
 b2Contact* b2PolygonAndCircleContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
 {
-	void* mem = allocator->Allocate(sizeof(b2PolygonAndCircleContact));
+	void* mem = allocator->Allocate(sizeof(b2PolygonAndCircleContact), b2_contactMemory);
 	return new (mem) b2PolygonAndCircleContact(fixtureA, fixtureB);
 }
 
 void b2PolygonAndCircleContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 {
 	((b2PolygonAndCircleContact*)contact)->~b2PolygonAndCircleContact();
-	allocator->Free(contact, sizeof(b2PolygonAndCircleContact));
+	allocator->Free(contact, sizeof(b2PolygonAndCircleContact), b2_contactMemory);
 }
 
 b2PolygonAndCircleContact::b2PolygonAndCircleContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
@@ -45,5 +45,6 @@ void b2PolygonAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform
 {
 	b2CollidePolygonAndCircle(	manifold,
 								(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+								(b2CircleShape*)m_fixtureB->GetShape(), xfB,
+								m_speculativeDistance);
 }
@@ -21,20 +21,21 @@
 #include "Box2D/Collision/b2TimeOfImpact.h"
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Dynamics/b2TimeStep.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 
 #include <new>
 
 b2Contact* b2PolygonContact::Create(b2Fixture* fixtureA, int32, b2Fixture* fixtureB, int32, b2BlockAllocator* allocator)
 {
-	void* mem = allocator->Allocate(sizeof(b2PolygonContact));
+	void* mem = allocator->Allocate(sizeof(b2PolygonContact), b2_contactMemory);
 	return new (mem) b2PolygonContact(fixtureA, fixtureB);
 }
 
 void b2PolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 {
 	((b2PolygonContact*)contact)->~b2PolygonContact();
-	allocator->Free(contact, sizeof(b2PolygonContact));
+	allocator->Free(contact, sizeof(b2PolygonContact), b2_contactMemory);
 }
 
 b2PolygonContact::b2PolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
@@ -42,11 +43,31 @@ b2PolygonContact::b2PolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_polygon);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_polygon);
+	m_cache.valid = 0;
 }
 
 void b2PolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
 	b2CollidePolygons(	manifold,
 						(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-						(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+						(b2PolygonShape*)m_fixtureB->GetShape(), xfB,
+						m_speculativeDistance, &m_cache);
+
+	if (m_cache.result != b2_polygonCacheNone)
+	{
+		b2Profile* profile = GetProfile();
+		++profile->polygonCacheCalls;
+		if (m_cache.result == b2_polygonCacheHit)
+		{
+			++profile->polygonCacheHits;
+		}
+		else if (m_cache.result == b2_polygonCacheClimb)
+		{
+			++profile->polygonCacheClimbs;
+		}
+		else
+		{
+			++profile->polygonCacheMisses;
+		}
+	}
 }
@@ -34,6 +34,10 @@ public:
 	~b2PolygonContact() {}
 
 	void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB) override;
+
+private:
+	// The features found last step start the next search.
+	b2PolygonCache m_cache;
 };
 
 #endif
@@ -258,3 +258,31 @@ void b2DistanceJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2DistanceJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+}
+
+void b2DistanceJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+}
+
+void b2DistanceJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_length);
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+}
+
+void b2DistanceJoint::ReadDefinition(b2BinaryReader* reader, b2DistanceJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->length);
+	reader->Read(&def->frequencyHz);
+	reader->Read(&def->dampingRatio);
+}
@@ -101,6 +101,9 @@ public:
 	/// Dump joint to dmLog
 	void Dump() override;
 
+	/// Read a definition written by WriteDefinition. The bodies are not set.
+	static void ReadDefinition(b2BinaryReader* reader, b2DistanceJointDef* def);
+
 protected:
 
 	friend class b2Joint;
@@ -109,6 +112,9 @@ protected:
 	void InitVelocityConstraints(const b2SolverData& data) override;
 	void SolveVelocityConstraints(const b2SolverData& data) override;
 	bool SolvePositionConstraints(const b2SolverData& data) override;
+	void WriteState(b2BinaryWriter* writer) const override;
+	void ReadState(b2BinaryReader* reader) override;
+	void WriteDefinition(b2BinaryWriter* writer) const override;
 
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
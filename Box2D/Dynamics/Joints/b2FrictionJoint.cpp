@@ -249,3 +249,31 @@ void b2FrictionJoint::Dump()
 	b2Log("  jd.maxTorque = %.15lef;\n", m_maxTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2FrictionJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_linearImpulse);
+	writer->Write(m_angularImpulse);
+}
+
+void b2FrictionJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_linearImpulse);
+	reader->Read(&m_angularImpulse);
+}
+
+void b2FrictionJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_maxForce);
+	writer->Write(m_maxTorque);
+}
+
+void b2FrictionJoint::ReadDefinition(b2BinaryReader* reader, b2FrictionJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->maxForce);
+	reader->Read(&def->maxTorque);
+}
@@ -417,3 +417,42 @@ void b2GearJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2GearJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+}
+
+void b2GearJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+}
+
+void b2GearJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_joint1->m_index);
+	writer->Write(m_joint2->m_index);
+	writer->Write(m_ratio);
+}
+
+void b2GearJoint::ReadDefinition(b2BinaryReader* reader, b2GearJointDef* def, b2Joint** joints, int32 jointCount)
+{
+	int32 index1 = reader->Read<int32>();
+	int32 index2 = reader->Read<int32>();
+	reader->Read(&def->ratio);
+
+	// A gear joint can only refer to a revolute or prismatic joint loaded before it.
+	def->joint1 = nullptr;
+	def->joint2 = nullptr;
+	if (0 <= index1 && index1 < jointCount && 0 <= index2 && index2 < jointCount)
+	{
+		b2Joint* joint1 = joints[index1];
+		b2Joint* joint2 = joints[index2];
+		if ((joint1->GetType() == e_revoluteJoint || joint1->GetType() == e_prismaticJoint) &&
+			(joint2->GetType() == e_revoluteJoint || joint2->GetType() == e_prismaticJoint))
+		{
+			def->joint1 = joint1;
+			def->joint2 = joint2;
+		}
+	}
+}
@@ -75,6 +75,10 @@ public:
 	/// Dump joint to dmLog
 	void Dump() override;
 
+	/// Read a definition written by WriteDefinition. The joints are indexed in creation order.
+	/// The joints are null if the indices are not revolute or prismatic joints among the first jointCount.
+	static void ReadDefinition(b2BinaryReader* reader, b2GearJointDef* def, b2Joint** joints, int32 jointCount);
+
 protected:
 
 	friend class b2Joint;
@@ -83,6 +87,9 @@ protected:
 	void InitVelocityConstraints(const b2SolverData& data) override;
 	void SolveVelocityConstraints(const b2SolverData& data) override;
 	bool SolvePositionConstraints(const b2SolverData& data) override;
+	void WriteState(b2BinaryWriter* writer) const override;
+	void ReadState(b2BinaryReader* reader) override;
+	void WriteDefinition(b2BinaryWriter* writer) const override;
 
 	b2Joint* m_joint1;
 	b2Joint* m_joint2;
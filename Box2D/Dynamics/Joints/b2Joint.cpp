@@ -42,77 +42,77 @@ b2Joint* b2Joint::Create(const b2JointDef* def, b2BlockAllocator* allocator)
 	{
 	case e_distanceJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2DistanceJoint));
+			void* mem = allocator->Allocate(sizeof(b2DistanceJoint), b2_jointMemory);
 			joint = new (mem) b2DistanceJoint(static_cast<const b2DistanceJointDef*>(def));
 		}
 		break;
 
 	case e_mouseJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2MouseJoint));
+			void* mem = allocator->Allocate(sizeof(b2MouseJoint), b2_jointMemory);
 			joint = new (mem) b2MouseJoint(static_cast<const b2MouseJointDef*>(def));
 		}
 		break;
 
 	case e_prismaticJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2PrismaticJoint));
+			void* mem = allocator->Allocate(sizeof(b2PrismaticJoint), b2_jointMemory);
 			joint = new (mem) b2PrismaticJoint(static_cast<const b2PrismaticJointDef*>(def));
 		}
 		break;
 
 	case e_revoluteJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2RevoluteJoint));
+			void* mem = allocator->Allocate(sizeof(b2RevoluteJoint), b2_jointMemory);
 			joint = new (mem) b2RevoluteJoint(static_cast<const b2RevoluteJointDef*>(def));
 		}
 		break;
 
 	case e_pulleyJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2PulleyJoint));
+			void* mem = allocator->Allocate(sizeof(b2PulleyJoint), b2_jointMemory);
 			joint = new (mem) b2PulleyJoint(static_cast<const b2PulleyJointDef*>(def));
 		}
 		break;
 
 	case e_gearJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2GearJoint));
+			void* mem = allocator->Allocate(sizeof(b2GearJoint), b2_jointMemory);
 			joint = new (mem) b2GearJoint(static_cast<const b2GearJointDef*>(def));
 		}
 		break;
 
 	case e_wheelJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2WheelJoint));
+			void* mem = allocator->Allocate(sizeof(b2WheelJoint), b2_jointMemory);
 			joint = new (mem) b2WheelJoint(static_cast<const b2WheelJointDef*>(def));
 		}
 		break;
 
 	case e_weldJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2WeldJoint));
+			void* mem = allocator->Allocate(sizeof(b2WeldJoint), b2_jointMemory);
 			joint = new (mem) b2WeldJoint(static_cast<const b2WeldJointDef*>(def));
 		}
 		break;
         
 	case e_frictionJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2FrictionJoint));
+			void* mem = allocator->Allocate(sizeof(b2FrictionJoint), b2_jointMemory);
 			joint = new (mem) b2FrictionJoint(static_cast<const b2FrictionJointDef*>(def));
 		}
 		break;
 
 	case e_ropeJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2RopeJoint));
+			void* mem = allocator->Allocate(sizeof(b2RopeJoint), b2_jointMemory);
 			joint = new (mem) b2RopeJoint(static_cast<const b2RopeJointDef*>(def));
 		}
 		break;
 
 	case e_motorJoint:
 		{
-			void* mem = allocator->Allocate(sizeof(b2MotorJoint));
+			void* mem = allocator->Allocate(sizeof(b2MotorJoint), b2_jointMemory);
 			joint = new (mem) b2MotorJoint(static_cast<const b2MotorJointDef*>(def));
 		}
 		break;
@@ -131,47 +131,47 @@ void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 	switch (joint->m_type)
 	{
 	case e_distanceJoint:
-		allocator->Free(joint, sizeof(b2DistanceJoint));
+		allocator->Free(joint, sizeof(b2DistanceJoint), b2_jointMemory);
 		break;
 
 	case e_mouseJoint:
-		allocator->Free(joint, sizeof(b2MouseJoint));
+		allocator->Free(joint, sizeof(b2MouseJoint), b2_jointMemory);
 		break;
 
 	case e_prismaticJoint:
-		allocator->Free(joint, sizeof(b2PrismaticJoint));
+		allocator->Free(joint, sizeof(b2PrismaticJoint), b2_jointMemory);
 		break;
 
 	case e_revoluteJoint:
-		allocator->Free(joint, sizeof(b2RevoluteJoint));
+		allocator->Free(joint, sizeof(b2RevoluteJoint), b2_jointMemory);
 		break;
 
 	case e_pulleyJoint:
-		allocator->Free(joint, sizeof(b2PulleyJoint));
+		allocator->Free(joint, sizeof(b2PulleyJoint), b2_jointMemory);
 		break;
 
 	case e_gearJoint:
-		allocator->Free(joint, sizeof(b2GearJoint));
+		allocator->Free(joint, sizeof(b2GearJoint), b2_jointMemory);
 		break;
 
 	case e_wheelJoint:
-		allocator->Free(joint, sizeof(b2WheelJoint));
+		allocator->Free(joint, sizeof(b2WheelJoint), b2_jointMemory);
 		break;
     
 	case e_weldJoint:
-		allocator->Free(joint, sizeof(b2WeldJoint));
+		allocator->Free(joint, sizeof(b2WeldJoint), b2_jointMemory);
 		break;
 
 	case e_frictionJoint:
-		allocator->Free(joint, sizeof(b2FrictionJoint));
+		allocator->Free(joint, sizeof(b2FrictionJoint), b2_jointMemory);
 		break;
 
 	case e_ropeJoint:
-		allocator->Free(joint, sizeof(b2RopeJoint));
+		allocator->Free(joint, sizeof(b2RopeJoint), b2_jointMemory);
 		break;
 
 	case e_motorJoint:
-		allocator->Free(joint, sizeof(b2MotorJoint));
+		allocator->Free(joint, sizeof(b2MotorJoint), b2_jointMemory);
 		break;
 
 	default:
@@ -189,6 +189,9 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_next = nullptr;
 	m_bodyA = def->bodyA;
 	m_bodyB = def->bodyB;
+	m_island = nullptr;
+	m_islandPrev = nullptr;
+	m_islandNext = nullptr;
 	m_index = 0;
 	m_collideConnected = def->collideConnected;
 	m_islandFlag = false;
@@ -20,11 +20,13 @@
 #define B2_JOINT_H
 
 #include "Box2D/Common/b2Math.h"
+#include "Box2D/Common/b2BinaryStream.h"
 
 class b2Body;
 class b2Joint;
 struct b2SolverData;
 class b2BlockAllocator;
+struct b2PersistentIsland;
 
 enum b2JointType
 {
@@ -153,6 +155,7 @@ protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend class b2IslandGraph;
 	friend class b2GearJoint;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
@@ -167,6 +170,14 @@ protected:
 	// This returns true if the position errors are within tolerance.
 	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+	// Save and restore the impulses carried between steps for warm starting.
+	virtual void WriteState(b2BinaryWriter* writer) const = 0;
+	virtual void ReadState(b2BinaryReader* reader) = 0;
+
+	// Write the type specific part of the definition. The matching read is
+	// the static ReadDefinition of each joint class.
+	virtual void WriteDefinition(b2BinaryWriter* writer) const = 0;
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
@@ -175,6 +186,11 @@ protected:
 	b2Body* m_bodyA;
 	b2Body* m_bodyB;
 
+	// The persistent island, null if no simulated body is attached.
+	b2PersistentIsland* m_island;
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	int32 m_index;
 
 	bool m_islandFlag;
@@ -307,3 +307,33 @@ void b2MotorJoint::Dump()
 	b2Log("  jd.correctionFactor = %.15lef;\n", m_correctionFactor);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2MotorJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_linearImpulse);
+	writer->Write(m_angularImpulse);
+}
+
+void b2MotorJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_linearImpulse);
+	reader->Read(&m_angularImpulse);
+}
+
+void b2MotorJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_linearOffset);
+	writer->Write(m_angularOffset);
+	writer->Write(m_maxForce);
+	writer->Write(m_maxTorque);
+	writer->Write(m_correctionFactor);
+}
+
+void b2MotorJoint::ReadDefinition(b2BinaryReader* reader, b2MotorJointDef* def)
+{
+	reader->Read(&def->linearOffset);
+	reader->Read(&def->angularOffset);
+	reader->Read(&def->maxForce);
+	reader->Read(&def->maxTorque);
+	reader->Read(&def->correctionFactor);
+}
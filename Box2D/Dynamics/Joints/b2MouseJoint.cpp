@@ -220,3 +220,29 @@ void b2MouseJoint::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_targetA -= newOrigin;
 }
+
+void b2MouseJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+}
+
+void b2MouseJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+}
+
+void b2MouseJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_targetA);
+	writer->Write(m_maxForce);
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+}
+
+void b2MouseJoint::ReadDefinition(b2BinaryReader* reader, b2MouseJointDef* def)
+{
+	reader->Read(&def->target);
+	reader->Read(&def->maxForce);
+	reader->Read(&def->frequencyHz);
+	reader->Read(&def->dampingRatio);
+}
@@ -92,6 +92,9 @@ public:
 	/// The mouse joint does not support dumping.
 	void Dump() override { b2Log("Mouse joint dumping is not supported.\n"); }
 
+	/// Read a definition written by WriteDefinition. The bodies are not set.
+	static void ReadDefinition(b2BinaryReader* reader, b2MouseJointDef* def);
+
 	/// Implement b2Joint::ShiftOrigin
 	void ShiftOrigin(const b2Vec2& newOrigin) override;
 
@@ -103,6 +106,9 @@ protected:
 	void InitVelocityConstraints(const b2SolverData& data) override;
 	void SolveVelocityConstraints(const b2SolverData& data) override;
 	bool SolvePositionConstraints(const b2SolverData& data) override;
+	void WriteState(b2BinaryWriter* writer) const override;
+	void ReadState(b2BinaryReader* reader) override;
+	void WriteDefinition(b2BinaryWriter* writer) const override;
 
 	b2Vec2 m_localAnchorB;
 	b2Vec2 m_targetA;
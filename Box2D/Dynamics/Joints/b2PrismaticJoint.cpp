@@ -640,3 +640,45 @@ void b2PrismaticJoint::Dump()
 	b2Log("  jd.maxMotorForce = %.15lef;\n", m_maxMotorForce);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PrismaticJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+	writer->Write(m_motorImpulse);
+	writer->Write(m_limitState);
+}
+
+void b2PrismaticJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&m_limitState);
+}
+
+void b2PrismaticJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_localXAxisA);
+	writer->Write(m_referenceAngle);
+	writer->Write(m_enableLimit);
+	writer->Write(m_lowerTranslation);
+	writer->Write(m_upperTranslation);
+	writer->Write(m_enableMotor);
+	writer->Write(m_motorSpeed);
+	writer->Write(m_maxMotorForce);
+}
+
+void b2PrismaticJoint::ReadDefinition(b2BinaryReader* reader, b2PrismaticJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->localAxisA);
+	reader->Read(&def->referenceAngle);
+	reader->Read(&def->enableLimit);
+	reader->Read(&def->lowerTranslation);
+	reader->Read(&def->upperTranslation);
+	reader->Read(&def->enableMotor);
+	reader->Read(&def->motorSpeed);
+	reader->Read(&def->maxMotorForce);
+}
@@ -346,3 +346,35 @@ void b2PulleyJoint::ShiftOrigin(const b2Vec2& newOrigin)
 	m_groundAnchorA -= newOrigin;
 	m_groundAnchorB -= newOrigin;
 }
+
+void b2PulleyJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+}
+
+void b2PulleyJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+}
+
+void b2PulleyJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_groundAnchorA);
+	writer->Write(m_groundAnchorB);
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_lengthA);
+	writer->Write(m_lengthB);
+	writer->Write(m_ratio);
+}
+
+void b2PulleyJoint::ReadDefinition(b2BinaryReader* reader, b2PulleyJointDef* def)
+{
+	reader->Read(&def->groundAnchorA);
+	reader->Read(&def->groundAnchorB);
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->lengthA);
+	reader->Read(&def->lengthB);
+	reader->Read(&def->ratio);
+}
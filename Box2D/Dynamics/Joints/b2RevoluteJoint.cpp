@@ -509,3 +509,43 @@ void b2RevoluteJoint::Dump()
 	b2Log("  jd.maxMotorTorque = %.15lef;\n", m_maxMotorTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RevoluteJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+	writer->Write(m_motorImpulse);
+	writer->Write(m_limitState);
+}
+
+void b2RevoluteJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&m_limitState);
+}
+
+void b2RevoluteJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_referenceAngle);
+	writer->Write(m_enableLimit);
+	writer->Write(m_lowerAngle);
+	writer->Write(m_upperAngle);
+	writer->Write(m_enableMotor);
+	writer->Write(m_motorSpeed);
+	writer->Write(m_maxMotorTorque);
+}
+
+void b2RevoluteJoint::ReadDefinition(b2BinaryReader* reader, b2RevoluteJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->referenceAngle);
+	reader->Read(&def->enableLimit);
+	reader->Read(&def->lowerAngle);
+	reader->Read(&def->upperAngle);
+	reader->Read(&def->enableMotor);
+	reader->Read(&def->motorSpeed);
+	reader->Read(&def->maxMotorTorque);
+}
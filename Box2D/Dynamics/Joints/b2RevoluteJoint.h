@@ -154,6 +154,9 @@ public:
 	/// Dump to b2Log.
 	void Dump() override;
 
+	/// Read a definition written by WriteDefinition. The bodies are not set.
+	static void ReadDefinition(b2BinaryReader* reader, b2RevoluteJointDef* def);
+
 protected:
 	
 	friend class b2Joint;
@@ -164,6 +167,9 @@ protected:
 	void InitVelocityConstraints(const b2SolverData& data) override;
 	void SolveVelocityConstraints(const b2SolverData& data) override;
 	bool SolvePositionConstraints(const b2SolverData& data) override;
+	void WriteState(b2BinaryWriter* writer) const override;
+	void ReadState(b2BinaryReader* reader) override;
+	void WriteDefinition(b2BinaryWriter* writer) const override;
 
 	// Solver shared
 	b2Vec2 m_localAnchorA;
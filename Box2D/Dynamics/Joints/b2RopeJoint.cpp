@@ -239,3 +239,29 @@ void b2RopeJoint::Dump()
 	b2Log("  jd.maxLength = %.15lef;\n", m_maxLength);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RopeJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+	writer->Write(m_state);
+}
+
+void b2RopeJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+	reader->Read(&m_state);
+}
+
+void b2RopeJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_maxLength);
+}
+
+void b2RopeJoint::ReadDefinition(b2BinaryReader* reader, b2RopeJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->maxLength);
+}
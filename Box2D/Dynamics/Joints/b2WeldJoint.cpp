@@ -342,3 +342,31 @@ void b2WeldJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2WeldJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+}
+
+void b2WeldJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+}
+
+void b2WeldJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_referenceAngle);
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+}
+
+void b2WeldJoint::ReadDefinition(b2BinaryReader* reader, b2WeldJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->referenceAngle);
+	reader->Read(&def->frequencyHz);
+	reader->Read(&def->dampingRatio);
+}
@@ -454,3 +454,41 @@ void b2WheelJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2WheelJoint::WriteState(b2BinaryWriter* writer) const
+{
+	writer->Write(m_impulse);
+	writer->Write(m_motorImpulse);
+	writer->Write(m_springImpulse);
+}
+
+void b2WheelJoint::ReadState(b2BinaryReader* reader)
+{
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&m_springImpulse);
+}
+
+void b2WheelJoint::WriteDefinition(b2BinaryWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_localXAxisA);
+	writer->Write(m_enableMotor);
+	writer->Write(m_motorSpeed);
+	writer->Write(m_maxMotorTorque);
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+}
+
+void b2WheelJoint::ReadDefinition(b2BinaryReader* reader, b2WheelJointDef* def)
+{
+	reader->Read(&def->localAnchorA);
+	reader->Read(&def->localAnchorB);
+	reader->Read(&def->localAxisA);
+	reader->Read(&def->enableMotor);
+	reader->Read(&def->motorSpeed);
+	reader->Read(&def->maxMotorTorque);
+	reader->Read(&def->frequencyHz);
+	reader->Read(&def->dampingRatio);
+}
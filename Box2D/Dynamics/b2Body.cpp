@@ -71,6 +71,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_prev = nullptr;
 	m_next = nullptr;
 
+	m_island = nullptr;
+	m_islandPrev = nullptr;
+	m_islandNext = nullptr;
+
 	m_linearVelocity = bd->linearVelocity;
 	m_angularVelocity = bd->angularVelocity;
 
@@ -151,6 +155,19 @@ void b2Body::SetType(b2BodyType type)
 	}
 	m_contactList = nullptr;
 
+	// Static bodies do not belong to islands.
+	if (IsActive())
+	{
+		if (m_type == b2_staticBody)
+		{
+			m_world->m_islandGraph.RemoveBody(this);
+		}
+		else if (m_island == nullptr)
+		{
+			m_world->m_islandGraph.AddBody(this);
+		}
+	}
+
 	// Touch the proxies so that new contacts will be created (when appropriate)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -171,11 +188,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return nullptr;
 	}
 
-	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
-
-	void* memory = allocator->Allocate(sizeof(b2Fixture));
-	b2Fixture* fixture = new (memory) b2Fixture;
-	fixture->Create(allocator, this, def);
+	b2Fixture* fixture = AttachFixture(def);
 
 	if (m_flags & e_activeFlag)
 	{
@@ -183,12 +196,6 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		fixture->CreateProxies(broadPhase, m_xf);
 	}
 
-	fixture->m_next = m_fixtureList;
-	m_fixtureList = fixture;
-	++m_fixtureCount;
-
-	fixture->m_body = this;
-
 	// Adjust mass properties if needed.
 	if (fixture->m_density > 0.0f)
 	{
@@ -202,6 +209,29 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	return fixture;
 }
 
+b2Fixture* b2Body::AttachFixture(const b2FixtureDef* def)
+{
+	// Terrain segments are paired when other proxies move, so the terrain must stay put.
+	b2Assert(def->shape->GetType() != b2Shape::e_terrain || m_type == b2_staticBody);
+
+	// Contacts and TOI treat a distance field as fixed.
+	b2Assert(def->shape->GetType() != b2Shape::e_distanceField || m_type == b2_staticBody);
+
+	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
+
+	void* memory = allocator->Allocate(sizeof(b2Fixture), b2_fixtureMemory);
+	b2Fixture* fixture = new (memory) b2Fixture;
+	fixture->Create(allocator, this, def);
+
+	fixture->m_next = m_fixtureList;
+	m_fixtureList = fixture;
+	++m_fixtureCount;
+
+	fixture->m_body = this;
+
+	return fixture;
+}
+
 b2Fixture* b2Body::CreateFixture(const b2Shape* shape, float32 density)
 {
 	b2FixtureDef def;
@@ -275,7 +305,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	fixture->m_next = nullptr;
 	fixture->Destroy(allocator);
 	fixture->~b2Fixture();
-	allocator->Free(fixture, sizeof(b2Fixture));
+	allocator->Free(fixture, sizeof(b2Fixture), b2_fixtureMemory);
 
 	--m_fixtureCount;
 
@@ -445,17 +475,57 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 
 void b2Body::SynchronizeFixtures()
 {
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+
+	float32 h = m_world->m_speculativeTime;
+	if (h > 0.0f)
+	{
+		// Cover the motion of the next step so speculative contacts exist before impact.
+		b2Transform xf2;
+		xf2.q.Set(m_sweep.a + h * m_angularVelocity);
+		xf2.p = m_sweep.c + h * m_linearVelocity - b2Mul(xf2.q, m_sweep.localCenter);
+
+		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+		{
+			f->Synchronize(broadPhase, m_xf, xf2);
+		}
+		return;
+	}
+
 	b2Transform xf1;
 	xf1.q.Set(m_sweep.a0);
 	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
 
-	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
 		f->Synchronize(broadPhase, xf1, m_xf);
 	}
 }
 
+void b2Body::SetAwake(bool flag)
+{
+	if (flag)
+	{
+		m_flags |= e_awakeFlag;
+		m_sleepTime = 0.0f;
+
+		if (m_island && m_island->awake == false)
+		{
+			m_world->m_islandGraph.WakeIsland(m_island);
+		}
+	}
+	else
+	{
+		// The island sleeps once all of its bodies are asleep.
+		m_flags &= ~e_awakeFlag;
+		m_sleepTime = 0.0f;
+		m_linearVelocity.SetZero();
+		m_angularVelocity = 0.0f;
+		m_force.SetZero();
+		m_torque = 0.0f;
+	}
+}
+
 void b2Body::SetActive(bool flag)
 {
 	b2Assert(m_world->IsLocked() == false);
@@ -476,6 +546,24 @@ void b2Body::SetActive(bool flag)
 			f->CreateProxies(broadPhase, m_xf);
 		}
 
+		// The step only clears forces of bodies in the island graph, so drop the
+		// forces applied while this body was inactive.
+		m_force.SetZero();
+		m_torque = 0.0f;
+
+		// Join the island graph. Joints to other active bodies are linked again.
+		if (m_type == b2_staticBody)
+		{
+			for (b2JointEdge* je = m_jointList; je; je = je->next)
+			{
+				m_world->m_islandGraph.LinkJoint(je->joint);
+			}
+		}
+		else
+		{
+			m_world->m_islandGraph.AddBody(this);
+		}
+
 		// Contacts are created the next time step.
 	}
 	else
@@ -498,6 +586,13 @@ void b2Body::SetActive(bool flag)
 			m_world->m_contactManager.Destroy(ce0->contact);
 		}
 		m_contactList = nullptr;
+
+		// Leave the island graph. Joints to inactive bodies are not simulated.
+		for (b2JointEdge* je = m_jointList; je; je = je->next)
+		{
+			m_world->m_islandGraph.UnlinkJoint(je->joint);
+		}
+		m_world->m_islandGraph.RemoveBody(this);
 	}
 }
 
@@ -31,6 +31,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2PersistentIsland;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -325,7 +326,7 @@ public:
 	bool IsSleepingAllowed() const;
 
 	/// Set the sleep state of the body. A sleeping body has very
-	/// low CPU cost.
+	/// low CPU cost. Waking a body wakes all bodies in its island.
 	/// @param flag set to true to wake the body, false to put it to sleep.
 	void SetAwake(bool flag);
 
@@ -393,6 +394,7 @@ private:
 
 	friend class b2World;
 	friend class b2Island;
+	friend class b2IslandGraph;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
@@ -427,6 +429,9 @@ private:
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
+	// Create a fixture without proxies or a mass update.
+	b2Fixture* AttachFixture(const b2FixtureDef* def);
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
@@ -439,6 +444,11 @@ private:
 
 	int32 m_islandIndex;
 
+	// The persistent island, null for static and inactive bodies.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
+
 	b2Transform m_xf;		// the body origin transform
 	b2Sweep m_sweep;		// the swept motion for CCD
 
@@ -636,24 +646,6 @@ inline bool b2Body::IsBullet() const
 	return (m_flags & e_bulletFlag) == e_bulletFlag;
 }
 
-inline void b2Body::SetAwake(bool flag)
-{
-	if (flag)
-	{
-		m_flags |= e_awakeFlag;
-		m_sleepTime = 0.0f;
-	}
-	else
-	{
-		m_flags &= ~e_awakeFlag;
-		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_force.SetZero();
-		m_torque = 0.0f;
-	}
-}
-
 inline bool b2Body::IsAwake() const
 {
 	return (m_flags & e_awakeFlag) == e_awakeFlag;
@@ -19,19 +19,118 @@
 #include "Box2D/Dynamics/b2ContactManager.h"
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Dynamics/b2World.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+
+#include <string.h>
 
 b2ContactFilter b2_defaultFilter;
-b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2AllocatorInterface* allocator) : m_broadPhase(allocator)
 {
 	m_contactList = nullptr;
 	m_contactCount = 0;
 	m_contactFilter = &b2_defaultFilter;
-	m_contactListener = &b2_defaultListener;
+	m_contactListener = nullptr;
 	m_allocator = nullptr;
+
+	m_arrayAllocator = allocator;
+	m_awakeContactCount = 0;
+	m_awakeContactCapacity = 16;
+	m_awakeContacts = (b2Contact**)b2Alloc(m_arrayAllocator, m_awakeContactCapacity * sizeof(b2Contact*), b2_contactMemory);
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_arrayAllocator, m_awakeContacts, m_awakeContactCapacity * sizeof(b2Contact*), b2_contactMemory);
+}
+
+bool b2ContactManager::ShouldBeAwake(const b2Contact* c) const
+{
+	const b2PersistentIsland* islandA = c->m_fixtureA->GetBody()->m_island;
+	const b2PersistentIsland* islandB = c->m_fixtureB->GetBody()->m_island;
+	return (islandA && islandA->awake) || (islandB && islandB->awake);
+}
+
+void b2ContactManager::AddAwakeContact(b2Contact* c)
+{
+	if (c->m_awakeIndex != -1)
+	{
+		return;
+	}
+
+	if (m_awakeContactCount == m_awakeContactCapacity)
+	{
+		b2Contact** oldContacts = m_awakeContacts;
+		m_awakeContactCapacity *= 2;
+		m_awakeContacts = (b2Contact**)b2Alloc(m_arrayAllocator, m_awakeContactCapacity * sizeof(b2Contact*), b2_contactMemory);
+		memcpy(m_awakeContacts, oldContacts, m_awakeContactCount * sizeof(b2Contact*));
+		b2Free(m_arrayAllocator, oldContacts, m_awakeContactCount * sizeof(b2Contact*), b2_contactMemory);
+	}
+
+	// A contact that slept missed the TOI reset at the start of the step.
+	c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+	c->m_toiCount = 0;
+	c->m_toi = 1.0f;
+
+	c->m_awakeIndex = m_awakeContactCount;
+	m_awakeContacts[m_awakeContactCount] = c;
+	++m_awakeContactCount;
+}
+
+void b2ContactManager::SetAwakeContacts(b2Contact* const* contacts, int32 count)
+{
+	for (int32 i = 0; i < m_awakeContactCount; ++i)
+	{
+		m_awakeContacts[i]->m_awakeIndex = -1;
+	}
+
+	if (count > m_awakeContactCapacity)
+	{
+		b2Free(m_arrayAllocator, m_awakeContacts, m_awakeContactCapacity * sizeof(b2Contact*), b2_contactMemory);
+		while (m_awakeContactCapacity < count)
+		{
+			m_awakeContactCapacity *= 2;
+		}
+		m_awakeContacts = (b2Contact**)b2Alloc(m_arrayAllocator, m_awakeContactCapacity * sizeof(b2Contact*), b2_contactMemory);
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(contacts[i]->m_awakeIndex == -1);
+		m_awakeContacts[i] = contacts[i];
+		contacts[i]->m_awakeIndex = i;
+	}
+	m_awakeContactCount = count;
+}
+
+void b2ContactManager::RemoveAwakeContact(b2Contact* c)
+{
+	int32 index = c->m_awakeIndex;
+	if (index == -1)
+	{
+		return;
+	}
+
+	b2Assert(0 <= index && index < m_awakeContactCount && m_awakeContacts[index] == c);
+	--m_awakeContactCount;
+	m_awakeContacts[index] = m_awakeContacts[m_awakeContactCount];
+	m_awakeContacts[index]->m_awakeIndex = index;
+	c->m_awakeIndex = -1;
+
+	// The TOI solver may have advanced the sweep of a sleeping or static body. Its
+	// contacts are no longer visited at the start of the step, so reset it here.
+	b2Body* bodies[2] = {c->m_fixtureA->GetBody(), c->m_fixtureB->GetBody()};
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2PersistentIsland* island = bodies[i]->m_island;
+		if (island == nullptr || island->awake == false)
+		{
+			bodies[i]->m_sweep.alpha0 = 0.0f;
+		}
+	}
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -41,11 +140,24 @@ void b2ContactManager::Destroy(b2Contact* c)
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
-	if (m_contactListener && c->IsTouching())
+	if (c->IsTouching() && (c->GetContactEvents() & b2_beginEndEvents))
 	{
-		m_contactListener->EndContact(c);
+		// Outside of the step the fixture is likely being destroyed, see b2Contact::Update.
+		b2World* world = bodyA->m_world;
+		if (world->IsLocked())
+		{
+			world->m_eventBuffer.AddTouch(fixtureA, fixtureB, fixtureA->IsSensor(), fixtureB->IsSensor(), false);
+		}
+
+		if (m_contactListener)
+		{
+			m_contactListener->EndContact(c);
+		}
 	}
 
+	bodyA->m_world->m_islandGraph.UnlinkContact(c);
+	RemoveAwakeContact(c);
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -99,15 +211,83 @@ void b2ContactManager::Destroy(b2Contact* c)
 	--m_contactCount;
 }
 
+// The narrow-phase is bound by memory latency, not arithmetic: each contact reads
+// its fixtures, bodies, shapes and broad-phase nodes from scattered blocks. The
+// awake array tells us which contacts come next, so the loads are issued in stages
+// ahead of the walk. Each stage reads pointers that an earlier stage brought in.
+void b2ContactManager::PrefetchAwakeContacts(int32 index) const
+{
+	enum
+	{
+		e_contactDistance = 12,
+		e_fixtureDistance = 9,
+		e_bodyDistance = 6,
+		e_proxyDistance = 4,
+		e_nodeDistance = 2
+	};
+
+	if (index + e_contactDistance < m_awakeContactCount)
+	{
+		const char* c = (const char*)m_awakeContacts[index + e_contactDistance];
+		for (int32 offset = 0; offset < (int32)sizeof(b2Contact); offset += 64)
+		{
+			b2Prefetch(c + offset);
+		}
+	}
+
+	if (index + e_fixtureDistance < m_awakeContactCount)
+	{
+		const b2Contact* c = m_awakeContacts[index + e_fixtureDistance];
+		b2Prefetch(c->m_fixtureA);
+		b2Prefetch(c->m_fixtureB);
+	}
+
+	if (index + e_bodyDistance < m_awakeContactCount)
+	{
+		const b2Contact* c = m_awakeContacts[index + e_bodyDistance];
+		const b2Fixture* fixtureA = c->m_fixtureA;
+		const b2Fixture* fixtureB = c->m_fixtureB;
+		b2Prefetch(fixtureA->m_body);
+		b2Prefetch((const char*)fixtureA->m_body + 64);
+		b2Prefetch(fixtureB->m_body);
+		b2Prefetch((const char*)fixtureB->m_body + 64);
+		b2Prefetch(fixtureA->m_shape);
+		b2Prefetch((const char*)fixtureA->m_shape + 64);
+		b2Prefetch((const char*)fixtureA->m_shape + 128);
+		b2Prefetch(fixtureB->m_shape);
+		b2Prefetch((const char*)fixtureB->m_shape + 64);
+		b2Prefetch((const char*)fixtureB->m_shape + 128);
+	}
+
+	// Terrain segments share one proxy, so finding the proxy reads the shape type.
+	if (index + e_proxyDistance < m_awakeContactCount)
+	{
+		const b2Contact* c = m_awakeContacts[index + e_proxyDistance];
+		b2Prefetch(c->m_fixtureA->GetProxy(c->m_indexA));
+		b2Prefetch(c->m_fixtureB->GetProxy(c->m_indexB));
+	}
+
+	if (index + e_nodeDistance < m_awakeContactCount)
+	{
+		const b2Contact* c = m_awakeContacts[index + e_nodeDistance];
+		b2Prefetch(&m_broadPhase.GetFatAABB(c->m_fixtureA->GetProxyId(c->m_indexA)));
+		b2Prefetch(&m_broadPhase.GetFatAABB(c->m_fixtureB->GetProxyId(c->m_indexB)));
+	}
+}
+
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
 void b2ContactManager::Collide()
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
+	// Update awake contacts. Destroying a contact moves the last awake contact
+	// into its slot, so the index only advances past surviving contacts.
+	int32 index = 0;
+	while (index < m_awakeContactCount)
 	{
+		PrefetchAwakeContacts(index);
+
+		b2Contact* c = m_awakeContacts[index];
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -121,18 +301,14 @@ void b2ContactManager::Collide()
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Check user filtering.
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
@@ -146,26 +322,35 @@ void b2ContactManager::Collide()
 		// At least one body must be awake and it must be dynamic or kinematic.
 		if (activeA == false && activeB == false)
 		{
-			c = c->GetNext();
+			++index;
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
 		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		bool overlap;
+		if (fixtureA->m_shape->m_type == b2Shape::e_terrain)
+		{
+			// A terrain segment has no proxy of its own, so test the segment box.
+			b2AABB aabbA;
+			((const b2TerrainShape*)fixtureA->m_shape)->ComputeSegmentAABB(&aabbA, bodyA->GetTransform(), indexA);
+			overlap = b2TestOverlap(aabbA, m_broadPhase.GetFatAABB(proxyIdB));
+		}
+		else
+		{
+			int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+			overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		}
 
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Destroy(c);
 			continue;
 		}
 
 		// The contact persists.
 		c->Update(m_contactListener);
-		c = c->GetNext();
+		++index;
 	}
 }
 
@@ -174,17 +359,62 @@ void b2ContactManager::FindNewContacts()
 	m_broadPhase.UpdatePairs(this);
 }
 
+// Pairs each terrain segment that overlaps a proxy.
+struct b2TerrainPairCallback
+{
+	bool QueryCallback(int32 index)
+	{
+		manager->AddContact(terrain, index, proxy->fixture, proxy->childIndex);
+		return true;
+	}
+
+	b2ContactManager* manager;
+	b2Fixture* terrain;
+	const b2FixtureProxy* proxy;
+};
+
 void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 {
 	b2FixtureProxy* proxyA = (b2FixtureProxy*)proxyUserDataA;
 	b2FixtureProxy* proxyB = (b2FixtureProxy*)proxyUserDataB;
 
-	b2Fixture* fixtureA = proxyA->fixture;
-	b2Fixture* fixtureB = proxyB->fixture;
+	// A terrain has one proxy for all of its segments. The pair is reported
+	// again whenever the other proxy moves, so new segments are picked up then.
+	b2FixtureProxy* terrainProxy = nullptr;
+	b2FixtureProxy* otherProxy = nullptr;
+	if (proxyA->fixture->m_shape->m_type == b2Shape::e_terrain)
+	{
+		terrainProxy = proxyA;
+		otherProxy = proxyB;
+	}
+	else if (proxyB->fixture->m_shape->m_type == b2Shape::e_terrain)
+	{
+		terrainProxy = proxyB;
+		otherProxy = proxyA;
+	}
+
+	if (terrainProxy == nullptr)
+	{
+		AddContact(proxyA->fixture, proxyA->childIndex, proxyB->fixture, proxyB->childIndex);
+		return;
+	}
+
+	b2Fixture* terrain = terrainProxy->fixture;
+	if (otherProxy->fixture->m_shape->m_type == b2Shape::e_terrain || otherProxy->fixture->m_body == terrain->m_body)
+	{
+		return;
+	}
 
-	int32 indexA = proxyA->childIndex;
-	int32 indexB = proxyB->childIndex;
+	b2TerrainPairCallback callback;
+	callback.manager = this;
+	callback.terrain = terrain;
+	callback.proxy = otherProxy;
+	const b2TerrainShape* shape = (const b2TerrainShape*)terrain->m_shape;
+	shape->Query(&callback, m_broadPhase.GetFatAABB(otherProxy->proxyId), terrain->m_body->GetTransform());
+}
 
+void b2ContactManager::AddContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+{
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
@@ -242,13 +472,21 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	Link(c);
+
+	// Wake up the bodies
+	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
+	}
+}
+
+void b2ContactManager::Link(b2Contact* c)
+{
 	// Contact creation may swap fixtures.
-	fixtureA = c->GetFixtureA();
-	fixtureB = c->GetFixtureB();
-	indexA = c->GetChildIndexA();
-	indexB = c->GetChildIndexB();
-	bodyA = fixtureA->GetBody();
-	bodyB = fixtureB->GetBody();
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
 
 	// Insert into the world.
 	c->m_prev = nullptr;
@@ -259,7 +497,11 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	m_contactList = c;
 
-	// Connect to island graph.
+	// Connect to the awake contacts.
+	if (ShouldBeAwake(c))
+	{
+		AddAwakeContact(c);
+	}
 
 	// Connect to body A
 	c->m_nodeA.contact = c;
@@ -285,12 +527,5 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
-	// Wake up the bodies
-	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
-	{
-		bodyA->SetAwake(true);
-		bodyB->SetAwake(true);
-	}
-
 	++m_contactCount;
 }
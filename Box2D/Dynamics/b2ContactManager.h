@@ -22,6 +22,7 @@
 #include "Box2D/Collision/b2BroadPhase.h"
 
 class b2Contact;
+class b2Fixture;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
@@ -30,23 +31,46 @@ class b2BlockAllocator;
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2AllocatorInterface* allocator = nullptr);
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
 
+	// Create a contact between two fixture children unless it exists or is filtered.
+	void AddContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+
 	void FindNewContacts();
 
+	// Add a new contact to the world list and the body contact lists.
+	void Link(b2Contact* c);
+
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// Start loading the contacts ahead of the given awake index.
+	void PrefetchAwakeContacts(int32 index) const;
+
+	// Contacts with a body in an awake island are awake. Collide and the TOI
+	// solver only visit the awake contacts, so sleeping content costs nothing.
+	void AddAwakeContact(b2Contact* c);
+	void RemoveAwakeContact(b2Contact* c);
+	bool ShouldBeAwake(const b2Contact* c) const;
+
+	// Replace the awake contacts, keeping their TOI state. Used to restore a snapshot.
+	void SetAwakeContacts(b2Contact* const* contacts, int32 count);
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
+	b2Contact** m_awakeContacts;
+	int32 m_awakeContactCount;
+	int32 m_awakeContactCapacity;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2AllocatorInterface* m_arrayAllocator;
 };
 
 #endif
@@ -0,0 +1,185 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_EVENT_BUFFER_H
+#define B2_EVENT_BUFFER_H
+
+#include "Box2D/Common/b2AllocatorInterface.h"
+#include "Box2D/Dynamics/b2WorldCallbacks.h"
+#include <string.h>
+
+/// A growable array of events that keeps its capacity when cleared, so a
+/// world that settles into a steady event rate stops allocating.
+/// This is an internal class.
+template <typename T>
+class b2EventArray
+{
+public:
+	b2EventArray()
+	{
+		m_events = nullptr;
+		m_count = 0;
+		m_capacity = 0;
+	}
+
+	void Destroy(b2AllocatorInterface* allocator)
+	{
+		b2Free(allocator, m_events, m_capacity * sizeof(T), b2_contactMemory);
+		m_events = nullptr;
+		m_count = 0;
+		m_capacity = 0;
+	}
+
+	void Push(b2AllocatorInterface* allocator, const T& event)
+	{
+		if (m_count == m_capacity)
+		{
+			T* oldEvents = m_events;
+			int32 oldCapacity = m_capacity;
+			m_capacity = oldCapacity > 0 ? 2 * oldCapacity : 16;
+			m_events = (T*)b2Alloc(allocator, m_capacity * sizeof(T), b2_contactMemory);
+			if (oldEvents)
+			{
+				memcpy(m_events, oldEvents, m_count * sizeof(T));
+				b2Free(allocator, oldEvents, oldCapacity * sizeof(T), b2_contactMemory);
+			}
+		}
+
+		m_events[m_count] = event;
+		++m_count;
+	}
+
+	void Clear()
+	{
+		m_count = 0;
+	}
+
+	const T* GetData() const
+	{
+		return m_events;
+	}
+
+	int32 GetCount() const
+	{
+		return m_count;
+	}
+
+private:
+	T* m_events;
+	int32 m_count;
+	int32 m_capacity;
+};
+
+/// The contact events of one time step. Events are appended where the
+/// contacts are updated and destroyed, which is always on the thread that
+/// calls b2World::Step. The parallel TOI solve only touches bodies, so no
+/// event is written concurrently.
+/// This is an internal class.
+class b2EventBuffer
+{
+public:
+	/// The arrays come from the optional allocator interface as b2_contactMemory.
+	b2EventBuffer(b2AllocatorInterface* allocator = nullptr)
+	{
+		m_allocator = allocator;
+	}
+
+	~b2EventBuffer()
+	{
+		m_beginEvents.Destroy(m_allocator);
+		m_endEvents.Destroy(m_allocator);
+		m_sensorBeginEvents.Destroy(m_allocator);
+		m_sensorEndEvents.Destroy(m_allocator);
+		m_hitEvents.Destroy(m_allocator);
+	}
+
+	void Clear()
+	{
+		m_beginEvents.Clear();
+		m_endEvents.Clear();
+		m_sensorBeginEvents.Clear();
+		m_sensorEndEvents.Clear();
+		m_hitEvents.Clear();
+	}
+
+	/// Add a begin or end event. Sensor contacts go to the sensor arrays.
+	void AddTouch(b2Fixture* fixtureA, b2Fixture* fixtureB, bool sensorA, bool sensorB, bool begin);
+
+	void AddHit(const b2ContactHitEvent& event)
+	{
+		m_hitEvents.Push(m_allocator, event);
+	}
+
+	void GetEvents(b2StepEvents* events) const;
+
+private:
+	b2AllocatorInterface* m_allocator;
+
+	b2EventArray<b2ContactTouchEvent> m_beginEvents;
+	b2EventArray<b2ContactTouchEvent> m_endEvents;
+	b2EventArray<b2SensorEvent> m_sensorBeginEvents;
+	b2EventArray<b2SensorEvent> m_sensorEndEvents;
+	b2EventArray<b2ContactHitEvent> m_hitEvents;
+};
+
+inline void b2EventBuffer::AddTouch(b2Fixture* fixtureA, b2Fixture* fixtureB, bool sensorA, bool sensorB, bool begin)
+{
+	if (sensorA || sensorB)
+	{
+		b2SensorEvent event;
+		event.sensor = sensorA ? fixtureA : fixtureB;
+		event.visitor = sensorA ? fixtureB : fixtureA;
+		if (begin)
+		{
+			m_sensorBeginEvents.Push(m_allocator, event);
+		}
+		else
+		{
+			m_sensorEndEvents.Push(m_allocator, event);
+		}
+		return;
+	}
+
+	b2ContactTouchEvent event;
+	event.fixtureA = fixtureA;
+	event.fixtureB = fixtureB;
+	if (begin)
+	{
+		m_beginEvents.Push(m_allocator, event);
+	}
+	else
+	{
+		m_endEvents.Push(m_allocator, event);
+	}
+}
+
+inline void b2EventBuffer::GetEvents(b2StepEvents* events) const
+{
+	events->beginEvents = m_beginEvents.GetData();
+	events->beginCount = m_beginEvents.GetCount();
+	events->endEvents = m_endEvents.GetData();
+	events->endCount = m_endEvents.GetCount();
+	events->sensorBeginEvents = m_sensorBeginEvents.GetData();
+	events->sensorBeginCount = m_sensorBeginEvents.GetCount();
+	events->sensorEndEvents = m_sensorEndEvents.GetData();
+	events->sensorEndCount = m_sensorEndEvents.GetCount();
+	events->hitEvents = m_hitEvents.GetData();
+	events->hitCount = m_hitEvents.GetCount();
+}
+
+#endif
@@ -23,6 +23,9 @@
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
 #include "Box2D/Collision/b2BroadPhase.h"
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Common/b2BlockAllocator.h"
@@ -51,11 +54,13 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
 
 	m_isSensor = def->isSensor;
 
+	m_contactEvents = def->contactEvents;
+
 	m_shape = def->shape->Clone(allocator);
 
 	// Reserve proxy space
 	int32 childCount = m_shape->GetChildCount();
-	m_proxies = (b2FixtureProxy*)allocator->Allocate(childCount * sizeof(b2FixtureProxy));
+	m_proxies = (b2FixtureProxy*)allocator->Allocate(childCount * sizeof(b2FixtureProxy), b2_fixtureMemory);
 	for (int32 i = 0; i < childCount; ++i)
 	{
 		m_proxies[i].fixture = nullptr;
@@ -73,7 +78,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 
 	// Free the proxy array.
 	int32 childCount = m_shape->GetChildCount();
-	allocator->Free(m_proxies, childCount * sizeof(b2FixtureProxy));
+	allocator->Free(m_proxies, childCount * sizeof(b2FixtureProxy), b2_fixtureMemory);
 	m_proxies = nullptr;
 
 	// Free the child shape.
@@ -83,7 +88,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 		{
 			b2CircleShape* s = (b2CircleShape*)m_shape;
 			s->~b2CircleShape();
-			allocator->Free(s, sizeof(b2CircleShape));
+			allocator->Free(s, sizeof(b2CircleShape), b2_fixtureMemory);
 		}
 		break;
 
@@ -91,7 +96,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 		{
 			b2EdgeShape* s = (b2EdgeShape*)m_shape;
 			s->~b2EdgeShape();
-			allocator->Free(s, sizeof(b2EdgeShape));
+			allocator->Free(s, sizeof(b2EdgeShape), b2_fixtureMemory);
 		}
 		break;
 
@@ -99,7 +104,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 		{
 			b2PolygonShape* s = (b2PolygonShape*)m_shape;
 			s->~b2PolygonShape();
-			allocator->Free(s, sizeof(b2PolygonShape));
+			allocator->Free(s, sizeof(b2PolygonShape), b2_fixtureMemory);
 		}
 		break;
 
@@ -107,7 +112,31 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 		{
 			b2ChainShape* s = (b2ChainShape*)m_shape;
 			s->~b2ChainShape();
-			allocator->Free(s, sizeof(b2ChainShape));
+			allocator->Free(s, sizeof(b2ChainShape), b2_fixtureMemory);
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+			s->~b2CapsuleShape();
+			allocator->Free(s, sizeof(b2CapsuleShape), b2_fixtureMemory);
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			b2TerrainShape* s = (b2TerrainShape*)m_shape;
+			s->~b2TerrainShape();
+			allocator->Free(s, sizeof(b2TerrainShape), b2_fixtureMemory);
+		}
+		break;
+
+	case b2Shape::e_distanceField:
+		{
+			b2DistanceFieldShape* s = (b2DistanceFieldShape*)m_shape;
+			s->~b2DistanceFieldShape();
+			allocator->Free(s, sizeof(b2DistanceFieldShape), b2_fixtureMemory);
 		}
 		break;
 
@@ -236,6 +265,7 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("    fd.filter.categoryBits = uint16(%d);\n", m_filter.categoryBits);
 	b2Log("    fd.filter.maskBits = uint16(%d);\n", m_filter.maskBits);
 	b2Log("    fd.filter.groupIndex = int16(%d);\n", m_filter.groupIndex);
+	b2Log("    fd.contactEvents = uint16(%d);\n", m_contactEvents);
 
 	switch (m_shape->m_type)
 	{
@@ -292,6 +322,33 @@ void b2Fixture::Dump(int32 bodyIndex)
 		}
 		break;
 
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+			b2Log("    b2CapsuleShape shape;\n");
+			b2Log("    shape.m_radius = %.15lef;\n", s->m_radius);
+			b2Log("    shape.m_vertex1.Set(%.15lef, %.15lef);\n", s->m_vertex1.x, s->m_vertex1.y);
+			b2Log("    shape.m_vertex2.Set(%.15lef, %.15lef);\n", s->m_vertex2.x, s->m_vertex2.y);
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			b2TerrainShape* s = (b2TerrainShape*)m_shape;
+			b2Log("    b2TerrainShape shape;\n");
+			b2Log("    b2Vec2 vs[%d];\n", s->m_count);
+			for (int32 i = 0; i < s->m_count; ++i)
+			{
+				b2Log("    vs[%d].Set(%.15lef, %.15lef);\n", i, s->m_vertices[i].x, s->m_vertices[i].y);
+			}
+			b2Log("    shape.Create(vs, %d);\n", s->m_count);
+			b2Log("    shape.m_prevVertex.Set(%.15lef, %.15lef);\n", s->m_prevVertex.x, s->m_prevVertex.y);
+			b2Log("    shape.m_nextVertex.Set(%.15lef, %.15lef);\n", s->m_nextVertex.x, s->m_nextVertex.y);
+			b2Log("    shape.m_hasPrevVertex = bool(%d);\n", s->m_hasPrevVertex);
+			b2Log("    shape.m_hasNextVertex = bool(%d);\n", s->m_hasNextVertex);
+		}
+		break;
+
 	default:
 		return;
 	}
@@ -51,6 +51,20 @@ struct b2Filter
 	int16 groupIndex;
 };
 
+/// The contact events a fixture asks for. A contact reports an event if
+/// either of its fixtures asks for it. Events nobody asks for are skipped
+/// without calling the listener. Begin and end events also go to the step
+/// events of the world, see b2World::GetStepEvents.
+enum b2ContactEventFlags
+{
+	b2_beginEndEvents		= 0x0001,	///< BeginContact, EndContact and the touch and sensor events
+	b2_preSolveEvents		= 0x0002,	///< PreSolve
+	b2_postSolveEvents		= 0x0004,	///< PostSolve
+	b2_hitEvents			= 0x0008,	///< hit events faster than b2World::SetHitEventThreshold
+	b2_defaultContactEvents	= 0x0007,
+	b2_allContactEvents		= 0x000F
+};
+
 /// A fixture definition is used to create a fixture. This class defines an
 /// abstract fixture definition. You can reuse fixture definitions safely.
 struct b2FixtureDef
@@ -64,6 +78,7 @@ struct b2FixtureDef
 		restitution = 0.0f;
 		density = 0.0f;
 		isSensor = false;
+		contactEvents = b2_defaultContactEvents;
 	}
 
 	/// The shape, this must be set. The shape will be cloned, so you
@@ -88,6 +103,9 @@ struct b2FixtureDef
 
 	/// Contact filtering data.
 	b2Filter filter;
+
+	/// The contact events of this fixture, see b2ContactEventFlags.
+	uint16 contactEvents;
 };
 
 /// This proxy is used internally to connect fixtures to the broad-phase.
@@ -132,6 +150,14 @@ public:
 	/// Get the contact filtering data.
 	const b2Filter& GetFilterData() const;
 
+	/// Set the contact events of this fixture, see b2ContactEventFlags.
+	/// This takes effect immediately, so contacts that are touching do not get
+	/// an EndContact if begin and end events are turned off.
+	void SetContactEvents(uint16 events);
+
+	/// Get the contact events of this fixture.
+	uint16 GetContactEvents() const;
+
 	/// Call this if you want to establish collision that was previously disabled by b2ContactFilter::ShouldCollide.
 	void Refilter();
 
@@ -215,6 +241,10 @@ protected:
 
 	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
+	// The broad-phase proxy of a contact child. Terrain segments share one proxy.
+	const b2FixtureProxy* GetProxy(int32 childIndex) const;
+	int32 GetProxyId(int32 childIndex) const;
+
 	float32 m_density;
 
 	b2Fixture* m_next;
@@ -232,6 +262,8 @@ protected:
 
 	bool m_isSensor;
 
+	uint16 m_contactEvents;
+
 	void* m_userData;
 };
 
@@ -260,6 +292,16 @@ inline const b2Filter& b2Fixture::GetFilterData() const
 	return m_filter;
 }
 
+inline void b2Fixture::SetContactEvents(uint16 events)
+{
+	m_contactEvents = events;
+}
+
+inline uint16 b2Fixture::GetContactEvents() const
+{
+	return m_contactEvents;
+}
+
 inline void* b2Fixture::GetUserData() const
 {
 	return m_userData;
@@ -336,6 +378,16 @@ inline void b2Fixture::GetMassData(b2MassData* massData) const
 	m_shape->ComputeMass(massData, m_density);
 }
 
+inline const b2FixtureProxy* b2Fixture::GetProxy(int32 childIndex) const
+{
+	return m_proxies + (m_shape->m_type == b2Shape::e_terrain ? 0 : childIndex);
+}
+
+inline int32 b2Fixture::GetProxyId(int32 childIndex) const
+{
+	return GetProxy(childIndex)->proxyId;
+}
+
 inline const b2AABB& b2Fixture::GetAABB(int32 childIndex) const
 {
 	b2Assert(0 <= childIndex && childIndex < m_proxyCount);
@@ -27,6 +27,8 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Timer.h"
 
+#include <new>
+
 /*
 Position Correction Notes
 =========================
@@ -158,6 +160,8 @@ b2Island::b2Island(
 	m_bodyCount = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
+	m_rangeCount = 0;
+	m_toiSolver = nullptr;
 
 	m_allocator = allocator;
 	m_listener = listener;
@@ -168,10 +172,15 @@ b2Island::b2Island(
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+
+	// Each island has at least one body.
+	m_ranges = (b2IslandRange*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2IslandRange));
 }
 
 b2Island::~b2Island()
 {
+	b2Assert(m_toiSolver == nullptr);
+	m_allocator->Free(m_ranges);
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
@@ -184,6 +193,12 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 {
 	b2Timer timer;
 
+	// A single island does not need to be ended by the caller.
+	if (m_rangeCount == 0 || m_ranges[m_rangeCount - 1].bodyEnd != m_bodyCount)
+	{
+		EndIsland();
+	}
+
 	float32 h = step.dt;
 
 	// Integrate velocities and apply damping. Initialize the body state.
@@ -304,26 +319,35 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		m_velocities[i].w = w;
 	}
 
-	// Solve position constraints
+	// Solve position constraints. The islands are independent, so each one
+	// exits early on its own.
 	timer.Reset();
-	bool positionSolved = false;
-	for (int32 i = 0; i < step.positionIterations; ++i)
+	int32 contactStart = 0;
+	int32 jointStart = 0;
+	for (int32 r = 0; r < m_rangeCount; ++r)
 	{
-		bool contactsOkay = contactSolver.SolvePositionConstraints();
-
-		bool jointsOkay = true;
-		for (int32 j = 0; j < m_jointCount; ++j)
+		b2IslandRange* range = m_ranges + r;
+		for (int32 i = 0; i < step.positionIterations; ++i)
 		{
-			bool jointOkay = m_joints[j]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+			bool contactsOkay = contactSolver.SolvePositionConstraints(contactStart, range->contactEnd - contactStart);
 
-		if (contactsOkay && jointsOkay)
-		{
-			// Exit early if the position errors are small.
-			positionSolved = true;
-			break;
+			bool jointsOkay = true;
+			for (int32 j = jointStart; j < range->jointEnd; ++j)
+			{
+				bool jointOkay = m_joints[j]->SolvePositionConstraints(solverData);
+				jointsOkay = jointsOkay && jointOkay;
+			}
+
+			if (contactsOkay && jointsOkay)
+			{
+				// Exit early if the position errors are small.
+				range->positionSolved = true;
+				break;
+			}
 		}
+
+		contactStart = range->contactEnd;
+		jointStart = range->jointEnd;
 	}
 
 	// Copy state buffers back to the bodies
@@ -341,14 +365,21 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	Report(contactSolver.m_velocityConstraints);
 
-	if (allowSleep)
+	if (allowSleep == false)
 	{
-		float32 minSleepTime = b2_maxFloat;
+		return;
+	}
 
-		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+	const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
+	const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
 
-		for (int32 i = 0; i < m_bodyCount; ++i)
+	int32 bodyStart = 0;
+	for (int32 r = 0; r < m_rangeCount; ++r)
+	{
+		b2IslandRange* range = m_ranges + r;
+		float32 minSleepTime = b2_maxFloat;
+
+		for (int32 i = bodyStart; i < range->bodyEnd; ++i)
 		{
 			b2Body* b = m_bodies[i];
 			if (b->GetType() == b2_staticBody)
@@ -370,21 +401,38 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			}
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		if (minSleepTime >= b2_timeToSleep && range->positionSolved)
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
+			for (int32 i = bodyStart; i < range->bodyEnd; ++i)
 			{
 				b2Body* b = m_bodies[i];
 				b->SetAwake(false);
 			}
+
+			range->sleeping = true;
 		}
+
+		bodyStart = range->bodyEnd;
 	}
 }
 
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
+{
+	PrepareTOI(subStep, toiIndexA, toiIndexB);
+	SolveTOIConstraints();
+	FinishTOI();
+	ReleaseTOI();
+}
+
+void b2Island::PrepareTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
 {
 	b2Assert(toiIndexA < m_bodyCount);
 	b2Assert(toiIndexB < m_bodyCount);
+	b2Assert(m_toiSolver == nullptr);
+
+	m_subStep = subStep;
+	m_toiIndexA = toiIndexA;
+	m_toiIndexB = toiIndexB;
 
 	// Initialize the body state.
 	for (int32 i = 0; i < m_bodyCount; ++i)
@@ -403,12 +451,21 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	contactSolverDef.step = subStep;
 	contactSolverDef.positions = m_positions;
 	contactSolverDef.velocities = m_velocities;
-	b2ContactSolver contactSolver(&contactSolverDef);
+
+	void* mem = m_allocator->Allocate(sizeof(b2ContactSolver));
+	m_toiSolver = new (mem) b2ContactSolver(&contactSolverDef);
+}
+
+void b2Island::SolveTOIConstraints()
+{
+	b2ContactSolver* contactSolver = m_toiSolver;
+	int32 toiIndexA = m_toiIndexA;
+	int32 toiIndexB = m_toiIndexB;
 
 	// Solve position constraints.
-	for (int32 i = 0; i < subStep.positionIterations; ++i)
+	for (int32 i = 0; i < m_subStep.positionIterations; ++i)
 	{
-		bool contactsOkay = contactSolver.SolveTOIPositionConstraints(toiIndexA, toiIndexB);
+		bool contactsOkay = contactSolver->SolveTOIPositionConstraints(toiIndexA, toiIndexB);
 		if (contactsOkay)
 		{
 			break;
@@ -448,26 +505,24 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	}
 #endif
 
-	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	// Leap of faith to new safe state. The bodies are updated in FinishTOI.
+	m_toiPositionA = m_positions[toiIndexA];
+	m_toiPositionB = m_positions[toiIndexB];
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
-	contactSolver.InitializeVelocityConstraints();
+	contactSolver->InitializeVelocityConstraints();
 
 	// Solve velocity constraints.
-	for (int32 i = 0; i < subStep.velocityIterations; ++i)
+	for (int32 i = 0; i < m_subStep.velocityIterations; ++i)
 	{
-		contactSolver.SolveVelocityConstraints();
+		contactSolver->SolveVelocityConstraints();
 	}
 
 	// Don't store the TOI contact forces for warm starting
 	// because they can be quite large.
 
-	float32 h = subStep.dt;
+	float32 h = m_subStep.dt;
 
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
@@ -500,17 +555,35 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 		m_positions[i].a = a;
 		m_velocities[i].v = v;
 		m_velocities[i].w = w;
+	}
+}
+
+void b2Island::FinishTOI()
+{
+	m_bodies[m_toiIndexA]->m_sweep.c0 = m_toiPositionA.c;
+	m_bodies[m_toiIndexA]->m_sweep.a0 = m_toiPositionA.a;
+	m_bodies[m_toiIndexB]->m_sweep.c0 = m_toiPositionB.c;
+	m_bodies[m_toiIndexB]->m_sweep.a0 = m_toiPositionB.a;
 
-		// Sync bodies
+	// Sync bodies
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
+		body->m_sweep.c = m_positions[i].c;
+		body->m_sweep.a = m_positions[i].a;
+		body->m_linearVelocity = m_velocities[i].v;
+		body->m_angularVelocity = m_velocities[i].w;
 		body->SynchronizeTransform();
 	}
 
-	Report(contactSolver.m_velocityConstraints);
+	Report(m_toiSolver->m_velocityConstraints);
+}
+
+void b2Island::ReleaseTOI()
+{
+	m_toiSolver->~b2ContactSolver();
+	m_allocator->Free(m_toiSolver);
+	m_toiSolver = nullptr;
 }
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
@@ -523,6 +596,10 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 	for (int32 i = 0; i < m_contactCount; ++i)
 	{
 		b2Contact* c = m_contacts[i];
+		if ((c->GetContactEvents() & b2_postSolveEvents) == 0)
+		{
+			continue;
+		}
 
 		const b2ContactVelocityConstraint* vc = constraints + i;
 		
@@ -27,9 +27,21 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactSolver;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
+/// The end of one island in the arrays of a batch. Islands of a batch share
+/// the solver setup but converge and sleep on their own.
+struct b2IslandRange
+{
+	int32 bodyEnd;
+	int32 contactEnd;
+	int32 jointEnd;
+	bool positionSolved;
+	bool sleeping;
+};
+
 /// This is an internal class.
 class b2Island
 {
@@ -43,12 +55,36 @@ public:
 		m_bodyCount = 0;
 		m_contactCount = 0;
 		m_jointCount = 0;
+		m_rangeCount = 0;
 	}
 
+	// End the island being added. Solve handles all ended islands in one batch.
+	void EndIsland()
+	{
+		b2Assert(m_rangeCount < m_bodyCapacity);
+		b2IslandRange* range = m_ranges + m_rangeCount;
+		range->bodyEnd = m_bodyCount;
+		range->contactEnd = m_contactCount;
+		range->jointEnd = m_jointCount;
+		range->positionSolved = false;
+		range->sleeping = false;
+		++m_rangeCount;
+	}
+
+	// Solve the batch. The islands that fell asleep are flagged in their range.
 	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
 
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
+	// SolveTOI in parts. PrepareTOI and FinishTOI touch the bodies and the listener, so
+	// they run on the calling thread. SolveTOIConstraints only touches the island, so
+	// islands without common moving bodies may solve concurrently. Islands prepared
+	// together are released in reverse order because the solvers use the stack allocator.
+	void PrepareTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
+	void SolveTOIConstraints();
+	void FinishTOI();
+	void ReleaseTOI();
+
 	void Add(b2Body* body)
 	{
 		b2Assert(m_bodyCount < m_bodyCapacity);
@@ -81,6 +117,17 @@ public:
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	b2IslandRange* m_ranges;
+	int32 m_rangeCount;
+
+	// The state of a prepared TOI solve.
+	b2ContactSolver* m_toiSolver;
+	b2TimeStep m_subStep;
+	int32 m_toiIndexA;
+	int32 m_toiIndexB;
+	b2Position m_toiPositionA;
+	b2Position m_toiPositionB;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
@@ -0,0 +1,596 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/b2IslandGraph.h"
+#include "Box2D/Dynamics/b2Body.h"
+#include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Dynamics/b2ContactManager.h"
+#include "Box2D/Dynamics/Contacts/b2Contact.h"
+#include "Box2D/Dynamics/Joints/b2Joint.h"
+#include "Box2D/Common/b2BlockAllocator.h"
+#include "Box2D/Common/b2StackAllocator.h"
+
+b2IslandGraph::b2IslandGraph()
+{
+	m_awakeList = nullptr;
+	m_sleepingList = nullptr;
+	m_awakeCount = 0;
+	m_sleepingCount = 0;
+	m_allocator = nullptr;
+	m_contactManager = nullptr;
+}
+
+b2PersistentIsland* b2IslandGraph::CreateIsland(bool awake)
+{
+	void* mem = m_allocator->Allocate(sizeof(b2PersistentIsland), b2_islandMemory);
+	b2PersistentIsland* island = (b2PersistentIsland*)mem;
+	island->bodyList = nullptr;
+	island->bodyTail = nullptr;
+	island->bodyCount = 0;
+	island->contactList = nullptr;
+	island->contactTail = nullptr;
+	island->contactCount = 0;
+	island->jointList = nullptr;
+	island->jointTail = nullptr;
+	island->jointCount = 0;
+	island->constraintRemoveCount = 0;
+	island->awake = awake;
+	AddToList(island);
+	return island;
+}
+
+void b2IslandGraph::DestroyIsland(b2PersistentIsland* island)
+{
+	b2Assert(island->bodyCount == 0);
+	b2Assert(island->contactCount == 0);
+	b2Assert(island->jointCount == 0);
+	RemoveFromList(island);
+	m_allocator->Free(island, sizeof(b2PersistentIsland), b2_islandMemory);
+}
+
+void b2IslandGraph::AddToList(b2PersistentIsland* island)
+{
+	b2PersistentIsland** list = island->awake ? &m_awakeList : &m_sleepingList;
+	island->prev = nullptr;
+	island->next = *list;
+	if (*list)
+	{
+		(*list)->prev = island;
+	}
+	*list = island;
+
+	if (island->awake)
+	{
+		++m_awakeCount;
+	}
+	else
+	{
+		++m_sleepingCount;
+	}
+}
+
+void b2IslandGraph::RemoveFromList(b2PersistentIsland* island)
+{
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_awakeList)
+	{
+		m_awakeList = island->next;
+	}
+	else if (island == m_sleepingList)
+	{
+		m_sleepingList = island->next;
+	}
+
+	if (island->awake)
+	{
+		--m_awakeCount;
+	}
+	else
+	{
+		--m_sleepingCount;
+	}
+}
+
+// Each member type has m_island, m_islandPrev and m_islandNext.
+template <typename T>
+void b2IslandGraph::AppendNode(b2PersistentIsland* island, T** head, T** tail, int32* count, T* node)
+{
+	node->m_island = island;
+	node->m_islandPrev = *tail;
+	node->m_islandNext = nullptr;
+	if (*tail)
+	{
+		(*tail)->m_islandNext = node;
+	}
+	else
+	{
+		*head = node;
+	}
+	*tail = node;
+	++(*count);
+}
+
+template <typename T>
+void b2IslandGraph::RemoveNode(T** head, T** tail, int32* count, T* node)
+{
+	if (node->m_islandPrev)
+	{
+		node->m_islandPrev->m_islandNext = node->m_islandNext;
+	}
+	else
+	{
+		*head = node->m_islandNext;
+	}
+
+	if (node->m_islandNext)
+	{
+		node->m_islandNext->m_islandPrev = node->m_islandPrev;
+	}
+	else
+	{
+		*tail = node->m_islandPrev;
+	}
+
+	node->m_island = nullptr;
+	node->m_islandPrev = nullptr;
+	node->m_islandNext = nullptr;
+	--(*count);
+}
+
+template <typename T>
+void b2IslandGraph::SpliceList(b2PersistentIsland* island, T** head, T** tail, T* list, T* listTail)
+{
+	if (list == nullptr)
+	{
+		return;
+	}
+
+	for (T* node = list; node; node = node->m_islandNext)
+	{
+		node->m_island = island;
+	}
+
+	list->m_islandPrev = *tail;
+	if (*tail)
+	{
+		(*tail)->m_islandNext = list;
+	}
+	else
+	{
+		*head = list;
+	}
+	*tail = listTail;
+}
+
+void b2IslandGraph::Append(b2PersistentIsland* island, b2Body* body)
+{
+	AppendNode(island, &island->bodyList, &island->bodyTail, &island->bodyCount, body);
+}
+
+void b2IslandGraph::Append(b2PersistentIsland* island, b2Contact* contact)
+{
+	AppendNode(island, &island->contactList, &island->contactTail, &island->contactCount, contact);
+}
+
+void b2IslandGraph::Append(b2PersistentIsland* island, b2Joint* joint)
+{
+	AppendNode(island, &island->jointList, &island->jointTail, &island->jointCount, joint);
+}
+
+void b2IslandGraph::AddBody(b2Body* body)
+{
+	b2Assert(body->m_island == nullptr);
+	b2Assert(body->IsActive() && body->m_type != b2_staticBody);
+
+	b2PersistentIsland* island = CreateIsland(body->IsAwake());
+	Append(island, body);
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		LinkJoint(je->joint);
+	}
+}
+
+void b2IslandGraph::RemoveBody(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island == nullptr)
+	{
+		return;
+	}
+
+	b2Assert(body->m_contactList == nullptr);
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		UnlinkJoint(je->joint);
+	}
+
+	RemoveNode(&island->bodyList, &island->bodyTail, &island->bodyCount, body);
+
+	if (island->bodyCount == 0)
+	{
+		DestroyIsland(island);
+	}
+	else
+	{
+		// The remaining bodies may no longer be connected.
+		island->constraintRemoveCount += 1;
+	}
+
+	// A joint to a body that is still simulated moves to the island of that body.
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		LinkJoint(je->joint);
+	}
+}
+
+// Union the islands of a new constraint. The larger island absorbs the smaller one,
+// so each member is relabeled O(log n) times over its lifetime.
+b2PersistentIsland* b2IslandGraph::Merge(b2PersistentIsland* islandA, b2PersistentIsland* islandB)
+{
+	if (islandA == nullptr)
+	{
+		return islandB;
+	}
+
+	if (islandB == nullptr || islandA == islandB)
+	{
+		return islandA;
+	}
+
+	b2PersistentIsland* big = islandA;
+	b2PersistentIsland* small = islandB;
+	if (big->bodyCount + big->contactCount + big->jointCount <
+		small->bodyCount + small->contactCount + small->jointCount)
+	{
+		big = islandB;
+		small = islandA;
+	}
+
+	// A constraint to an awake island wakes the other island.
+	if (big->awake != small->awake)
+	{
+		WakeIsland(big->awake ? small : big);
+	}
+
+	SpliceList(big, &big->bodyList, &big->bodyTail, small->bodyList, small->bodyTail);
+	SpliceList(big, &big->contactList, &big->contactTail, small->contactList, small->contactTail);
+	SpliceList(big, &big->jointList, &big->jointTail, small->jointList, small->jointTail);
+	big->bodyCount += small->bodyCount;
+	big->contactCount += small->contactCount;
+	big->jointCount += small->jointCount;
+	big->constraintRemoveCount += small->constraintRemoveCount;
+
+	small->bodyCount = 0;
+	small->contactCount = 0;
+	small->jointCount = 0;
+	DestroyIsland(small);
+
+	return big;
+}
+
+void b2IslandGraph::LinkContact(b2Contact* contact)
+{
+	b2Assert(contact->m_island == nullptr);
+	b2Body* bodyA = contact->m_fixtureA->GetBody();
+	b2Body* bodyB = contact->m_fixtureB->GetBody();
+
+	b2PersistentIsland* island = Merge(bodyA->m_island, bodyB->m_island);
+	b2Assert(island != nullptr);
+	if (island != nullptr)
+	{
+		Append(island, contact);
+	}
+}
+
+void b2IslandGraph::UnlinkContact(b2Contact* contact)
+{
+	b2PersistentIsland* island = contact->m_island;
+	if (island == nullptr)
+	{
+		return;
+	}
+
+	RemoveNode(&island->contactList, &island->contactTail, &island->contactCount, contact);
+	island->constraintRemoveCount += 1;
+}
+
+void b2IslandGraph::LinkJoint(b2Joint* joint)
+{
+	b2Body* bodyA = joint->m_bodyA;
+	b2Body* bodyB = joint->m_bodyB;
+
+	// Joints connected to inactive bodies are not simulated.
+	if (bodyA->IsActive() == false || bodyB->IsActive() == false)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island = Merge(bodyA->m_island, bodyB->m_island);
+	if (island == nullptr)
+	{
+		// Both bodies are static.
+		return;
+	}
+
+	// A linked joint was relabeled by the merge.
+	if (joint->m_island == nullptr)
+	{
+		Append(island, joint);
+	}
+	b2Assert(joint->m_island == island);
+}
+
+void b2IslandGraph::UnlinkJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = joint->m_island;
+	if (island == nullptr)
+	{
+		return;
+	}
+
+	RemoveNode(&island->jointList, &island->jointTail, &island->jointCount, joint);
+	island->constraintRemoveCount += 1;
+}
+
+void b2IslandGraph::WakeIsland(b2PersistentIsland* island)
+{
+	if (island->awake)
+	{
+		return;
+	}
+
+	RemoveFromList(island);
+	island->awake = true;
+	AddToList(island);
+
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_flags |= b2Body::e_awakeFlag;
+		b->m_sleepTime = 0.0f;
+
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			m_contactManager->AddAwakeContact(ce->contact);
+		}
+	}
+}
+
+void b2IslandGraph::SleepIsland(b2PersistentIsland* island, b2StackAllocator* stackAllocator)
+{
+	if (island->awake)
+	{
+		RemoveFromList(island);
+		island->awake = false;
+		AddToList(island);
+
+		for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+		{
+			// The TOI solver only resets the sweeps of awake bodies.
+			b->m_sweep.alpha0 = 0.0f;
+
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2PersistentIsland* other = ce->other->m_island;
+				if (other == nullptr || other->awake == false)
+				{
+					m_contactManager->RemoveAwakeContact(ce->contact);
+				}
+			}
+		}
+	}
+
+	// Split before sleeping so that touching one component does not wake the others.
+	if (island->constraintRemoveCount > 0)
+	{
+		SplitIsland(island, stackAllocator);
+	}
+}
+
+void b2IslandGraph::SplitIsland(b2PersistentIsland* island, b2StackAllocator* stackAllocator)
+{
+	int32 bodyCount = island->bodyCount;
+	b2Body** bodies = (b2Body**)stackAllocator->Allocate(2 * bodyCount * sizeof(b2Body*));
+	b2Body** stack = bodies + bodyCount;
+
+	// The members keep pointing at the old island until a component claims them,
+	// so the old lists are only read through this copy.
+	int32 index = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		bodies[index++] = b;
+	}
+
+	// Perform a depth first search (DFS) on the constraints of the island.
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_island != island)
+		{
+			continue;
+		}
+
+		b2PersistentIsland* component = CreateIsland(island->awake);
+		Append(component, seed);
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+				if (contact->m_island != island)
+				{
+					continue;
+				}
+
+				Append(component, contact);
+
+				// Static bodies are not in the island.
+				b2Body* other = ce->other;
+				if (other->m_island == island)
+				{
+					Append(component, other);
+					stack[stackCount++] = other;
+				}
+			}
+
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				b2Joint* joint = je->joint;
+				if (joint->m_island != island)
+				{
+					continue;
+				}
+
+				Append(component, joint);
+
+				b2Body* other = je->other;
+				if (other->m_island == island)
+				{
+					Append(component, other);
+					stack[stackCount++] = other;
+				}
+			}
+		}
+	}
+
+	stackAllocator->Free(bodies);
+
+	island->bodyCount = 0;
+	island->contactCount = 0;
+	island->jointCount = 0;
+	DestroyIsland(island);
+}
+
+void b2IslandGraph::Clear()
+{
+	b2PersistentIsland* lists[2] = {m_awakeList, m_sleepingList};
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2PersistentIsland* island = lists[i];
+		while (island)
+		{
+			b2PersistentIsland* next = island->next;
+
+			for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+			{
+				b->m_island = nullptr;
+			}
+
+			for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+			{
+				c->m_island = nullptr;
+			}
+
+			for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+			{
+				j->m_island = nullptr;
+			}
+
+			m_allocator->Free(island, sizeof(b2PersistentIsland), b2_islandMemory);
+			island = next;
+		}
+	}
+
+	m_awakeList = nullptr;
+	m_sleepingList = nullptr;
+	m_awakeCount = 0;
+	m_sleepingCount = 0;
+}
+
+void b2IslandGraph::ValidateIsland(const b2PersistentIsland* island) const
+{
+#if defined(b2DEBUG)
+	int32 count = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		b2Assert(b->m_island == island);
+		b2Assert(b->m_islandNext != nullptr || b == island->bodyTail);
+		b2Assert(b->IsActive() && b->m_type != b2_staticBody);
+		b2Assert(island->awake || b->IsAwake() == false);
+		++count;
+	}
+	b2Assert(count == island->bodyCount);
+
+	count = 0;
+	for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+	{
+		b2Assert(c->m_island == island);
+		b2Assert(c->m_islandNext != nullptr || c == island->contactTail);
+		b2Assert(c->IsTouching());
+		b2Body* bodyA = c->m_fixtureA->GetBody();
+		b2Body* bodyB = c->m_fixtureB->GetBody();
+		b2Assert(bodyA->m_island == island || bodyB->m_island == island);
+		b2Assert(bodyA->m_island == island || bodyA->m_island == nullptr);
+		b2Assert(bodyB->m_island == island || bodyB->m_island == nullptr);
+		B2_NOT_USED(bodyA);
+		B2_NOT_USED(bodyB);
+		++count;
+	}
+	b2Assert(count == island->contactCount);
+
+	count = 0;
+	for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+	{
+		b2Assert(j->m_island == island);
+		b2Assert(j->m_islandNext != nullptr || j == island->jointTail);
+		b2Assert(j->m_bodyA->m_island == island || j->m_bodyB->m_island == island);
+		++count;
+	}
+	b2Assert(count == island->jointCount);
+#else
+	B2_NOT_USED(island);
+#endif
+}
+
+void b2IslandGraph::Validate() const
+{
+#if defined(b2DEBUG)
+	int32 count = 0;
+	for (b2PersistentIsland* island = m_awakeList; island; island = island->next)
+	{
+		b2Assert(island->awake);
+		ValidateIsland(island);
+		++count;
+	}
+	b2Assert(count == m_awakeCount);
+
+	count = 0;
+	for (b2PersistentIsland* island = m_sleepingList; island; island = island->next)
+	{
+		b2Assert(island->awake == false);
+		ValidateIsland(island);
+		++count;
+	}
+	b2Assert(count == m_sleepingCount);
+#endif
+}
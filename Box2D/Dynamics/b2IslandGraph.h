@@ -0,0 +1,133 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ISLAND_GRAPH_H
+#define B2_ISLAND_GRAPH_H
+
+#include "Box2D/Common/b2Settings.h"
+
+class b2Body;
+class b2Contact;
+class b2Joint;
+class b2BlockAllocator;
+class b2ContactManager;
+class b2StackAllocator;
+
+/// A set of bodies connected by touching contacts and joints. Islands persist
+/// across time steps. They merge when a constraint links two of them and are
+/// split lazily, only when a removed constraint may have disconnected them and
+/// the island is about to sleep. Static bodies do not belong to islands, but
+/// their contacts and joints belong to the island of the other body.
+/// This is an internal structure.
+struct b2PersistentIsland
+{
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+
+	b2Body* bodyList;
+	b2Body* bodyTail;
+	int32 bodyCount;
+
+	b2Contact* contactList;
+	b2Contact* contactTail;
+	int32 contactCount;
+
+	b2Joint* jointList;
+	b2Joint* jointTail;
+	int32 jointCount;
+
+	/// The number of constraints and bodies removed since the last split.
+	/// A split is only needed if this is positive.
+	int32 constraintRemoveCount;
+
+	bool awake;
+};
+
+// Delegate of b2World.
+class b2IslandGraph
+{
+public:
+	b2IslandGraph();
+
+	// Give an active dynamic or kinematic body its own island and link its joints.
+	void AddBody(b2Body* body);
+
+	// Remove a body from its island. The caller destroys the contacts of the body first.
+	// Joints of the body are re-linked where they are still simulated.
+	void RemoveBody(b2Body* body);
+
+	// Add a touching solid contact to the island of its bodies, merging islands.
+	void LinkContact(b2Contact* contact);
+	void UnlinkContact(b2Contact* contact);
+
+	// Add a joint between active bodies to the island of its bodies, merging islands.
+	void LinkJoint(b2Joint* joint);
+	void UnlinkJoint(b2Joint* joint);
+
+	// Move an island to the awake list, wake all its bodies and their contacts.
+	void WakeIsland(b2PersistentIsland* island);
+
+	// Move an island to the sleeping list and put to sleep the contacts that no
+	// longer touch an awake island. It is split first if needed.
+	void SleepIsland(b2PersistentIsland* island, b2StackAllocator* stackAllocator);
+
+	// Replace an island by its connected components. The components keep the
+	// awake state of the island.
+	void SplitIsland(b2PersistentIsland* island, b2StackAllocator* stackAllocator);
+
+	// Destroy all islands and clear the island of every member.
+	void Clear();
+
+	// Create an empty island. Members are added with the Append functions.
+	b2PersistentIsland* CreateIsland(bool awake);
+	void DestroyIsland(b2PersistentIsland* island);
+
+	void Append(b2PersistentIsland* island, b2Body* body);
+	void Append(b2PersistentIsland* island, b2Contact* contact);
+	void Append(b2PersistentIsland* island, b2Joint* joint);
+
+	// Check the island invariants. For testing.
+	void Validate() const;
+
+	b2PersistentIsland* m_awakeList;
+	b2PersistentIsland* m_sleepingList;
+	int32 m_awakeCount;
+	int32 m_sleepingCount;
+	b2BlockAllocator* m_allocator;
+	b2ContactManager* m_contactManager;
+
+private:
+
+	b2PersistentIsland* Merge(b2PersistentIsland* islandA, b2PersistentIsland* islandB);
+
+	void AddToList(b2PersistentIsland* island);
+	void RemoveFromList(b2PersistentIsland* island);
+
+	void ValidateIsland(const b2PersistentIsland* island) const;
+
+	template <typename T>
+	static void AppendNode(b2PersistentIsland* island, T** head, T** tail, int32* count, T* node);
+
+	template <typename T>
+	static void RemoveNode(T** head, T** tail, int32* count, T* node);
+
+	template <typename T>
+	static void SpliceList(b2PersistentIsland* island, T** head, T** tail, T* list, T* listTail);
+};
+
+#endif
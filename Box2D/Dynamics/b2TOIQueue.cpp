@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/b2TOIQueue.h"
+#include <string.h>
+
+static inline bool b2TOIEventLessThan(const b2TOIEvent& event1, const b2TOIEvent& event2)
+{
+	if (event1.alpha < event2.alpha)
+	{
+		return true;
+	}
+
+	if (event1.alpha == event2.alpha)
+	{
+		return event1.contactIndex < event2.contactIndex;
+	}
+
+	return false;
+}
+
+b2TOIQueue::b2TOIQueue(b2AllocatorInterface* allocator)
+{
+	m_allocator = allocator;
+	m_count = 0;
+	m_capacity = 16;
+	m_events = (b2TOIEvent*)b2Alloc(m_allocator, m_capacity * sizeof(b2TOIEvent), b2_scratchMemory);
+}
+
+b2TOIQueue::~b2TOIQueue()
+{
+	b2Free(m_allocator, m_events, m_capacity * sizeof(b2TOIEvent), b2_scratchMemory);
+}
+
+void b2TOIQueue::Push(float32 alpha, int32 contactIndex)
+{
+	if (m_count == m_capacity)
+	{
+		b2TOIEvent* oldEvents = m_events;
+		m_capacity *= 2;
+		m_events = (b2TOIEvent*)b2Alloc(m_allocator, m_capacity * sizeof(b2TOIEvent), b2_scratchMemory);
+		memcpy(m_events, oldEvents, m_count * sizeof(b2TOIEvent));
+		b2Free(m_allocator, oldEvents, m_count * sizeof(b2TOIEvent), b2_scratchMemory);
+	}
+
+	b2TOIEvent event;
+	event.alpha = alpha;
+	event.contactIndex = contactIndex;
+
+	// Sift up.
+	int32 index = m_count;
+	++m_count;
+	while (index > 0)
+	{
+		int32 parent = (index - 1) >> 1;
+		if (b2TOIEventLessThan(event, m_events[parent]) == false)
+		{
+			break;
+		}
+
+		m_events[index] = m_events[parent];
+		index = parent;
+	}
+
+	m_events[index] = event;
+}
+
+b2TOIEvent b2TOIQueue::Pop()
+{
+	b2Assert(m_count > 0);
+	b2TOIEvent top = m_events[0];
+
+	--m_count;
+	if (m_count == 0)
+	{
+		return top;
+	}
+
+	// Sift the last event down from the root.
+	b2TOIEvent event = m_events[m_count];
+	int32 index = 0;
+	for (;;)
+	{
+		int32 child = 2 * index + 1;
+		if (child >= m_count)
+		{
+			break;
+		}
+
+		if (child + 1 < m_count && b2TOIEventLessThan(m_events[child + 1], m_events[child]))
+		{
+			++child;
+		}
+
+		if (b2TOIEventLessThan(m_events[child], event) == false)
+		{
+			break;
+		}
+
+		m_events[index] = m_events[child];
+		index = child;
+	}
+
+	m_events[index] = event;
+	return top;
+}
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2019 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TOI_QUEUE_H
+#define B2_TOI_QUEUE_H
+
+#include "Box2D/Common/b2Settings.h"
+#include "Box2D/Common/b2AllocatorInterface.h"
+
+/// A time of impact candidate. The contact is referenced by its index in the
+/// awake contact array, which only grows while the TOI solver runs.
+struct b2TOIEvent
+{
+	float32 alpha;
+	int32 contactIndex;
+};
+
+/// A binary min-heap of TOI events. Events are ordered by alpha and then by
+/// contact index, so ties resolve like a scan of the awake contacts. Stale
+/// events are not removed; the client skips them when they are popped.
+/// This is an internal class.
+class b2TOIQueue
+{
+public:
+	/// The heap comes from the optional allocator interface as b2_scratchMemory.
+	b2TOIQueue(b2AllocatorInterface* allocator = nullptr);
+	~b2TOIQueue();
+
+	void Clear();
+
+	void Push(float32 alpha, int32 contactIndex);
+
+	/// Remove and return the first event. The queue must not be empty.
+	b2TOIEvent Pop();
+
+	int32 GetCount() const;
+
+private:
+
+	b2AllocatorInterface* m_allocator;
+
+	b2TOIEvent* m_events;
+	int32 m_count;
+	int32 m_capacity;
+};
+
+inline void b2TOIQueue::Clear()
+{
+	m_count = 0;
+}
+
+inline int32 b2TOIQueue::GetCount() const
+{
+	return m_count;
+}
+
+#endif
@@ -21,7 +21,7 @@
 
 #include "Box2D/Common/b2Math.h"
 
-/// Profiling data. Times are in milliseconds.
+/// Profiling data. Times are in milliseconds, counts are per step.
 struct b2Profile
 {
 	float32 step;
@@ -32,6 +32,20 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	int32 broadphaseReinserts;	///< proxies re-inserted into the dynamic tree
+	int32 broadphasePairs;		///< contacts, i.e. fat AABB pairs kept for the narrow-phase
+	int32 stackHighWater;		///< peak bytes of the stack allocator
+	int32 stackOverflows;		///< stack segments added because the capacity was exceeded
+	int32 gjkCalls;				///< distance queries for sensor overlap and time of impact
+	int32 gjkIters;				///< GJK iterations of those queries
+	int32 gjkMaxIters;			///< most GJK iterations of one query
+	int32 toiCalls;				///< time of impact queries
+	int32 toiIters;				///< separating axes tried by those queries
+	int32 toiRootIters;			///< root finder iterations of those queries
+	int32 polygonCacheCalls;	///< polygon pairs collided with a valid b2PolygonCache
+	int32 polygonCacheHits;		///< the cached edges were still best or still separating
+	int32 polygonCacheClimbs;	///< the edges were found by walking to neighbor edges
+	int32 polygonCacheMisses;	///< other edges had to be searched
 };
 
 /// This is an internal structure.
@@ -43,6 +57,7 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool speculative;	// separated points limit the approach velocity
 };
 
 /// This is an internal structure.
@@ -20,7 +20,17 @@
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2Island.h"
+#include "Box2D/Dynamics/Joints/b2DistanceJoint.h"
+#include "Box2D/Dynamics/Joints/b2FrictionJoint.h"
+#include "Box2D/Dynamics/Joints/b2GearJoint.h"
+#include "Box2D/Dynamics/Joints/b2MotorJoint.h"
+#include "Box2D/Dynamics/Joints/b2MouseJoint.h"
+#include "Box2D/Dynamics/Joints/b2PrismaticJoint.h"
 #include "Box2D/Dynamics/Joints/b2PulleyJoint.h"
+#include "Box2D/Dynamics/Joints/b2RevoluteJoint.h"
+#include "Box2D/Dynamics/Joints/b2RopeJoint.h"
+#include "Box2D/Dynamics/Joints/b2WeldJoint.h"
+#include "Box2D/Dynamics/Joints/b2WheelJoint.h"
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
 #include "Box2D/Dynamics/Contacts/b2ContactSolver.h"
 #include "Box2D/Collision/b2Collision.h"
@@ -29,15 +39,32 @@
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Collision/Shapes/b2CapsuleShape.h"
+#include "Box2D/Collision/Shapes/b2TerrainShape.h"
+#include "Box2D/Collision/Shapes/b2DistanceFieldShape.h"
 #include "Box2D/Collision/b2TimeOfImpact.h"
 #include "Box2D/Common/b2Draw.h"
 #include "Box2D/Common/b2Timer.h"
+#include "Box2D/Common/b2BinaryStream.h"
+#include <algorithm>
 #include <new>
-
-b2World::b2World(const b2Vec2& gravity)
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// FNV-1a offset basis, the initial value of the state hash.
+const uint32 b2_stateHashSeed = 2166136261u;
+
+b2World::b2World(const b2Vec2& gravity, b2AllocatorInterface* allocator)
+	: m_allocator(allocator ? allocator : &m_defaultAllocator)
+	, m_blockAllocator(m_allocator)
+	, m_stackAllocator(b2_stackSize, m_allocator)
+	, m_contactManager(m_allocator)
+	, m_eventBuffer(m_allocator)
 {
 	m_destructionListener = nullptr;
 	m_debugDraw = nullptr;
+	m_taskScheduler = nullptr;
 
 	m_bodyList = nullptr;
 	m_jointList = nullptr;
@@ -48,6 +75,14 @@ b2World::b2World(const b2Vec2& gravity)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_parallelContinuous = false;
+	m_speculativeContacts = false;
+	m_manifoldReuse = false;
+	m_speculativeTime = 0.0f;
+	m_hitEventThreshold = 1.0f;
+
+	m_stateHashing = false;
+	m_stateHash = b2_stateHashSeed;
 
 	m_stepComplete = true;
 
@@ -59,6 +94,8 @@ b2World::b2World(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_islandGraph.m_allocator = &m_blockAllocator;
+	m_islandGraph.m_contactManager = &m_contactManager;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
@@ -104,6 +141,11 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	m_taskScheduler = scheduler;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -112,7 +154,7 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 		return nullptr;
 	}
 
-	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
+	void* mem = m_blockAllocator.Allocate(sizeof(b2Body), b2_bodyMemory);
 	b2Body* b = new (mem) b2Body(def, this);
 
 	// Add to world doubly linked list.
@@ -125,9 +167,101 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	if (b->IsActive() && b->m_type != b2_staticBody)
+	{
+		m_islandGraph.AddBody(b);
+	}
+
 	return b;
 }
 
+void b2World::CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+						   const b2FixtureDef* fixtureDefs, const int32* fixtureCounts, b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Count the proxies of the active bodies.
+	int32 proxyCapacity = 0;
+	int32 fixtureIndex = 0;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		for (int32 k = 0; k < fixtureCounts[i]; ++k, ++fixtureIndex)
+		{
+			if (bodyDefs[i].active)
+			{
+				proxyCapacity += fixtureDefs[fixtureIndex].shape->GetChildCount();
+			}
+		}
+	}
+
+	b2AABB* aabbs = (b2AABB*)m_stackAllocator.Allocate(proxyCapacity * sizeof(b2AABB));
+	void** userData = (void**)m_stackAllocator.Allocate(proxyCapacity * sizeof(void*));
+	int32* proxyIds = (int32*)m_stackAllocator.Allocate(proxyCapacity * sizeof(int32));
+	int32 proxyCount = 0;
+
+	fixtureIndex = 0;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = CreateBody(bodyDefs + i);
+		bool hasMass = false;
+
+		for (int32 k = 0; k < fixtureCounts[i]; ++k, ++fixtureIndex)
+		{
+			b2Fixture* f = b->AttachFixture(fixtureDefs + fixtureIndex);
+			hasMass = hasMass || f->m_density > 0.0f;
+
+			if ((b->m_flags & b2Body::e_activeFlag) == 0)
+			{
+				continue;
+			}
+
+			// The proxy ids are filled in once the tree is built.
+			f->m_proxyCount = f->m_shape->GetChildCount();
+			for (int32 p = 0; p < f->m_proxyCount; ++p)
+			{
+				b2FixtureProxy* proxy = f->m_proxies + p;
+				f->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, p);
+				proxy->fixture = f;
+				proxy->childIndex = p;
+				aabbs[proxyCount] = proxy->aabb;
+				userData[proxyCount] = proxy;
+				++proxyCount;
+			}
+		}
+
+		if (hasMass)
+		{
+			b->ResetMassData();
+		}
+
+		if (bodies)
+		{
+			bodies[i] = b;
+		}
+	}
+
+	b2Assert(proxyCount == proxyCapacity);
+	m_contactManager.m_broadPhase.CreateProxies(aabbs, userData, proxyCount, proxyIds);
+	for (int32 i = 0; i < proxyCount; ++i)
+	{
+		((b2FixtureProxy*)userData[i])->proxyId = proxyIds[i];
+	}
+
+	m_stackAllocator.Free(proxyIds);
+	m_stackAllocator.Free(userData);
+	m_stackAllocator.Free(aabbs);
+
+	// Let the next time step create the contacts.
+	if (fixtureIndex > 0)
+	{
+		m_flags |= e_newFixture;
+	}
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -180,7 +314,7 @@ void b2World::DestroyBody(b2Body* b)
 		f0->DestroyProxies(&m_contactManager.m_broadPhase);
 		f0->Destroy(&m_blockAllocator);
 		f0->~b2Fixture();
-		m_blockAllocator.Free(f0, sizeof(b2Fixture));
+		m_blockAllocator.Free(f0, sizeof(b2Fixture), b2_fixtureMemory);
 
 		b->m_fixtureList = f;
 		b->m_fixtureCount -= 1;
@@ -188,6 +322,8 @@ void b2World::DestroyBody(b2Body* b)
 	b->m_fixtureList = nullptr;
 	b->m_fixtureCount = 0;
 
+	m_islandGraph.RemoveBody(b);
+
 	// Remove world body list.
 	if (b->m_prev)
 	{
@@ -206,7 +342,7 @@ void b2World::DestroyBody(b2Body* b)
 
 	--m_bodyCount;
 	b->~b2Body();
-	m_blockAllocator.Free(b, sizeof(b2Body));
+	m_blockAllocator.Free(b, sizeof(b2Body), b2_bodyMemory);
 }
 
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
@@ -264,7 +400,9 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 		}
 	}
 
-	// Note: creating a joint doesn't wake the bodies.
+	// Note: creating a joint doesn't wake the bodies. It may merge islands, and
+	// a sleeping island joined to an awake one is woken.
+	m_islandGraph.LinkJoint(j);
 
 	return j;
 }
@@ -296,6 +434,7 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 
 	// Disconnect from island graph.
+	m_islandGraph.UnlinkJoint(j);
 	b2Body* bodyA = j->m_bodyA;
 	b2Body* bodyB = j->m_bodyB;
 
@@ -382,7 +521,8 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
-// Find islands, integrate and solve constraints, solve position constraints
+// Solve the awake islands: integrate and solve constraints, solve position constraints.
+// Islands are persistent, so this only visits awake bodies and their constraints.
 void b2World::Solve(const b2TimeStep& step)
 {
 	m_profile.solveInit = 0.0f;
@@ -396,175 +536,129 @@ void b2World::Solve(const b2TimeStep& step)
 					&m_stackAllocator,
 					m_contactManager.m_contactListener);
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
-	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
-	{
-		j->m_islandFlag = false;
-	}
+	// At most one island is split per step to bound the cost of splitting.
+	b2PersistentIsland* splitIsland = nullptr;
+
+	// Small islands are gathered into one batch to share the solver setup.
+	b2PersistentIsland* batch[b2_islandBatchSize];
+	int32 batchCount = 0;
+	int32 batchBodyCount = 0;
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	b2PersistentIsland* next = nullptr;
+	for (b2PersistentIsland* persistent = m_islandGraph.m_awakeList; persistent; persistent = next)
 	{
-		if (seed->m_flags & b2Body::e_islandFlag)
+		next = persistent->next;
+
+		// The island sleeps if all of its bodies were put to sleep by the user.
+		bool awake = false;
+		for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
 		{
-			continue;
+			if (b->IsAwake())
+			{
+				awake = true;
+				break;
+			}
 		}
 
-		if (seed->IsAwake() == false || seed->IsActive() == false)
+		if (awake == false)
 		{
+			m_islandGraph.SleepIsland(persistent, &m_stackAllocator);
 			continue;
 		}
 
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
+		if (batchCount > 0 && batchBodyCount + persistent->bodyCount > b2_islandBatchSize)
 		{
-			continue;
+			SolveBatch(&island, batch, batchCount, step, &splitIsland);
+			batchCount = 0;
+			batchBodyCount = 0;
 		}
 
-		// Reset island and stack.
-		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
-
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
 			b2Assert(b->IsActive() == true);
 			island.Add(b);
 
 			// Make sure the body is awake (without resetting sleep timer).
 			b->m_flags |= b2Body::e_awakeFlag;
+		}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+		// Static bodies join through the contacts and joints of the island. They can
+		// be in several islands, so the island flag only prevents duplicates here.
+		for (b2Contact* contact = persistent->contactList; contact; contact = contact->m_islandNext)
+		{
+			// Was this contact disabled by the user?
+			if (contact->IsEnabled() == false)
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			// A fixture may have become a sensor since the contact was updated.
+			if (contact->m_fixtureA->m_isSensor || contact->m_fixtureB->m_isSensor)
 			{
-				b2Contact* contact = ce->contact;
-
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
-
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
-
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
-
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = ce->other;
-
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				continue;
 			}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			b2Body* bodyA = contact->m_fixtureA->m_body;
+			b2Body* bodyB = contact->m_fixtureB->m_body;
+			if (bodyA->m_island == nullptr && (bodyA->m_flags & b2Body::e_islandFlag) == 0)
 			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
-
-				b2Body* other = je->other;
-
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
-				{
-					continue;
-				}
-
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
-
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+				bodyA->m_flags |= b2Body::e_islandFlag;
+				island.Add(bodyA);
+			}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+			if (bodyB->m_island == nullptr && (bodyB->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				bodyB->m_flags |= b2Body::e_islandFlag;
+				island.Add(bodyB);
 			}
-		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+			island.Add(contact);
+		}
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		for (b2Joint* joint = persistent->jointList; joint; joint = joint->m_islandNext)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->GetType() == b2_staticBody)
+			b2Body* bodyA = joint->m_bodyA;
+			b2Body* bodyB = joint->m_bodyB;
+			if (bodyA->m_island == nullptr && (bodyA->m_flags & b2Body::e_islandFlag) == 0)
 			{
-				b->m_flags &= ~b2Body::e_islandFlag;
+				bodyA->m_flags |= b2Body::e_islandFlag;
+				island.Add(bodyA);
+			}
+
+			if (bodyB->m_island == nullptr && (bodyB->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				bodyB->m_flags |= b2Body::e_islandFlag;
+				island.Add(bodyB);
 			}
+
+			island.Add(joint);
 		}
+
+		island.EndIsland();
+		batch[batchCount++] = persistent;
+		batchBodyCount += persistent->bodyCount;
+	}
+
+	if (batchCount > 0)
+	{
+		SolveBatch(&island, batch, batchCount, step, &splitIsland);
 	}
 
-	m_stackAllocator.Free(stack);
+	if (splitIsland)
+	{
+		m_islandGraph.SplitIsland(splitIsland, &m_stackAllocator);
+	}
 
 	{
 		b2Timer timer;
 		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		for (b2PersistentIsland* persistent = m_islandGraph.m_awakeList; persistent; persistent = persistent->next)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
-			{
-				continue;
-			}
-
-			if (b->GetType() == b2_staticBody)
+			for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
 			{
-				continue;
+				// Update fixtures (for broad-phase).
+				b->SynchronizeFixtures();
 			}
-
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
 		}
 
 		// Look for new contacts.
@@ -573,312 +667,554 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 }
 
-// Find TOI contacts and solve them.
-void b2World::SolveTOI(const b2TimeStep& step)
+void b2World::SolveBatch(b2Island* island, b2PersistentIsland** batch, int32 count,
+						 const b2TimeStep& step, b2PersistentIsland** splitIsland)
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
-
-	if (m_stepComplete)
+	b2Profile profile;
+	island->Solve(&profile, step, m_gravity, m_allowSleep);
+	m_profile.solveInit += profile.solveInit;
+	m_profile.solveVelocity += profile.solveVelocity;
+	m_profile.solvePosition += profile.solvePosition;
+
+	// Allow static bodies to participate in other batches.
+	for (int32 i = 0; i < island->m_bodyCount; ++i)
 	{
-		for (b2Body* b = m_bodyList; b; b = b->m_next)
-		{
-			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
-		}
-
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-		{
-			// Invalidate TOI
-			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
-			c->m_toiCount = 0;
-			c->m_toi = 1.0f;
-		}
+		island->m_bodies[i]->m_flags &= ~b2Body::e_islandFlag;
 	}
 
-	// Find TOI events and solve them.
-	for (;;)
+	b2Assert(island->m_rangeCount == count);
+	for (int32 i = 0; i < count; ++i)
 	{
-		// Find the first TOI.
-		b2Contact* minContact = nullptr;
-		float32 minAlpha = 1.0f;
+		b2PersistentIsland* persistent = batch[i];
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		if (island->m_ranges[i].sleeping)
 		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
+			// The bodies moved in this step, so update their fixtures before they sleep.
+			for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
 			{
-				continue;
+				b->SynchronizeFixtures();
 			}
 
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
-			{
-				continue;
-			}
+			m_islandGraph.SleepIsland(persistent, &m_stackAllocator);
+			continue;
+		}
 
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
-			}
-			else
+		// A removed constraint may have split off bodies that want to sleep. Split the
+		// island so they can sleep on their own.
+		if (*splitIsland == nullptr && persistent->constraintRemoveCount > 0 && m_allowSleep)
+		{
+			for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
 			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
-
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
+				if (b->m_sleepTime >= b2_timeToSleep)
 				{
-					continue;
+					*splitIsland = persistent;
+					break;
 				}
+			}
+		}
+	}
 
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
+	island->Clear();
+}
 
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+// Queue the TOI of an awake contact, computing it unless a valid one is cached.
+void b2World::QueueTOI(int32 contactIndex)
+{
+	b2Contact* c = m_contactManager.m_awakeContacts[contactIndex];
 
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+	// Is this contact disabled?
+	if (c->IsEnabled() == false)
+	{
+		return;
+	}
 
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
-				{
-					continue;
-				}
+	// Prevent excessive sub-stepping.
+	if (c->m_toiCount > b2_maxSubSteps)
+	{
+		return;
+	}
 
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+	float32 alpha = 1.0f;
+	if (c->m_flags & b2Contact::e_toiFlag)
+	{
+		// This contact has a valid cached TOI.
+		alpha = c->m_toi;
+	}
+	else
+	{
+		b2Fixture* fA = c->GetFixtureA();
+		b2Fixture* fB = c->GetFixtureB();
 
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
-				{
-					continue;
-				}
+		// Is there a sensor?
+		if (fA->IsSensor() || fB->IsSensor())
+		{
+			return;
+		}
 
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
+		b2Body* bA = fA->GetBody();
+		b2Body* bB = fB->GetBody();
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
+		b2BodyType typeA = bA->m_type;
+		b2BodyType typeB = bB->m_type;
+		b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
 
-				b2Assert(alpha0 < 1.0f);
+		bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+		bool activeB = bB->IsAwake() && typeB != b2_staticBody;
 
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+		// Is at least one body active (awake and dynamic or kinematic)?
+		if (activeA == false && activeB == false)
+		{
+			return;
+		}
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+		bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+		bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+		// Are these two non-bullet dynamic bodies?
+		if (collideA == false && collideB == false)
+		{
+			return;
+		}
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
-				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
-				}
-				else
-				{
-					alpha = 1.0f;
-				}
+		// Compute the TOI for this contact.
+		// Put the sweeps onto the same time interval.
+		float32 alpha0 = bA->m_sweep.alpha0;
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
-			}
+		if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
+		{
+			alpha0 = bB->m_sweep.alpha0;
+			bA->m_sweep.Advance(alpha0);
+		}
+		else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
+		{
+			alpha0 = bA->m_sweep.alpha0;
+			bB->m_sweep.Advance(alpha0);
+		}
+
+		b2Assert(alpha0 < 1.0f);
+
+		int32 indexA = c->GetChildIndexA();
+		int32 indexB = c->GetChildIndexB();
 
-			if (alpha < minAlpha)
+		// Compute the time of impact in interval [0, minTOI]
+		b2TOIOutput output;
+		if (fA->GetType() == b2Shape::e_distanceField)
+		{
+			// Distance fields have no proxy.
+			b2TimeOfImpactField(&output, (b2DistanceFieldShape*)fA->GetShape(), bA->m_sweep,
+								(b2CircleShape*)fB->GetShape(), bB->m_sweep, 1.0f);
+		}
+		else
+		{
+			b2TOIInput input;
+			input.proxyA.Set(fA->GetShape(), indexA);
+			input.proxyB.Set(fB->GetShape(), indexB);
+			input.sweepA = bA->m_sweep;
+			input.sweepB = bB->m_sweep;
+			input.tMax = 1.0f;
+
+			// Circles against fixed shapes have a closed form.
+			if (b2TimeOfImpactCircle(&output, &input) == false)
 			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
+				// The simplex carries over between the sub-steps and steps of this pair.
+				b2TimeOfImpact(&output, &input, &c->m_simplexCache);
 			}
 		}
 
-		if (minContact == nullptr || 1.0f - 10.0f * b2_epsilon < minAlpha)
+		++m_profile.toiCalls;
+		m_profile.toiIters += output.iterations;
+		m_profile.toiRootIters += output.rootIterations;
+		m_profile.gjkCalls += output.distanceCalls;
+		m_profile.gjkIters += output.distanceIterations;
+		m_profile.gjkMaxIters = b2Max(m_profile.gjkMaxIters, output.distanceIterations);
+
+		// Beta is the fraction of the remaining portion of the .
+		float32 beta = output.t;
+		if (output.state == b2TOIOutput::e_touching)
 		{
-			// No more TOI events. Done!
-			m_stepComplete = true;
-			break;
+			alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+		}
+		else
+		{
+			alpha = 1.0f;
 		}
 
-		// Advance the bodies to the TOI.
-		b2Fixture* fA = minContact->GetFixtureA();
-		b2Fixture* fB = minContact->GetFixtureB();
-		b2Body* bA = fA->GetBody();
-		b2Body* bB = fB->GetBody();
+		c->m_toi = alpha;
+		c->m_flags |= b2Contact::e_toiFlag;
+	}
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+	if (alpha < 1.0f)
+	{
+		m_toiQueue.Push(alpha, contactIndex);
+	}
+}
 
-		bA->Advance(minAlpha);
-		bB->Advance(minAlpha);
+// Solves the constraints of a group of prepared TOI islands.
+class b2TOISolveTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end) override
+	{
+		for (int32 i = begin; i < end; ++i)
+		{
+			islands[i].SolveTOIConstraints();
+		}
+	}
 
-		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
-		minContact->m_flags &= ~b2Contact::e_toiFlag;
-		++minContact->m_toiCount;
+	b2Island* islands;
+};
 
-		// Is the contact solid?
-		if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+bool b2World::IsTOIIsolated(b2Body* bodyA, b2Body* bodyB) const
+{
+	// The island of an event holds its bodies and the bodies it can reach through
+	// their contacts. Static bodies never move, so they may be shared.
+	b2Body* bodies[2] = {bodyA, bodyB};
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Body* body = bodies[i];
+		if (body->m_type == b2_staticBody)
 		{
-			// Restore the sweeps.
-			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
-			bA->SynchronizeTransform();
-			bB->SynchronizeTransform();
 			continue;
 		}
 
-		bA->SetAwake(true);
-		bB->SetAwake(true);
-
-		// Build the island
-		island.Clear();
-		island.Add(bA);
-		island.Add(bB);
-		island.Add(minContact);
+		if (body->m_flags & b2Body::e_islandFlag)
+		{
+			return false;
+		}
 
-		bA->m_flags |= b2Body::e_islandFlag;
-		bB->m_flags |= b2Body::e_islandFlag;
-		minContact->m_flags |= b2Contact::e_islandFlag;
+		if (body->m_type != b2_dynamicBody)
+		{
+			continue;
+		}
 
-		// Get contacts on bodyA and bodyB.
-		b2Body* bodies[2] = {bA, bB};
-		for (int32 i = 0; i < 2; ++i)
+		for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 		{
-			b2Body* body = bodies[i];
-			if (body->m_type == b2_dynamicBody)
+			b2Body* other = ce->other;
+			if (other->m_type != b2_staticBody && (other->m_flags & b2Body::e_islandFlag))
 			{
-				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
-				{
-					if (island.m_bodyCount == island.m_bodyCapacity)
-					{
-						break;
-					}
-
-					if (island.m_contactCount == island.m_contactCapacity)
-					{
-						break;
-					}
+				return false;
+			}
+		}
+	}
 
-					b2Contact* contact = ce->contact;
+	return true;
+}
 
-					// Has this contact already been added to the island?
-					if (contact->m_flags & b2Contact::e_islandFlag)
-					{
-						continue;
-					}
+// Find TOI contacts and solve them.
+void b2World::SolveTOI(const b2TimeStep& step)
+{
+	b2Contact** awakeContacts = m_contactManager.m_awakeContacts;
 
-					// Only add static, kinematic, or bullet bodies.
-					b2Body* other = ce->other;
-					if (other->m_type == b2_dynamicBody &&
-						body->IsBullet() == false && other->IsBullet() == false)
-					{
-						continue;
-					}
+	if (m_stepComplete)
+	{
+		for (b2PersistentIsland* persistent = m_islandGraph.m_awakeList; persistent; persistent = persistent->next)
+		{
+			for (b2Body* b = persistent->bodyList; b; b = b->m_islandNext)
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+				b->m_sweep.alpha0 = 0.0f;
+			}
+		}
 
-					// Skip sensors.
-					bool sensorA = contact->m_fixtureA->m_isSensor;
-					bool sensorB = contact->m_fixtureB->m_isSensor;
-					if (sensorA || sensorB)
-					{
-						continue;
-					}
+		for (int32 i = 0; i < m_contactManager.m_awakeContactCount; ++i)
+		{
+			b2Contact* c = awakeContacts[i];
 
-					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
-					if ((other->m_flags & b2Body::e_islandFlag) == 0)
-					{
-						other->Advance(minAlpha);
-					}
+			// Invalidate TOI
+			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+			c->m_toiCount = 0;
+			c->m_toi = 1.0f;
 
-					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+			// Static and sleeping bodies are only advanced through awake contacts.
+			c->m_fixtureA->m_body->m_sweep.alpha0 = 0.0f;
+			c->m_fixtureB->m_body->m_sweep.alpha0 = 0.0f;
+		}
+	}
 
-					// Was the contact disabled by the user?
-					if (contact->IsEnabled() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+	// Candidates are kept in a min-heap. After an event only the contacts of the
+	// moved bodies and the new awake contacts are queued again.
+	m_toiQueue.Clear();
+	int32 queuedCount = m_contactManager.m_awakeContactCount;
+	for (int32 i = 0; i < queuedCount; ++i)
+	{
+		QueueTOI(i);
+	}
 
-					// Are there contact points?
-					if (contact->IsTouching() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+	// In parallel mode events are gathered in time order until one shares a moving
+	// body with the islands gathered so far. Each group is a prefix of the event
+	// order, so the grouping does not depend on the scheduler.
+	int32 maxGroupSize = 1;
+	if (m_parallelContinuous && m_subStepping == false)
+	{
+		maxGroupSize = b2_maxTOIGroupSize;
+	}
 
-					// Add the contact to the island
-					contact->m_flags |= b2Contact::e_islandFlag;
-					island.Add(contact);
+	b2Island* islands = (b2Island*)m_stackAllocator.Allocate(maxGroupSize * sizeof(b2Island));
 
-					// Has the other body already been added to the island?
-					if (other->m_flags & b2Body::e_islandFlag)
-					{
-						continue;
-					}
-					
-					// Add the other body to the island.
-					other->m_flags |= b2Body::e_islandFlag;
+	// Find TOI events and solve them.
+	for (;;)
+	{
+		int32 groupSize = 0;
+		while (groupSize < maxGroupSize)
+		{
+			// Find the first TOI. Events are stale if the contact was invalidated or
+			// disabled since it was queued.
+			b2Contact* minContact = nullptr;
+			float32 minAlpha = 1.0f;
+			while (m_toiQueue.GetCount() > 0)
+			{
+				b2TOIEvent event = m_toiQueue.Pop();
+				b2Contact* c = m_contactManager.m_awakeContacts[event.contactIndex];
+				if ((c->m_flags & b2Contact::e_toiFlag) == 0 || c->m_toi != event.alpha ||
+					c->IsEnabled() == false || c->m_toiCount > b2_maxSubSteps)
+				{
+					continue;
+				}
+
+				minContact = c;
+				minAlpha = event.alpha;
+				break;
+			}
+
+			if (minContact == nullptr || 1.0f - 10.0f * b2_epsilon < minAlpha)
+			{
+				// No more TOI events.
+				break;
+			}
 
-					if (other->m_type != b2_staticBody)
+			// Advance the bodies to the TOI.
+			b2Fixture* fA = minContact->GetFixtureA();
+			b2Fixture* fB = minContact->GetFixtureB();
+			b2Body* bA = fA->GetBody();
+			b2Body* bB = fB->GetBody();
+
+			if (groupSize > 0 && IsTOIIsolated(bA, bB) == false)
+			{
+				// Leave the event for the next group.
+				m_toiQueue.Push(minAlpha, minContact->m_awakeIndex);
+				break;
+			}
+
+			b2Sweep backup1 = bA->m_sweep;
+			b2Sweep backup2 = bB->m_sweep;
+
+			bA->Advance(minAlpha);
+			bB->Advance(minAlpha);
+
+			// The TOI contact likely has some new contact points.
+			minContact->Update(m_contactManager.m_contactListener);
+			minContact->m_flags &= ~b2Contact::e_toiFlag;
+			++minContact->m_toiCount;
+
+			// Is the contact solid?
+			if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+			{
+				// Restore the sweeps.
+				minContact->SetEnabled(false);
+				bA->m_sweep = backup1;
+				bB->m_sweep = backup2;
+				bA->SynchronizeTransform();
+				bB->SynchronizeTransform();
+				continue;
+			}
+
+			bA->SetAwake(true);
+			bB->SetAwake(true);
+
+			// Build the island
+			b2Island* island = new (islands + groupSize) b2Island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0,
+																	&m_stackAllocator, m_contactManager.m_contactListener);
+			++groupSize;
+
+			island->Add(bA);
+			island->Add(bB);
+			island->Add(minContact);
+
+			bA->m_flags |= b2Body::e_islandFlag;
+			bB->m_flags |= b2Body::e_islandFlag;
+			minContact->m_flags |= b2Contact::e_islandFlag;
+
+			// Get contacts on bodyA and bodyB.
+			b2Body* bodies[2] = {bA, bB};
+			for (int32 i = 0; i < 2; ++i)
+			{
+				b2Body* body = bodies[i];
+				if (body->m_type == b2_dynamicBody)
+				{
+					for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 					{
-						other->SetAwake(true);
+						if (island->m_bodyCount == island->m_bodyCapacity)
+						{
+							break;
+						}
+
+						if (island->m_contactCount == island->m_contactCapacity)
+						{
+							break;
+						}
+
+						b2Contact* contact = ce->contact;
+
+						// Has this contact already been added to the island?
+						if (contact->m_flags & b2Contact::e_islandFlag)
+						{
+							continue;
+						}
+
+						// Only add static, kinematic, or bullet bodies.
+						b2Body* other = ce->other;
+						if (other->m_type == b2_dynamicBody &&
+							body->IsBullet() == false && other->IsBullet() == false)
+						{
+							continue;
+						}
+
+						// Skip sensors.
+						bool sensorA = contact->m_fixtureA->m_isSensor;
+						bool sensorB = contact->m_fixtureB->m_isSensor;
+						if (sensorA || sensorB)
+						{
+							continue;
+						}
+
+						// Tentatively advance the body to the TOI.
+						b2Sweep backup = other->m_sweep;
+						if ((other->m_flags & b2Body::e_islandFlag) == 0)
+						{
+							other->Advance(minAlpha);
+						}
+
+						// Update the contact points
+						contact->Update(m_contactManager.m_contactListener);
+
+						// Was the contact disabled by the user?
+						if (contact->IsEnabled() == false)
+						{
+							other->m_sweep = backup;
+							other->SynchronizeTransform();
+							continue;
+						}
+
+						// Are there contact points?
+						if (contact->IsTouching() == false)
+						{
+							other->m_sweep = backup;
+							other->SynchronizeTransform();
+							continue;
+						}
+
+						// Add the contact to the island
+						contact->m_flags |= b2Contact::e_islandFlag;
+						island->Add(contact);
+
+						// Has the other body already been added to the island?
+						if (other->m_flags & b2Body::e_islandFlag)
+						{
+							continue;
+						}
+						
+						// Add the other body to the island.
+						other->m_flags |= b2Body::e_islandFlag;
+
+						if (other->m_type != b2_staticBody)
+						{
+							other->SetAwake(true);
+						}
+
+						island->Add(other);
 					}
+				}
+			}
 
-					island.Add(other);
+			b2TimeStep subStep;
+			subStep.dt = (1.0f - minAlpha) * step.dt;
+			subStep.inv_dt = 1.0f / subStep.dt;
+			subStep.dtRatio = 1.0f;
+			subStep.positionIterations = 20;
+			subStep.velocityIterations = step.velocityIterations;
+			subStep.warmStarting = false;
+			subStep.speculative = false;
+			island->PrepareTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+
+			// Static bodies may be shared with the next island of the group.
+			for (int32 i = 0; i < island->m_bodyCount; ++i)
+			{
+				b2Body* body = island->m_bodies[i];
+				if (body->m_type == b2_staticBody)
+				{
+					body->m_flags &= ~b2Body::e_islandFlag;
 				}
 			}
 		}
 
-		b2TimeStep subStep;
-		subStep.dt = (1.0f - minAlpha) * step.dt;
-		subStep.inv_dt = 1.0f / subStep.dt;
-		subStep.dtRatio = 1.0f;
-		subStep.positionIterations = 20;
-		subStep.velocityIterations = step.velocityIterations;
-		subStep.warmStarting = false;
-		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+		if (groupSize == 0)
+		{
+			// No more TOI events. Done!
+			m_stepComplete = true;
+			break;
+		}
 
-		// Reset island flags and synchronize broad-phase proxies.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		if (groupSize > 1 && m_taskScheduler)
+		{
+			b2TOISolveTask task;
+			task.islands = islands;
+			m_taskScheduler->ParallelFor(&task, groupSize, 1);
+		}
+		else
+		{
+			for (int32 i = 0; i < groupSize; ++i)
+			{
+				islands[i].SolveTOIConstraints();
+			}
+		}
+
+		int32 edgeCount = 0;
+		for (int32 k = 0; k < groupSize; ++k)
 		{
-			b2Body* body = island.m_bodies[i];
-			body->m_flags &= ~b2Body::e_islandFlag;
+			b2Island* island = islands + k;
+			island->FinishTOI();
 
-			if (body->m_type != b2_dynamicBody)
+			for (int32 i = 0; i < island->m_bodyCount; ++i)
 			{
-				continue;
+				b2Body* body = island->m_bodies[i];
+				if (body->m_type == b2_dynamicBody)
+				{
+					for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+					{
+						++edgeCount;
+					}
+				}
 			}
+		}
 
-			body->SynchronizeFixtures();
+		int32* invalidated = (int32*)m_stackAllocator.Allocate(edgeCount * sizeof(int32));
+		int32 invalidatedCount = 0;
 
-			// Invalidate all contact TOIs on this displaced body.
-			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+		// Reset island flags and synchronize broad-phase proxies.
+		for (int32 k = 0; k < groupSize; ++k)
+		{
+			b2Island* island = islands + k;
+			for (int32 i = 0; i < island->m_bodyCount; ++i)
 			{
-				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+				b2Body* body = island->m_bodies[i];
+				body->m_flags &= ~b2Body::e_islandFlag;
+
+				if (body->m_type != b2_dynamicBody)
+				{
+					continue;
+				}
+
+				body->SynchronizeFixtures();
+
+				// Invalidate all contact TOIs on this displaced body.
+				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+				{
+					ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+
+					// The bodies are awake, so are their contacts.
+					b2Assert(ce->contact->m_awakeIndex != -1);
+					invalidated[invalidatedCount++] = ce->contact->m_awakeIndex;
+				}
 			}
 		}
 
@@ -886,17 +1222,48 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		// Also, some contacts can be destroyed.
 		m_contactManager.FindNewContacts();
 
+		// Queue the invalidated contacts and then the contacts that became awake, in
+		// awake array order. The TOI computation advances sweeps, so the order matters.
+		std::sort(invalidated, invalidated + invalidatedCount);
+		for (int32 i = 0; i < invalidatedCount; ++i)
+		{
+			if (i == 0 || invalidated[i] != invalidated[i - 1])
+			{
+				QueueTOI(invalidated[i]);
+			}
+		}
+		m_stackAllocator.Free(invalidated);
+
+		for (int32 i = queuedCount; i < m_contactManager.m_awakeContactCount; ++i)
+		{
+			QueueTOI(i);
+		}
+		queuedCount = m_contactManager.m_awakeContactCount;
+
+		// The solvers and islands use the stack allocator, so free them in reverse.
+		for (int32 k = groupSize - 1; k >= 0; --k)
+		{
+			islands[k].ReleaseTOI();
+			islands[k].~b2Island();
+		}
+
 		if (m_subStepping)
 		{
 			m_stepComplete = false;
 			break;
 		}
 	}
+
+	m_stackAllocator.Free(islands);
 }
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
+	int32 reinsertCount = m_contactManager.m_broadPhase.GetReinsertCount();
+
+	// Events of the previous step are dropped here, not at its end, so they can be read after Step.
+	m_eventBuffer.Clear();
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
@@ -923,6 +1290,21 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.speculative = m_speculativeContacts;
+
+	// Contacts updated during this step look ahead by one step.
+	m_speculativeTime = m_speculativeContacts ? dt : 0.0f;
+
+	m_profile.gjkCalls = 0;
+	m_profile.gjkIters = 0;
+	m_profile.gjkMaxIters = 0;
+	m_profile.toiCalls = 0;
+	m_profile.toiIters = 0;
+	m_profile.toiRootIters = 0;
+	m_profile.polygonCacheCalls = 0;
+	m_profile.polygonCacheHits = 0;
+	m_profile.polygonCacheClimbs = 0;
+	m_profile.polygonCacheMisses = 0;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -939,8 +1321,8 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_profile.solve = timer.GetMilliseconds();
 	}
 
-	// Handle TOI events.
-	if (m_continuousPhysics && step.dt > 0.0f)
+	// Handle TOI events. Speculative contacts already stopped fast bodies.
+	if (m_continuousPhysics && m_speculativeContacts == false && step.dt > 0.0f)
 	{
 		b2Timer timer;
 		SolveTOI(step);
@@ -959,15 +1341,63 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
+	m_profile.broadphaseReinserts = m_contactManager.m_broadPhase.GetReinsertCount() - reinsertCount;
+	m_profile.broadphasePairs = m_contactManager.m_contactCount;
+
+	// Fold any stack overflow segments into one so the next step does not allocate.
+	m_profile.stackHighWater = m_stackAllocator.GetHighWaterMark();
+	m_profile.stackOverflows = m_stackAllocator.GetOverflowCount();
+	m_stackAllocator.Reset();
+
+	if (m_stateHashing)
+	{
+		UpdateStateHash();
+	}
+
 	m_profile.step = stepTimer.GetMilliseconds();
 }
 
+void b2World::SetStateHashing(bool flag)
+{
+	m_stateHashing = flag;
+	m_stateHash = b2_stateHashSeed;
+}
+
+// Mix the raw bits of a float into a FNV-1a style hash. Hashing bits instead of
+// values tells apart results that differ only in the last place.
+inline uint32 b2HashFloat(uint32 hash, float32 x)
+{
+	uint32 bits;
+	memcpy(&bits, &x, sizeof(uint32));
+	return (hash ^ bits) * 16777619u;
+}
+
+void b2World::UpdateStateHash()
+{
+	uint32 hash = m_stateHash;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		hash = b2HashFloat(hash, b->m_xf.p.x);
+		hash = b2HashFloat(hash, b->m_xf.p.y);
+		hash = b2HashFloat(hash, b->m_sweep.a);
+		hash = b2HashFloat(hash, b->m_linearVelocity.x);
+		hash = b2HashFloat(hash, b->m_linearVelocity.y);
+		hash = b2HashFloat(hash, b->m_angularVelocity);
+	}
+	m_stateHash = hash;
+}
+
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
+	// Forces are zeroed when a body falls asleep and are ignored while it sleeps.
+	// Inactive bodies are in no island, b2Body::SetActive zeroes their forces.
+	for (b2PersistentIsland* island = m_islandGraph.m_awakeList; island; island = island->next)
 	{
-		body->m_force.SetZero();
-		body->m_torque = 0.0f;
+		for (b2Body* body = island->bodyList; body; body = body->m_islandNext)
+		{
+			body->m_force.SetZero();
+			body->m_torque = 0.0f;
+		}
 	}
 }
 
@@ -1103,6 +1533,55 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
 			m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
 		}
 		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* capsule = (b2CapsuleShape*)fixture->GetShape();
+			b2Vec2 v1 = b2Mul(xf, capsule->m_vertex1);
+			b2Vec2 v2 = b2Mul(xf, capsule->m_vertex2);
+			float32 radius = capsule->m_radius;
+
+			b2Vec2 axis = v2 - v1;
+			axis.Normalize();
+			b2Vec2 offset = radius * b2Cross(axis, 1.0f);
+
+			m_debugDraw->DrawSolidCircle(v1, radius, -axis, color);
+			m_debugDraw->DrawSolidCircle(v2, radius, axis, color);
+			m_debugDraw->DrawSegment(v1 + offset, v2 + offset, color);
+			m_debugDraw->DrawSegment(v1 - offset, v2 - offset, color);
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			b2TerrainShape* terrain = (b2TerrainShape*)fixture->GetShape();
+			const b2Vec2* vertices = terrain->m_vertices;
+
+			b2Vec2 v1 = b2Mul(xf, vertices[0]);
+			for (int32 i = 1; i < terrain->m_count; ++i)
+			{
+				b2Vec2 v2 = b2Mul(xf, vertices[i]);
+				m_debugDraw->DrawSegment(v1, v2, color);
+				v1 = v2;
+			}
+		}
+		break;
+
+	case b2Shape::e_distanceField:
+		{
+			// Draw the box covered by the grid.
+			b2DistanceFieldShape* field = (b2DistanceFieldShape*)fixture->GetShape();
+			b2Vec2 size = field->m_cellSize * b2Vec2(float32(field->m_width - 1), float32(field->m_height - 1));
+			b2Vec2 lower = field->m_origin, upper = field->m_origin + size;
+
+			b2Vec2 vertices[4];
+			vertices[0] = b2Mul(xf, lower);
+			vertices[1] = b2Mul(xf, b2Vec2(upper.x, lower.y));
+			vertices[2] = b2Mul(xf, upper);
+			vertices[3] = b2Mul(xf, b2Vec2(lower.x, upper.y));
+			m_debugDraw->DrawPolygon(vertices, 4, color);
+		}
+		break;
             
     default:
         break;
@@ -1283,6 +1762,33 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+void b2World::SetStackCapacity(int32 capacity)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_stackAllocator.SetCapacity(capacity);
+}
+
+void b2World::SetAABBExtensionLimits(float32 minExtension, float32 maxExtension)
+{
+	m_contactManager.m_broadPhase.SetExtensionLimits(minExtension, maxExtension);
+}
+
+void b2World::ReorderBroadPhase(b2TreeLayout layout)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.Reorder(layout);
+}
+
 void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	b2Assert((m_flags & e_locked) == 0);
@@ -1306,6 +1812,1554 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
 }
 
+// Snapshot layout, all values in native byte order:
+// header, world flags, bodies, fixture proxies, broad-phase, contacts, joints, islands,
+// awake contacts.
+const uint32 b2_stateMagic = 0x54533242;	// "B2ST"
+const int32 b2_stateVersion = 7;
+
+struct b2StateHeader
+{
+	uint32 magic;
+	int32 version;
+	int32 size;
+	int32 bodyCount;
+	int32 jointCount;
+	int32 proxyCount;
+	int32 contactCount;
+};
+
+void b2World::WriteContactKey(b2BinaryWriter* writer, const b2Contact* c)
+{
+	writer->Write(c->m_fixtureA->GetProxyId(c->m_indexA));
+	writer->Write(c->m_indexA);
+	writer->Write(c->m_fixtureB->GetProxyId(c->m_indexB));
+	writer->Write(c->m_indexB);
+}
+
+// Read a contact key and find the contact. The contact must exist.
+static b2Contact* b2FindContact(b2BinaryReader* reader, const b2BroadPhase* broadPhase)
+{
+	int32 proxyIdA = reader->Read<int32>();
+	int32 indexA = reader->Read<int32>();
+	int32 proxyIdB = reader->Read<int32>();
+	int32 indexB = reader->Read<int32>();
+	b2FixtureProxy* proxyA = (b2FixtureProxy*)broadPhase->GetUserData(proxyIdA);
+	b2FixtureProxy* proxyB = (b2FixtureProxy*)broadPhase->GetUserData(proxyIdB);
+
+	// Search the contacts of the first body.
+	for (b2ContactEdge* ce = proxyA->fixture->GetBody()->GetContactList(); ce; ce = ce->next)
+	{
+		b2Contact* c = ce->contact;
+		if (c->GetFixtureA() == proxyA->fixture && c->GetChildIndexA() == indexA &&
+			c->GetFixtureB() == proxyB->fixture && c->GetChildIndexB() == indexB)
+		{
+			return c;
+		}
+	}
+
+	b2Assert(false);
+	return nullptr;
+}
+
+// A contact key as read from a state.
+struct b2ContactKey
+{
+	int32 proxyIdA;
+	int32 indexA;
+	int32 proxyIdB;
+	int32 indexB;
+};
+
+struct b2ContactKeyLess
+{
+	bool operator()(const b2ContactKey& a, const b2ContactKey& b) const
+	{
+		if (a.proxyIdA != b.proxyIdA)
+		{
+			return a.proxyIdA < b.proxyIdA;
+		}
+
+		if (a.indexA != b.indexA)
+		{
+			return a.indexA < b.indexA;
+		}
+
+		if (a.proxyIdB != b.proxyIdB)
+		{
+			return a.proxyIdB < b.proxyIdB;
+		}
+
+		return a.indexB < b.indexB;
+	}
+};
+
+// Find a key among the sorted contact keys of a state. Returns -1 if it is missing.
+static int32 b2FindContactKey(const b2ContactKey* keys, int32 count, const b2ContactKey& key)
+{
+	b2ContactKeyLess less;
+	const b2ContactKey* k = std::lower_bound(keys, keys + count, key, less);
+	if (k == keys + count || less(key, *k))
+	{
+		return -1;
+	}
+
+	return int32(k - keys);
+}
+
+// The number of vertices in the distance proxy of a child shape. The simplex
+// cache of a contact indexes these.
+static int32 b2GetDistanceVertexCount(const b2Shape* shape)
+{
+	switch (shape->GetType())
+	{
+	case b2Shape::e_circle:
+		return 1;
+
+	case b2Shape::e_polygon:
+		return ((const b2PolygonShape*)shape)->m_count;
+
+	case b2Shape::e_distanceField:
+		return 0;
+
+	default:
+		return 2;
+	}
+}
+
+int32 b2World::SaveState(void* buffer, int32 capacity)
+{
+	b2BinaryWriter writer(buffer, capacity);
+
+	b2StateHeader header;
+	header.magic = b2_stateMagic;
+	header.version = b2_stateVersion;
+	header.size = 0;
+	header.bodyCount = m_bodyCount;
+	header.jointCount = m_jointCount;
+	header.proxyCount = m_contactManager.m_broadPhase.GetProxyCount();
+	header.contactCount = m_contactManager.m_contactCount;
+	writer.Write(header);
+
+	writer.Write(m_flags);
+	writer.Write(m_inv_dt0);
+	writer.Write(m_stepComplete);
+	writer.Write(m_stateHash);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		writer.Write(b->m_flags);
+		writer.Write(b->m_xf);
+		writer.Write(b->m_sweep);
+		writer.Write(b->m_linearVelocity);
+		writer.Write(b->m_angularVelocity);
+		writer.Write(b->m_force);
+		writer.Write(b->m_torque);
+		writer.Write(b->m_sleepTime);
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			writer.Write(f->m_proxyCount);
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				writer.Write(f->m_proxies[i].proxyId);
+				writer.Write(f->m_proxies[i].aabb);
+			}
+		}
+	}
+
+	m_contactManager.m_broadPhase.WriteState(&writer);
+
+	// Contacts are written oldest first so that re-creating them in order
+	// rebuilds the world and body contact lists in the same order.
+	b2Contact* tail = m_contactManager.m_contactList;
+	while (tail && tail->m_next)
+	{
+		tail = tail->m_next;
+	}
+
+	for (b2Contact* c = tail; c; c = c->m_prev)
+	{
+		WriteContactKey(&writer, c);
+		writer.Write(c->m_flags);
+		writer.Write(c->m_manifold);
+		writer.Write(c->m_relativeXf);
+		writer.Write(c->m_evaluatedDistance);
+		writer.Write(c->m_simplexCache);
+		writer.Write(c->m_toiCount);
+		writer.Write(c->m_toi);
+		writer.Write(c->m_friction);
+		writer.Write(c->m_restitution);
+		writer.Write(c->m_tangentSpeed);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		writer.Write(j->m_islandFlag);
+		j->WriteState(&writer);
+	}
+
+	// The islands decide the solver order, so they are part of the state.
+	// Bodies and joints are referenced by index and contacts by their keys.
+	int32 index = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_islandIndex = index++;
+	}
+
+	index = 0;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_index = index++;
+	}
+
+	// Islands are written back to front because restoring pushes them to the front.
+	b2PersistentIsland* lists[2] = {m_islandGraph.m_awakeList, m_islandGraph.m_sleepingList};
+	writer.Write(m_islandGraph.m_awakeCount);
+	writer.Write(m_islandGraph.m_sleepingCount);
+	for (int32 k = 0; k < 2; ++k)
+	{
+		b2PersistentIsland* island = lists[k];
+		while (island && island->next)
+		{
+			island = island->next;
+		}
+
+		for (; island; island = island->prev)
+		{
+			writer.Write(island->constraintRemoveCount);
+
+			writer.Write(island->bodyCount);
+			for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+			{
+				writer.Write(b->m_islandIndex);
+			}
+
+			writer.Write(island->contactCount);
+			for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+			{
+				WriteContactKey(&writer, c);
+			}
+
+			writer.Write(island->jointCount);
+			for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+			{
+				writer.Write(j->m_index);
+			}
+		}
+	}
+
+	// The awake contact order decides the collide and TOI order.
+	writer.Write(m_contactManager.m_awakeContactCount);
+	for (int32 i = 0; i < m_contactManager.m_awakeContactCount; ++i)
+	{
+		b2Contact* c = m_contactManager.m_awakeContacts[i];
+		WriteContactKey(&writer, c);
+	}
+
+	// Patch the size into the header.
+	int32 size = writer.GetSize();
+	writer.WriteAt(offsetof(b2StateHeader, size), &size, sizeof(int32));
+	return size;
+}
+
+bool b2World::CheckState(const void* buffer, int32 size)
+{
+	b2BinaryReader reader(buffer, size);
+
+	b2StateHeader header;
+	reader.Read(&header);
+	if (reader.IsValid() == false ||
+		header.magic != b2_stateMagic ||
+		header.version != b2_stateVersion ||
+		header.size != size ||
+		header.bodyCount != m_bodyCount ||
+		header.jointCount != m_jointCount ||
+		header.proxyCount != m_contactManager.m_broadPhase.GetProxyCount() ||
+		header.contactCount < 0 || size / int32(sizeof(b2ContactKey)) < header.contactCount)
+	{
+		return false;
+	}
+
+	reader.Skip(sizeof(m_flags) + sizeof(m_inv_dt0) + sizeof(m_stepComplete) + sizeof(m_stateHash));
+
+	// The bodies must keep their active state and the fixtures their proxies.
+	int32 simulatedCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		uint16 flags = reader.Read<uint16>();
+		if ((flags & b2Body::e_activeFlag) != (b->m_flags & b2Body::e_activeFlag))
+		{
+			return false;
+		}
+
+		if (b->IsActive() && b->m_type != b2_staticBody)
+		{
+			++simulatedCount;
+		}
+
+		reader.Skip(sizeof(b->m_xf) + sizeof(b->m_sweep) + sizeof(b->m_linearVelocity) +
+			sizeof(b->m_angularVelocity) + sizeof(b->m_force) + sizeof(b->m_torque) + sizeof(b->m_sleepTime));
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			if (reader.Read<int32>() != f->m_proxyCount)
+			{
+				return false;
+			}
+
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				if (reader.Read<int32>() != f->m_proxies[i].proxyId)
+				{
+					return false;
+				}
+				reader.Skip(sizeof(b2AABB));
+			}
+		}
+	}
+
+	const b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	if (reader.IsValid() == false || broadPhase->CheckState(&reader) == false)
+	{
+		return false;
+	}
+
+	// Each contact must be a distinct pair of fixture children that the factory
+	// creates in the saved order.
+	b2ContactKey* keys = (b2ContactKey*)m_stackAllocator.Allocate(header.contactCount * sizeof(b2ContactKey));
+	uint8* marks = (uint8*)m_stackAllocator.Allocate(header.contactCount * sizeof(uint8));
+	memset(marks, 0, header.contactCount * sizeof(uint8));
+	bool valid = true;
+
+	for (int32 i = 0; valid && i < header.contactCount; ++i)
+	{
+		b2ContactKey* key = keys + i;
+		reader.Read(key);
+
+		// The proxy of each child must be the proxy in the key.
+		int32 proxyIds[2] = {key->proxyIdA, key->proxyIdB};
+		int32 childIndices[2] = {key->indexA, key->indexB};
+		b2Fixture* fixtures[2] = {nullptr, nullptr};
+		for (int32 n = 0; n < 2; ++n)
+		{
+			if (broadPhase->IsProxy(proxyIds[n]) == false)
+			{
+				break;
+			}
+
+			b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyIds[n]);
+			b2Fixture* fixture = proxy->fixture;
+			if (0 <= childIndices[n] && childIndices[n] < fixture->m_shape->GetChildCount() &&
+				fixture->GetProxyId(childIndices[n]) == proxyIds[n])
+			{
+				fixtures[n] = fixture;
+			}
+		}
+
+		b2Fixture* fixtureA = fixtures[0];
+		b2Fixture* fixtureB = fixtures[1];
+		if (reader.IsValid() == false || fixtureA == nullptr || fixtureB == nullptr ||
+			fixtureA->m_body == fixtureB->m_body)
+		{
+			valid = false;
+			break;
+		}
+
+		const b2ContactRegister* reg = b2Contact::GetRegister(fixtureA->GetType(), fixtureB->GetType());
+		if (reg->createFcn == nullptr || reg->primary == false)
+		{
+			valid = false;
+			break;
+		}
+
+		reader.Skip(sizeof(uint32));
+
+		b2Manifold manifold;
+		reader.Read(&manifold);
+		// The type of an empty manifold is not set.
+		int32 manifoldType;
+		memcpy(&manifoldType, &manifold.type, sizeof(int32));
+		if (manifold.pointCount < 0 || b2_maxManifoldPoints < manifold.pointCount ||
+			(manifold.pointCount > 0 && (manifoldType < b2Manifold::e_circles || b2Manifold::e_faceB < manifoldType)))
+		{
+			valid = false;
+			break;
+		}
+
+		reader.Skip(sizeof(b2Transform) + sizeof(float32));
+
+		b2SimplexCache cache;
+		reader.Read(&cache);
+		int32 vertexCountA = b2GetDistanceVertexCount(fixtureA->m_shape);
+		int32 vertexCountB = b2GetDistanceVertexCount(fixtureB->m_shape);
+		if (cache.count > 3)
+		{
+			valid = false;
+			break;
+		}
+
+		for (int32 n = 0; n < cache.count; ++n)
+		{
+			if (cache.indexA[n] >= vertexCountA || cache.indexB[n] >= vertexCountB)
+			{
+				valid = false;
+			}
+		}
+
+		reader.Skip(sizeof(int32) + 4 * sizeof(float32));
+	}
+
+	int32 keyCount = header.contactCount;
+	std::sort(keys, keys + keyCount, b2ContactKeyLess());
+	for (int32 i = 1; valid && i < keyCount; ++i)
+	{
+		if (b2ContactKeyLess()(keys[i - 1], keys[i]) == false)
+		{
+			valid = false;
+		}
+	}
+
+	// The joint states have a fixed size for each joint.
+	for (b2Joint* j = m_jointList; valid && j; j = j->m_next)
+	{
+		b2BinaryWriter sizer(nullptr, 0);
+		j->WriteState(&sizer);
+		reader.Skip(sizeof(j->m_islandFlag) + sizer.GetSize());
+	}
+
+	// Each simulated body, contact and joint may be in one island at most.
+	uint8* bodyMarks = (uint8*)m_stackAllocator.Allocate(m_bodyCount * sizeof(uint8));
+	memset(bodyMarks, 0, m_bodyCount * sizeof(uint8));
+	uint8* jointMarks = (uint8*)m_stackAllocator.Allocate(m_jointCount * sizeof(uint8));
+	memset(jointMarks, 0, m_jointCount * sizeof(uint8));
+
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	int32 index = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		bodies[index++] = b;
+	}
+
+	int32 islandBodyCount = 0;
+	int32 islandCounts[2];
+	reader.Read(&islandCounts[0]);
+	reader.Read(&islandCounts[1]);
+	for (int32 k = 0; k < 2; ++k)
+	{
+		for (int32 i = 0; valid && reader.IsValid() && i < islandCounts[k]; ++i)
+		{
+			reader.Skip(sizeof(int32));
+
+			int32 count = reader.Read<int32>();
+			if (count <= 0)
+			{
+				valid = false;
+				break;
+			}
+
+			for (int32 n = 0; valid && reader.IsValid() && n < count; ++n)
+			{
+				int32 bodyIndex = reader.Read<int32>();
+				if (bodyIndex < 0 || m_bodyCount <= bodyIndex || bodyMarks[bodyIndex] != 0 ||
+					bodies[bodyIndex]->IsActive() == false || bodies[bodyIndex]->m_type == b2_staticBody)
+				{
+					valid = false;
+					break;
+				}
+				bodyMarks[bodyIndex] = 1;
+				++islandBodyCount;
+			}
+
+			count = reader.Read<int32>();
+			for (int32 n = 0; valid && reader.IsValid() && n < count; ++n)
+			{
+				b2ContactKey key;
+				reader.Read(&key);
+				int32 keyIndex = b2FindContactKey(keys, keyCount, key);
+				if (keyIndex == -1 || (marks[keyIndex] & 1) != 0)
+				{
+					valid = false;
+					break;
+				}
+				marks[keyIndex] |= 1;
+			}
+
+			count = reader.Read<int32>();
+			for (int32 n = 0; valid && reader.IsValid() && n < count; ++n)
+			{
+				int32 jointIndex = reader.Read<int32>();
+				if (jointIndex < 0 || m_jointCount <= jointIndex || jointMarks[jointIndex] != 0)
+				{
+					valid = false;
+					break;
+				}
+				jointMarks[jointIndex] = 1;
+			}
+		}
+	}
+
+	valid = valid && islandCounts[0] >= 0 && islandCounts[1] >= 0 && islandBodyCount == simulatedCount;
+
+	// The awake contacts are distinct.
+	int32 awakeCount = reader.Read<int32>();
+	valid = valid && 0 <= awakeCount && awakeCount <= keyCount;
+	for (int32 i = 0; valid && reader.IsValid() && i < awakeCount; ++i)
+	{
+		b2ContactKey key;
+		reader.Read(&key);
+		int32 keyIndex = b2FindContactKey(keys, keyCount, key);
+		if (keyIndex == -1 || (marks[keyIndex] & 2) != 0)
+		{
+			valid = false;
+			break;
+		}
+		marks[keyIndex] |= 2;
+	}
+
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(jointMarks);
+	m_stackAllocator.Free(bodyMarks);
+	m_stackAllocator.Free(marks);
+	m_stackAllocator.Free(keys);
+
+	return valid && reader.IsValid() && reader.GetPosition() == size;
+}
+
+bool b2World::RestoreState(const void* buffer, int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	// Check the whole buffer before changing anything.
+	if (CheckState(buffer, size) == false)
+	{
+		return false;
+	}
+
+	b2BinaryReader reader(buffer, size);
+
+	b2StateHeader header;
+	reader.Read(&header);
+
+	// Remove the current contacts without reporting them.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	m_contactManager.m_contactListener = nullptr;
+	while (m_contactManager.m_contactList)
+	{
+		m_contactManager.Destroy(m_contactManager.m_contactList);
+	}
+	m_contactManager.m_contactListener = listener;
+
+	reader.Read(&m_flags);
+	reader.Read(&m_inv_dt0);
+	reader.Read(&m_stepComplete);
+	reader.Read(&m_stateHash);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		reader.Read(&b->m_flags);
+		reader.Read(&b->m_xf);
+		reader.Read(&b->m_sweep);
+		reader.Read(&b->m_linearVelocity);
+		reader.Read(&b->m_angularVelocity);
+		reader.Read(&b->m_force);
+		reader.Read(&b->m_torque);
+		reader.Read(&b->m_sleepTime);
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			int32 proxyCount = reader.Read<int32>();
+			b2Assert(proxyCount == f->m_proxyCount);
+			B2_NOT_USED(proxyCount);
+
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				int32 proxyId = reader.Read<int32>();
+				b2Assert(proxyId == f->m_proxies[i].proxyId);
+				B2_NOT_USED(proxyId);
+				reader.Read(&f->m_proxies[i].aabb);
+			}
+		}
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	bool readBroadPhase = broadPhase->ReadState(&reader);
+	b2Assert(readBroadPhase);
+	B2_NOT_USED(readBroadPhase);
+
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		int32 proxyIdA = reader.Read<int32>();
+		int32 indexA = reader.Read<int32>();
+		int32 proxyIdB = reader.Read<int32>();
+		int32 indexB = reader.Read<int32>();
+		b2FixtureProxy* proxyA = (b2FixtureProxy*)broadPhase->GetUserData(proxyIdA);
+		b2FixtureProxy* proxyB = (b2FixtureProxy*)broadPhase->GetUserData(proxyIdB);
+		b2Assert(proxyA && proxyA->proxyId == proxyIdA);
+		b2Assert(proxyB && proxyB->proxyId == proxyIdB);
+
+		// The saved order is the primary order, so the factory does not swap.
+		b2Contact* c = b2Contact::Create(proxyA->fixture, indexA,
+			proxyB->fixture, indexB, &m_blockAllocator);
+		b2Assert(c && c->m_fixtureA == proxyA->fixture);
+
+		reader.Read(&c->m_flags);
+		reader.Read(&c->m_manifold);
+		reader.Read(&c->m_relativeXf);
+		reader.Read(&c->m_evaluatedDistance);
+		reader.Read(&c->m_simplexCache);
+		reader.Read(&c->m_toiCount);
+		reader.Read(&c->m_toi);
+		reader.Read(&c->m_friction);
+		reader.Read(&c->m_restitution);
+		reader.Read(&c->m_tangentSpeed);
+
+		m_contactManager.Link(c);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		reader.Read(&j->m_islandFlag);
+		j->ReadState(&reader);
+	}
+
+	m_islandGraph.Clear();
+
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	int32 index = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		bodies[index++] = b;
+	}
+
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	index = 0;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		joints[index++] = j;
+	}
+
+	int32 islandCounts[2];
+	reader.Read(&islandCounts[0]);
+	reader.Read(&islandCounts[1]);
+	for (int32 k = 0; k < 2; ++k)
+	{
+		for (int32 i = 0; reader.IsValid() && i < islandCounts[k]; ++i)
+		{
+			b2PersistentIsland* island = m_islandGraph.CreateIsland(k == 0);
+			reader.Read(&island->constraintRemoveCount);
+
+			int32 count = reader.Read<int32>();
+			for (int32 n = 0; n < count; ++n)
+			{
+				int32 bodyIndex = reader.Read<int32>();
+				b2Assert(0 <= bodyIndex && bodyIndex < m_bodyCount);
+				m_islandGraph.Append(island, bodies[bodyIndex]);
+			}
+
+			count = reader.Read<int32>();
+			for (int32 n = 0; n < count; ++n)
+			{
+				m_islandGraph.Append(island, b2FindContact(&reader, broadPhase));
+			}
+
+			count = reader.Read<int32>();
+			for (int32 n = 0; n < count; ++n)
+			{
+				int32 jointIndex = reader.Read<int32>();
+				b2Assert(0 <= jointIndex && jointIndex < m_jointCount);
+				m_islandGraph.Append(island, joints[jointIndex]);
+			}
+		}
+	}
+
+	int32 awakeCount = reader.Read<int32>();
+	b2Assert(0 <= awakeCount && awakeCount <= m_contactManager.m_contactCount);
+	b2Contact** awakeContacts = (b2Contact**)m_stackAllocator.Allocate(awakeCount * sizeof(b2Contact*));
+	for (int32 i = 0; reader.IsValid() && i < awakeCount; ++i)
+	{
+		awakeContacts[i] = b2FindContact(&reader, broadPhase);
+	}
+
+	if (reader.IsValid())
+	{
+		m_contactManager.SetAwakeContacts(awakeContacts, awakeCount);
+	}
+
+	m_stackAllocator.Free(awakeContacts);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(bodies);
+
+	b2Assert(reader.IsValid() && reader.GetPosition() == size);
+	return reader.IsValid();
+}
+
+// World image layout, all values in native byte order:
+// header, then chunks of { id, size, payload padded to 8 bytes }.
+// Unknown chunks are skipped so later versions can add chunks.
+// Version 2 adds the contact events of each fixture.
+const uint32 b2_fileMagic = 0x46573242;		// "B2WF"
+const int32 b2_fileVersion = 2;
+const uint32 b2_worldChunk = 0x444c5257;	// "WRLD" world settings
+const uint32 b2_bodyChunk = 0x59444f42;		// "BODY" bodies, fixtures and shapes
+const uint32 b2_vertexChunk = 0x54524556;	// "VERT" chain vertices
+const uint32 b2_jointChunk = 0x544e4f4a;	// "JONT" joints
+const uint32 b2_treeChunk = 0x45455254;		// "TREE" broad-phase tree
+const int32 b2_chunkAlignment = 8;
+
+struct b2FileHeader
+{
+	uint32 magic;
+	int32 version;
+	int32 size;
+	int32 chunkCount;
+};
+
+struct b2ChunkHeader
+{
+	uint32 id;
+	int32 size;
+};
+
+static int32 b2BeginChunk(b2BinaryWriter* writer, uint32 id)
+{
+	b2ChunkHeader header;
+	header.id = id;
+	header.size = 0;
+	writer->Write(header);
+	return writer->GetSize();
+}
+
+static void b2EndChunk(b2BinaryWriter* writer, int32 start)
+{
+	int32 size = writer->GetSize() - start;
+	writer->WriteAt(start - sizeof(b2ChunkHeader) + offsetof(b2ChunkHeader, size), &size, sizeof(int32));
+	writer->Align(b2_chunkAlignment);
+}
+
+static void b2WriteShape(b2BinaryWriter* writer, const b2Shape* shape, int32* vertexOffset)
+{
+	writer->Write(int32(shape->m_type));
+	writer->Write(shape->m_radius);
+
+	switch (shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* s = (const b2CircleShape*)shape;
+			writer->Write(s->m_p);
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			const b2EdgeShape* s = (const b2EdgeShape*)shape;
+			writer->Write(s->m_vertex0);
+			writer->Write(s->m_vertex1);
+			writer->Write(s->m_vertex2);
+			writer->Write(s->m_vertex3);
+			writer->Write(s->m_hasVertex0);
+			writer->Write(s->m_hasVertex3);
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			// The vertices are written as is so loading does not recompute the hull.
+			const b2PolygonShape* s = (const b2PolygonShape*)shape;
+			writer->Write(s->m_centroid);
+			writer->Write(s->m_count);
+			writer->Write(s->m_vertices, s->m_count * sizeof(b2Vec2));
+			writer->Write(s->m_normals, s->m_count * sizeof(b2Vec2));
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			// The vertices go into the vertex chunk.
+			const b2ChainShape* s = (const b2ChainShape*)shape;
+			writer->Write(s->m_count);
+			writer->Write(*vertexOffset);
+			writer->Write(s->m_prevVertex);
+			writer->Write(s->m_nextVertex);
+			writer->Write(s->m_hasPrevVertex);
+			writer->Write(s->m_hasNextVertex);
+			*vertexOffset += s->m_count * sizeof(b2Vec2);
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			const b2CapsuleShape* s = (const b2CapsuleShape*)shape;
+			writer->Write(s->m_vertex1);
+			writer->Write(s->m_vertex2);
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			// The vertices are written inline. Loading rebuilds the segment tree.
+			const b2TerrainShape* s = (const b2TerrainShape*)shape;
+			writer->Write(s->m_count);
+			writer->Write(s->m_vertices, s->m_count * sizeof(b2Vec2));
+			writer->Write(s->m_prevVertex);
+			writer->Write(s->m_nextVertex);
+			writer->Write(s->m_hasPrevVertex);
+			writer->Write(s->m_hasNextVertex);
+		}
+		break;
+
+	case b2Shape::e_distanceField:
+		{
+			// The samples are written inline.
+			const b2DistanceFieldShape* s = (const b2DistanceFieldShape*)shape;
+			s->Write(writer);
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+int32 b2World::Save(void* buffer, int32 capacity)
+{
+	b2Assert(IsLocked() == false);
+
+	b2BinaryWriter writer(buffer, capacity);
+
+	b2FileHeader header;
+	header.magic = b2_fileMagic;
+	header.version = b2_fileVersion;
+	header.size = 0;
+	header.chunkCount = 5;
+	writer.Write(header);
+
+	int32 start = b2BeginChunk(&writer, b2_worldChunk);
+	writer.Write(m_gravity);
+	writer.Write(m_allowSleep);
+	writer.Write(m_warmStarting);
+	writer.Write(m_continuousPhysics);
+	writer.Write(m_subStepping);
+	writer.Write(GetAutoClearForces());
+	writer.Write(m_bodyCount);
+	writer.Write(m_jointCount);
+	b2EndChunk(&writer, start);
+
+	// Lists are written oldest first so loading creates everything in the
+	// same order and rebuilds the lists in the same order.
+	b2Body* lastBody = m_bodyList;
+	while (lastBody && lastBody->m_next)
+	{
+		lastBody = lastBody->m_next;
+	}
+
+	int32 vertexOffset = 0;
+	int32 chainCount = 0;
+	int32 bodyIndex = 0;
+	start = b2BeginChunk(&writer, b2_bodyChunk);
+	for (b2Body* b = lastBody; b; b = b->m_prev)
+	{
+		b->m_islandIndex = bodyIndex++;
+
+		writer.Write(int32(b->m_type));
+		writer.Write(b->m_xf.p);
+		writer.Write(b->m_sweep.a);
+		writer.Write(b->m_linearVelocity);
+		writer.Write(b->m_angularVelocity);
+		writer.Write(b->m_linearDamping);
+		writer.Write(b->m_angularDamping);
+		writer.Write(b->m_gravityScale);
+		writer.Write(b->m_sleepTime);
+		writer.Write(b->m_flags);
+
+		b2MassData massData;
+		b->GetMassData(&massData);
+		writer.Write(massData);
+
+		writer.Write(b->m_fixtureCount);
+
+		// Fixtures are singly linked, so gather them to walk backwards.
+		b2Fixture** fixtures = (b2Fixture**)m_stackAllocator.Allocate(b->m_fixtureCount * sizeof(b2Fixture*));
+		int32 fixtureCount = 0;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			fixtures[fixtureCount++] = f;
+		}
+
+		for (int32 i = fixtureCount - 1; i >= 0; --i)
+		{
+			b2Fixture* f = fixtures[i];
+			writer.Write(f->m_friction);
+			writer.Write(f->m_restitution);
+			writer.Write(f->m_density);
+			writer.Write(f->m_isSensor);
+			writer.Write(f->m_filter);
+			writer.Write(f->m_contactEvents);
+			b2WriteShape(&writer, f->m_shape, &vertexOffset);
+
+			writer.Write(f->m_proxyCount);
+			for (int32 k = 0; k < f->m_proxyCount; ++k)
+			{
+				writer.Write(f->m_proxies[k].proxyId);
+			}
+
+			if (f->m_shape->m_type == b2Shape::e_chain)
+			{
+				chainCount += 1;
+			}
+		}
+
+		m_stackAllocator.Free(fixtures);
+	}
+	b2EndChunk(&writer, start);
+
+	// The chain vertices in the same order as the shapes that use them.
+	start = b2BeginChunk(&writer, b2_vertexChunk);
+	for (b2Body* b = lastBody; b && chainCount > 0; b = b->m_prev)
+	{
+		b2Fixture** fixtures = (b2Fixture**)m_stackAllocator.Allocate(b->m_fixtureCount * sizeof(b2Fixture*));
+		int32 fixtureCount = 0;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			fixtures[fixtureCount++] = f;
+		}
+
+		for (int32 i = fixtureCount - 1; i >= 0; --i)
+		{
+			if (fixtures[i]->m_shape->m_type == b2Shape::e_chain)
+			{
+				const b2ChainShape* s = (const b2ChainShape*)fixtures[i]->m_shape;
+				writer.Write(s->m_vertices, s->m_count * sizeof(b2Vec2));
+				chainCount -= 1;
+			}
+		}
+
+		m_stackAllocator.Free(fixtures);
+	}
+	b2EndChunk(&writer, start);
+
+	b2Joint* lastJoint = m_jointList;
+	while (lastJoint && lastJoint->m_next)
+	{
+		lastJoint = lastJoint->m_next;
+	}
+
+	int32 jointIndex = 0;
+	start = b2BeginChunk(&writer, b2_jointChunk);
+	for (b2Joint* j = lastJoint; j; j = j->m_prev)
+	{
+		j->m_index = jointIndex++;
+
+		writer.Write(int32(j->m_type));
+		writer.Write(j->m_bodyA->m_islandIndex);
+		writer.Write(j->m_bodyB->m_islandIndex);
+		writer.Write(j->m_collideConnected);
+		j->WriteDefinition(&writer);
+	}
+	b2EndChunk(&writer, start);
+
+	start = b2BeginChunk(&writer, b2_treeChunk);
+	m_contactManager.m_broadPhase.WriteTree(&writer);
+	b2EndChunk(&writer, start);
+
+	int32 size = writer.GetSize();
+	writer.WriteAt(offsetof(b2FileHeader, size), &size, sizeof(int32));
+	return size;
+}
+
+// One shape of each type to read into. Fixtures clone them.
+struct b2ShapeSet
+{
+	b2CircleShape circle;
+	b2EdgeShape edge;
+	b2PolygonShape polygon;
+	b2ChainShape chain;
+	b2CapsuleShape capsule;
+	b2TerrainShape terrain;
+	b2DistanceFieldShape field;
+};
+
+static b2Shape* b2ReadShape(b2BinaryReader* reader, b2ShapeSet* shapes,
+							const b2BinaryReader* vertices, bool referenceVertices)
+{
+	int32 type = reader->Read<int32>();
+	float32 radius = reader->Read<float32>();
+
+	b2Shape* shape = nullptr;
+
+	switch (type)
+	{
+	case b2Shape::e_circle:
+		{
+			b2CircleShape* s = &shapes->circle;
+			reader->Read(&s->m_p);
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			b2EdgeShape* s = &shapes->edge;
+			reader->Read(&s->m_vertex0);
+			reader->Read(&s->m_vertex1);
+			reader->Read(&s->m_vertex2);
+			reader->Read(&s->m_vertex3);
+			reader->Read(&s->m_hasVertex0);
+			reader->Read(&s->m_hasVertex3);
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			b2PolygonShape* s = &shapes->polygon;
+			reader->Read(&s->m_centroid);
+			reader->Read(&s->m_count);
+			if (s->m_count < 3 || s->m_count > b2_maxPolygonVertices)
+			{
+				return nullptr;
+			}
+			reader->Read(s->m_vertices, s->m_count * sizeof(b2Vec2));
+			reader->Read(s->m_normals, s->m_count * sizeof(b2Vec2));
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			b2ChainShape* s = &shapes->chain;
+			s->Clear();
+
+			int32 count = reader->Read<int32>();
+			int32 offset = reader->Read<int32>();
+			if (count < 2 || offset < 0 || vertices->GetSize() < offset ||
+				(vertices->GetSize() - offset) / (int32)sizeof(b2Vec2) < count)
+			{
+				return nullptr;
+			}
+
+			// Reference the image directly if it is aligned for b2Vec2.
+			const uint8* data = (const uint8*)vertices->GetData() + offset;
+			if (referenceVertices && ((uintptr_t)data & (alignof(b2Vec2) - 1)) == 0)
+			{
+				s->CreateChainReference((const b2Vec2*)data, count);
+			}
+			else
+			{
+				s->m_count = count;
+				s->m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+				memcpy(s->m_vertices, data, count * sizeof(b2Vec2));
+			}
+
+			reader->Read(&s->m_prevVertex);
+			reader->Read(&s->m_nextVertex);
+			reader->Read(&s->m_hasPrevVertex);
+			reader->Read(&s->m_hasNextVertex);
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* s = &shapes->capsule;
+			reader->Read(&s->m_vertex1);
+			reader->Read(&s->m_vertex2);
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_terrain:
+		{
+			b2TerrainShape* s = &shapes->terrain;
+			s->Clear();
+
+			int32 count = reader->Read<int32>();
+			if (count < 2 || count > reader->GetSize() / (int32)sizeof(b2Vec2))
+			{
+				return nullptr;
+			}
+
+			// Copy the vertices out of the image, which may not be aligned for b2Vec2.
+			const void* data = reader->Skip(count * sizeof(b2Vec2));
+			if (data == nullptr)
+			{
+				return nullptr;
+			}
+			b2Vec2* vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+			memcpy(vertices, data, count * sizeof(b2Vec2));
+			s->Create(vertices, count);
+			b2Free(vertices);
+
+			reader->Read(&s->m_prevVertex);
+			reader->Read(&s->m_nextVertex);
+			reader->Read(&s->m_hasPrevVertex);
+			reader->Read(&s->m_hasNextVertex);
+			shape = s;
+		}
+		break;
+
+	case b2Shape::e_distanceField:
+		{
+			b2DistanceFieldShape* s = &shapes->field;
+			if (s->Read(reader) == false)
+			{
+				return nullptr;
+			}
+			shape = s;
+		}
+		break;
+
+	default:
+		return nullptr;
+	}
+
+	shape->m_radius = radius;
+	return shape;
+}
+
+static b2Joint* b2LoadJoint(b2World* world, b2JointDef* def, b2Body* bodyA, b2Body* bodyB, bool collideConnected)
+{
+	def->bodyA = bodyA;
+	def->bodyB = bodyB;
+	def->collideConnected = collideConnected;
+	return world->CreateJoint(def);
+}
+
+bool b2World::Load(const void* data, int32 size, bool referenceVertices)
+{
+	b2Assert(IsLocked() == false);
+	b2Assert(m_bodyCount == 0 && m_jointCount == 0);
+	if (IsLocked() || m_bodyCount > 0 || m_jointCount > 0)
+	{
+		return false;
+	}
+
+	b2BinaryReader reader(data, size);
+
+	b2FileHeader header;
+	reader.Read(&header);
+	if (reader.IsValid() == false ||
+		header.magic != b2_fileMagic ||
+		header.version < 1 || header.version > b2_fileVersion ||
+		header.size != size)
+	{
+		return false;
+	}
+
+	// Find the chunks.
+	b2BinaryReader worldChunk(nullptr, 0);
+	b2BinaryReader bodyChunk(nullptr, 0);
+	b2BinaryReader vertexChunk(nullptr, 0);
+	b2BinaryReader jointChunk(nullptr, 0);
+	b2BinaryReader treeChunk(nullptr, 0);
+	bool hasTree = false;
+	for (int32 i = 0; i < header.chunkCount; ++i)
+	{
+		b2ChunkHeader chunk;
+		reader.Read(&chunk);
+		const void* payload = reader.Skip(chunk.size);
+		if (payload == nullptr || chunk.size < 0)
+		{
+			return false;
+		}
+
+		int32 padding = (b2_chunkAlignment - reader.GetPosition() % b2_chunkAlignment) % b2_chunkAlignment;
+		reader.Skip(padding);
+
+		b2BinaryReader chunkReader(payload, chunk.size);
+		switch (chunk.id)
+		{
+		case b2_worldChunk:
+			worldChunk = chunkReader;
+			break;
+		case b2_bodyChunk:
+			bodyChunk = chunkReader;
+			break;
+		case b2_vertexChunk:
+			vertexChunk = chunkReader;
+			break;
+		case b2_jointChunk:
+			jointChunk = chunkReader;
+			break;
+		case b2_treeChunk:
+			treeChunk = chunkReader;
+			hasTree = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (reader.IsValid() == false)
+	{
+		return false;
+	}
+
+	// The settings are applied once the whole image is loaded.
+	b2Vec2 gravity = worldChunk.Read<b2Vec2>();
+	bool allowSleep = worldChunk.Read<bool>();
+	bool warmStarting = worldChunk.Read<bool>();
+	bool continuousPhysics = worldChunk.Read<bool>();
+	bool subStepping = worldChunk.Read<bool>();
+	bool autoClearForces = worldChunk.Read<bool>();
+	int32 bodyCount = worldChunk.Read<int32>();
+	int32 jointCount = worldChunk.Read<int32>();
+	// Bound the counts by the chunk sizes before allocating. A body takes more
+	// than 64 bytes and a joint more than three integers.
+	if (worldChunk.IsValid() == false ||
+		bodyCount < 0 || bodyChunk.GetSize() / 64 < bodyCount ||
+		jointCount < 0 || jointChunk.GetSize() / int32(3 * sizeof(int32)) < jointCount)
+	{
+		return false;
+	}
+
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCount * sizeof(b2Body*));
+	bool* activeFlags = (bool*)m_stackAllocator.Allocate(bodyCount * sizeof(bool));
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	b2ShapeSet shapes;
+	bool valid = true;
+	int32 proxyCount = 0;
+
+	// Bodies are created inactive and activated after everything is loaded,
+	// so a bad image can be undone without touching the islands.
+	for (int32 i = 0; valid && i < bodyCount; ++i)
+	{
+		b2BodyDef bd;
+		int32 type = bodyChunk.Read<int32>();
+		bodyChunk.Read(&bd.position);
+		bodyChunk.Read(&bd.angle);
+		b2Vec2 linearVelocity = bodyChunk.Read<b2Vec2>();
+		float32 angularVelocity = bodyChunk.Read<float32>();
+		bodyChunk.Read(&bd.linearDamping);
+		bodyChunk.Read(&bd.angularDamping);
+		bodyChunk.Read(&bd.gravityScale);
+		float32 sleepTime = bodyChunk.Read<float32>();
+		uint16 flags = bodyChunk.Read<uint16>();
+		b2MassData massData = bodyChunk.Read<b2MassData>();
+		int32 fixtureCount = bodyChunk.Read<int32>();
+		if (bodyChunk.IsValid() == false ||
+			type < b2_staticBody || b2_dynamicBody < type ||
+			massData.mass < 0.0f || massData.I < 0.0f)
+		{
+			valid = false;
+			break;
+		}
+
+		bd.type = (b2BodyType)type;
+		bd.awake = (flags & b2Body::e_awakeFlag) == b2Body::e_awakeFlag;
+		bd.allowSleep = (flags & b2Body::e_autoSleepFlag) == b2Body::e_autoSleepFlag;
+		bd.bullet = (flags & b2Body::e_bulletFlag) == b2Body::e_bulletFlag;
+		bd.fixedRotation = (flags & b2Body::e_fixedRotationFlag) == b2Body::e_fixedRotationFlag;
+		bd.active = false;
+
+		bool active = (flags & b2Body::e_activeFlag) == b2Body::e_activeFlag;
+
+		b2Body* b = CreateBody(&bd);
+		b->m_sleepTime = sleepTime;
+		bodies[i] = b;
+		activeFlags[i] = active;
+
+		for (int32 k = 0; valid && k < fixtureCount; ++k)
+		{
+			b2FixtureDef fd;
+			bodyChunk.Read(&fd.friction);
+			bodyChunk.Read(&fd.restitution);
+			bodyChunk.Read(&fd.density);
+			bodyChunk.Read(&fd.isSensor);
+			bodyChunk.Read(&fd.filter);
+			if (header.version >= 2)
+			{
+				bodyChunk.Read(&fd.contactEvents);
+			}
+
+			fd.shape = b2ReadShape(&bodyChunk, &shapes, &vertexChunk, referenceVertices);
+			if (fd.shape == nullptr || bodyChunk.IsValid() == false)
+			{
+				valid = false;
+				break;
+			}
+
+			b2Fixture* f = b->CreateFixture(&fd);
+
+			// With a stored tree the proxy ids are kept and attached below.
+			int32 fixtureProxyCount = bodyChunk.Read<int32>();
+			if (active && hasTree)
+			{
+				if (fixtureProxyCount != f->m_shape->GetChildCount())
+				{
+					valid = false;
+					break;
+				}
+
+				for (int32 p = 0; p < fixtureProxyCount; ++p)
+				{
+					b2FixtureProxy* proxy = f->m_proxies + p;
+					f->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, p);
+					proxy->fixture = f;
+					proxy->childIndex = p;
+					proxy->proxyId = bodyChunk.Read<int32>();
+				}
+				f->m_proxyCount = fixtureProxyCount;
+				proxyCount += fixtureProxyCount;
+			}
+			else
+			{
+				bodyChunk.Skip(fixtureProxyCount * sizeof(int32));
+			}
+		}
+
+		// Only apply mass data that was set by hand. Setting computed mass
+		// data again would round the rotational inertia.
+		b2MassData computed;
+		b->GetMassData(&computed);
+		if (memcmp(&computed, &massData, sizeof(b2MassData)) != 0)
+		{
+			// The inertia about the center of mass must stay positive.
+			float32 mass = massData.mass > 0.0f ? massData.mass : 1.0f;
+			if (massData.I > 0.0f && massData.I <= mass * b2Dot(massData.center, massData.center))
+			{
+				valid = false;
+				break;
+			}
+
+			b->SetMassData(&massData);
+		}
+
+		// Set the velocity last because adding fixtures adjusts it.
+		b->m_linearVelocity = linearVelocity;
+		b->m_angularVelocity = angularVelocity;
+	}
+
+	valid = valid && bodyChunk.IsValid() && m_bodyCount == bodyCount;
+
+	if (valid && hasTree)
+	{
+		// Each stored proxy id must be a distinct proxy of the stored tree. The
+		// user data of a new tree is null, so it marks the ids already used.
+		valid = broadPhase->ReadTree(&treeChunk) && broadPhase->GetProxyCount() == proxyCount;
+		for (int32 i = 0; valid && i < bodyCount; ++i)
+		{
+			for (b2Fixture* f = bodies[i]->m_fixtureList; valid && f; f = f->m_next)
+			{
+				for (int32 p = 0; p < f->m_proxyCount; ++p)
+				{
+					b2FixtureProxy* proxy = f->m_proxies + p;
+					if (broadPhase->IsProxy(proxy->proxyId) == false ||
+						broadPhase->GetUserData(proxy->proxyId) != nullptr)
+					{
+						valid = false;
+						break;
+					}
+
+					// Let the first step find the pairs.
+					broadPhase->SetUserData(proxy->proxyId, proxy);
+					broadPhase->TouchProxy(proxy->proxyId);
+				}
+			}
+		}
+	}
+
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(jointCount * sizeof(b2Joint*));
+	for (int32 i = 0; valid && i < jointCount; ++i)
+	{
+		b2JointType type = (b2JointType)jointChunk.Read<int32>();
+		int32 indexA = jointChunk.Read<int32>();
+		int32 indexB = jointChunk.Read<int32>();
+		bool collideConnected = jointChunk.Read<bool>();
+		if (jointChunk.IsValid() == false || indexA < 0 || indexA >= bodyCount || indexB < 0 || indexB >= bodyCount ||
+			indexA == indexB)
+		{
+			valid = false;
+			break;
+		}
+
+		b2Body* bodyA = bodies[indexA];
+		b2Body* bodyB = bodies[indexB];
+		b2Joint* joint = nullptr;
+
+		switch (type)
+		{
+		case e_distanceJoint:
+			{
+				b2DistanceJointDef def;
+				b2DistanceJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_frictionJoint:
+			{
+				b2FrictionJointDef def;
+				b2FrictionJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_gearJoint:
+			{
+				b2GearJointDef def;
+				b2GearJoint::ReadDefinition(&jointChunk, &def, joints, i);
+
+				// The gear moves the second bodies of its joints.
+				if (def.joint1 == nullptr || def.joint2 == nullptr ||
+					def.joint1->GetBodyB() != bodyA || def.joint2->GetBodyB() != bodyB)
+				{
+					valid = false;
+					break;
+				}
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_motorJoint:
+			{
+				b2MotorJointDef def;
+				b2MotorJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_mouseJoint:
+			{
+				b2MouseJointDef def;
+				b2MouseJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_prismaticJoint:
+			{
+				b2PrismaticJointDef def;
+				b2PrismaticJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_pulleyJoint:
+			{
+				b2PulleyJointDef def;
+				b2PulleyJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_revoluteJoint:
+			{
+				b2RevoluteJointDef def;
+				b2RevoluteJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_ropeJoint:
+			{
+				b2RopeJointDef def;
+				b2RopeJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_weldJoint:
+			{
+				b2WeldJointDef def;
+				b2WeldJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		case e_wheelJoint:
+			{
+				b2WheelJointDef def;
+				b2WheelJoint::ReadDefinition(&jointChunk, &def);
+				joint = b2LoadJoint(this, &def, bodyA, bodyB, collideConnected);
+			}
+			break;
+
+		default:
+			valid = false;
+			break;
+		}
+
+		joints[i] = joint;
+	}
+
+	valid = valid && jointChunk.IsValid();
+
+	if (valid)
+	{
+		m_gravity = gravity;
+		m_allowSleep = allowSleep;
+		m_warmStarting = warmStarting;
+		m_continuousPhysics = continuousPhysics;
+		m_subStepping = subStepping;
+		SetAutoClearForces(autoClearForces);
+
+		for (int32 i = 0; i < bodyCount; ++i)
+		{
+			b2Body* b = bodies[i];
+			if (activeFlags[i] == false)
+			{
+				continue;
+			}
+
+			if (hasTree == false)
+			{
+				b->SetActive(true);
+				continue;
+			}
+
+			// The proxies are already in the tree. Join the island graph as in b2Body::SetActive.
+			b->m_flags |= b2Body::e_activeFlag;
+			if (b->m_type == b2_staticBody)
+			{
+				for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+				{
+					m_islandGraph.LinkJoint(je->joint);
+				}
+			}
+			else
+			{
+				m_islandGraph.AddBody(b);
+			}
+		}
+	}
+	else
+	{
+		// Undo the load. Proxies read with the tree are dropped with the tree.
+		if (hasTree)
+		{
+			for (b2Body* b = m_bodyList; b; b = b->m_next)
+			{
+				for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+				{
+					f->m_proxyCount = 0;
+				}
+			}
+			broadPhase->ClearTree();
+		}
+
+		b2DestructionListener* listener = m_destructionListener;
+		m_destructionListener = nullptr;
+		while (m_bodyList)
+		{
+			DestroyBody(m_bodyList);
+		}
+		m_destructionListener = listener;
+	}
+
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(activeFlags);
+	m_stackAllocator.Free(bodies);
+
+	return valid;
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
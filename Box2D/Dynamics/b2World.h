@@ -23,16 +23,22 @@
 #include "Box2D/Common/b2BlockAllocator.h"
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Dynamics/b2ContactManager.h"
+#include "Box2D/Dynamics/b2EventBuffer.h"
+#include "Box2D/Dynamics/b2IslandGraph.h"
+#include "Box2D/Dynamics/b2TOIQueue.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/b2TimeStep.h"
 
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
+class b2BinaryWriter;
 class b2Body;
 class b2Draw;
 class b2Fixture;
+class b2Island;
 class b2Joint;
 
 /// The world class manages all physics entities, dynamic simulation,
@@ -43,7 +49,9 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator optional source of all world memory. It must outlive the world.
+	/// If null the world uses its own b2AllocatorInterface backed by b2Alloc.
+	b2World(const b2Vec2& gravity, b2AllocatorInterface* allocator = nullptr);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -58,7 +66,7 @@ public:
 	void SetContactFilter(b2ContactFilter* filter);
 
 	/// Register a contact event listener. The listener is owned by you and must
-	/// remain in scope.
+	/// remain in scope. There is none by default, see GetStepEvents.
 	void SetContactListener(b2ContactListener* listener);
 
 	/// Register a routine for debug drawing. The debug draw functions are called
@@ -66,11 +74,29 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register a task scheduler to run parallel parts of the step. Without a
+	/// scheduler the tasks run on the calling thread. The scheduler is owned
+	/// by you and must remain in scope.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create many bodies and their fixtures at once. This is the same as calling
+	/// CreateBody and b2Body::CreateFixture in a loop, but the mass of each body is
+	/// computed once and the broad-phase tree is built in one pass. Use this to load
+	/// levels or to spawn many bodies.
+	/// @param bodyDefs the body definitions
+	/// @param bodyCount the number of bodies
+	/// @param fixtureDefs the fixture definitions of all bodies, grouped by body
+	/// @param fixtureCounts the number of fixture definitions of each body
+	/// @param bodies receives the created bodies in order, may be null
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+					  const b2FixtureDef* fixtureDefs, const int32* fixtureCounts, b2Body** bodies);
+
 	/// Destroy a rigid body given a definition. No reference to the definition
 	/// is retained. This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -157,6 +183,50 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable parallel continuous physics. In this mode TOI events that
+	/// share no moving bodies are gathered in time order and their islands are
+	/// solved together through the task scheduler. Results differ slightly from the
+	/// serial mode, which solves one event at a time, so toggling this changes the
+	/// simulation. They never depend on the scheduler or thread count, so a single
+	/// threaded and a multithreaded run in this mode are bit identical. Ignored while
+	/// sub-stepping.
+	void SetParallelContinuous(bool flag) { m_parallelContinuous = flag; }
+	bool GetParallelContinuous() const { return m_parallelContinuous; }
+
+	/// Enable/disable speculative contacts, a cheaper alternative to continuous physics.
+	/// Contacts are created from AABBs that cover the motion of the next step and keep
+	/// points separated by up to the distance the bodies may close in a step. The solver
+	/// lets those points approach until they touch, so fast bodies stop at the surface in
+	/// the regular solve and TOI events are not computed. Contact begin events fire once
+	/// shapes are within that distance. Fast rotation is not predicted and restitution is
+	/// lost on speculative impacts.
+	void SetSpeculativeContacts(bool flag) { m_speculativeContacts = flag; }
+	bool GetSpeculativeContacts() const { return m_speculativeContacts; }
+
+	/// Enable/disable manifold reuse. A contact then keeps its manifold while the
+	/// relative transform of its bodies stays within b2_manifoldLinearTolerance and
+	/// b2_manifoldAngularTolerance of the transform the manifold was computed at. The
+	/// kept points are in body coordinates, so the solver still places them with the
+	/// current transforms. Resting piles then skip most of the narrow-phase. Results
+	/// differ slightly from the default mode.
+	void SetManifoldReuse(bool flag) { m_manifoldReuse = flag; }
+	bool GetManifoldReuse() const { return m_manifoldReuse; }
+
+	/// Enable/disable the state hash. When enabled, GetStateHash is updated after each
+	/// step. Enabling resets the hash. Hashing does not change the simulation: contacts,
+	/// islands and pairs are always processed in an order that depends only on the world
+	/// history, never on thread count or timing, so runs of the same build with the same
+	/// inputs are bit identical either way. Builds with different compilers or floating
+	/// point settings (e.g. FMA contraction) may still differ from each other.
+	void SetStateHashing(bool flag);
+	bool GetStateHashing() const { return m_stateHashing; }
+
+	/// Get the rolling hash of the body state. Each step mixes the transforms and
+	/// velocities of all bodies into the hash of the previous step, so two runs
+	/// differ from the first step that diverges. Only updated while state hashing
+	/// is enabled.
+	uint32 GetStateHash() const { return m_stateHash; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -179,6 +249,31 @@ public:
 	/// The minimum is 1.
 	float32 GetTreeQuality() const;
 
+	/// Set the capacity in bytes of the per step stack allocator. The default is b2_stackSize.
+	/// The stack grows when a step needs more and keeps the larger size, so use
+	/// b2Profile::stackHighWater and b2Profile::stackOverflows to size it up front.
+	/// @warning This function is locked during callbacks.
+	void SetStackCapacity(int32 capacity);
+
+	/// Get the capacity in bytes of the per step stack allocator.
+	int32 GetStackCapacity() const;
+
+	/// Get the allocator interface used by this world. Use it to read
+	/// memory statistics per subsystem.
+	b2AllocatorInterface* GetAllocator();
+	const b2AllocatorInterface* GetAllocator() const;
+
+	/// Set the limits of the adaptive fat AABB extension used by the dynamic tree.
+	/// Smaller limits produce fewer false pairs, larger limits fewer tree re-insertions.
+	/// The defaults are b2_minAABBExtension and b2_maxAABBExtension.
+	void SetAABBExtensionLimits(float32 minExtension, float32 maxExtension);
+
+	/// Reorder the dynamic tree nodes in memory to speed up later queries. The cost
+	/// is linear in the number of proxies, so call this during quiet frames, for
+	/// example after loading a level or every few hundred steps.
+	/// @warning This function is locked during callbacks.
+	void ReorderBroadPhase(b2TreeLayout layout);
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 	
@@ -205,10 +300,65 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Get the contact events gathered during the last time step. Reading these
+	/// arrays after Step replaces a virtual b2ContactListener call per event as
+	/// long as no listener is registered, which is the default.
+	/// Which events a contact reports is set by the b2ContactEventFlags of its
+	/// fixtures. The arrays stay valid until the next step.
+	b2StepEvents GetStepEvents() const;
+
+	/// Set the approach speed in meters per second above which contacts with
+	/// b2_hitEvents report a hit event. The default is 1.
+	/// A contact reports a hit in the step one of its points closes, that is the
+	/// point comes within b2_linearSlop or, with speculative contacts, is predicted
+	/// to close its gap during the step. It then reports no more hits until all of
+	/// its points open again, so a contact reports at most one hit per step and a
+	/// resting contact reports none.
+	void SetHitEventThreshold(float32 speed) { m_hitEventThreshold = speed; }
+	float32 GetHitEventThreshold() const { return m_hitEventThreshold; }
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
 
+	/// Write the world into a versioned, chunked binary image: settings, bodies,
+	/// fixtures, shapes including chain vertices, joints and the broad-phase tree.
+	/// User data and contacts are not written. Load recreates everything in the
+	/// original order. Chain vertices are stored in one aligned chunk so a loaded
+	/// world can reference them in place.
+	/// @param buffer the destination, may be null to query the size
+	/// @param capacity the size of the buffer in bytes
+	/// @return the number of bytes needed. Nothing useful is written if this exceeds capacity.
+	/// @warning this should be called outside of a time step.
+	int32 Save(void* buffer, int32 capacity);
+
+	/// Load an image written by Save into this world, which must be empty.
+	/// The stored broad-phase tree is used as is instead of inserting each proxy.
+	/// @param referenceVertices if true chain shapes reference their vertices in the
+	/// image instead of copying them, so the image (e.g. a memory mapped file) must
+	/// outlive the world.
+	/// @return false if the image is not valid. The world is left empty and unchanged then.
+	bool Load(const void* data, int32 size, bool referenceVertices = false);
+
+	/// Write the simulation state into a buffer: body motion, sleep timers,
+	/// the broad-phase tree, contacts with their warm starting impulses and
+	/// joint impulses. Shapes, definitions and user data are not written.
+	/// @param buffer the destination, may be null to query the size
+	/// @param capacity the size of the buffer in bytes
+	/// @return the number of bytes needed. Nothing useful is written if this exceeds capacity.
+	/// This is not const because it numbers the bodies and joints in place.
+	/// @warning this should be called outside of a time step.
+	int32 SaveState(void* buffer, int32 capacity);
+
+	/// Restore a state written by SaveState. The world must have the same bodies,
+	/// fixtures and joints created in the same order, so the next step matches
+	/// the step that followed the save. No contact callbacks are reported.
+	/// The whole buffer is checked against this world before anything is restored.
+	/// @return false if the buffer does not match this world. The world is not
+	/// modified in that case.
+	/// @warning this is locked during callbacks.
+	bool RestoreState(const void* buffer, int32 size);
+
 private:
 
 	// m_flags
@@ -221,21 +371,42 @@ private:
 
 	friend class b2Body;
 	friend class b2Fixture;
+	friend class b2Contact;
 	friend class b2ContactManager;
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SolveBatch(b2Island* island, b2PersistentIsland** batch, int32 count,
+					const b2TimeStep& step, b2PersistentIsland** splitIsland);
 	void SolveTOI(const b2TimeStep& step);
+	void QueueTOI(int32 contactIndex);
+	bool IsTOIIsolated(b2Body* bodyA, b2Body* bodyB) const;
+
+	void UpdateStateHash();
+
+	// A contact is identified in a state by the proxies of its fixtures and its
+	// child indices. Terrain segments share a proxy, so the proxy alone is not enough.
+	static void WriteContactKey(b2BinaryWriter* writer, const b2Contact* contact);
+
+	// Check that a state matches this world before restoring any of it.
+	bool CheckState(const void* buffer, int32 size);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
+	// The allocator interface must be constructed before the allocators using it.
+	b2AllocatorInterface m_defaultAllocator;
+	b2AllocatorInterface* m_allocator;
+
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
+	b2IslandGraph m_islandGraph;
+	b2TOIQueue m_toiQueue;
+	b2EventBuffer m_eventBuffer;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
@@ -248,6 +419,7 @@ private:
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
+	b2TaskScheduler* m_taskScheduler;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
@@ -257,9 +429,20 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_parallelContinuous;
+	bool m_speculativeContacts;
+	bool m_manifoldReuse;
+
+	// The look ahead time of speculative contacts, zero when disabled.
+	float32 m_speculativeTime;
+
+	float32 m_hitEventThreshold;
 
 	bool m_stepComplete;
 
+	bool m_stateHashing;
+	uint32 m_stateHash;
+
 	b2Profile m_profile;
 };
 
@@ -341,6 +524,21 @@ inline bool b2World::GetAutoClearForces() const
 	return (m_flags & e_clearForces) == e_clearForces;
 }
 
+inline int32 b2World::GetStackCapacity() const
+{
+	return m_stackAllocator.GetCapacity();
+}
+
+inline b2AllocatorInterface* b2World::GetAllocator()
+{
+	return m_allocator;
+}
+
+inline const b2AllocatorInterface* b2World::GetAllocator() const
+{
+	return m_allocator;
+}
+
 inline const b2ContactManager& b2World::GetContactManager() const
 {
 	return m_contactManager;
@@ -351,4 +549,11 @@ inline const b2Profile& b2World::GetProfile() const
 	return m_profile;
 }
 
+inline b2StepEvents b2World::GetStepEvents() const
+{
+	b2StepEvents events;
+	m_eventBuffer.GetEvents(&events);
+	return events;
+}
+
 #endif
@@ -19,9 +19,8 @@
 #ifndef B2_WORLD_CALLBACKS_H
 #define B2_WORLD_CALLBACKS_H
 
-#include "Box2D/Common/b2Settings.h"
+#include "Box2D/Common/b2Math.h"
 
-struct b2Vec2;
 struct b2Transform;
 class b2Fixture;
 class b2Body;
@@ -118,6 +117,53 @@ public:
 	}
 };
 
+/// Two solid fixtures began or ceased to touch.
+struct b2ContactTouchEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+};
+
+/// A sensor fixture began or ceased to overlap another fixture.
+struct b2SensorEvent
+{
+	b2Fixture* sensor;
+	b2Fixture* visitor;
+};
+
+/// Two solid fixtures hit each other faster than the world hit event threshold.
+struct b2ContactHitEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	b2Vec2 point;			///< the world point that approached the fastest
+	b2Vec2 normal;			///< the world normal, from A to B
+	float32 approachSpeed;	///< the speed of B towards A along the normal at the point
+};
+
+/// The contact events gathered during the last time step, in the order they
+/// occurred. See b2World::GetStepEvents
+/// Each fixture of an event was alive at the end of the step. The arrays
+/// are overwritten by the next step and are not updated when fixtures are
+/// destroyed, so read them before destroying anything.
+struct b2StepEvents
+{
+	const b2ContactTouchEvent* beginEvents;
+	int32 beginCount;
+
+	const b2ContactTouchEvent* endEvents;
+	int32 endCount;
+
+	const b2SensorEvent* sensorBeginEvents;
+	int32 sensorBeginCount;
+
+	const b2SensorEvent* sensorEndEvents;
+	int32 sensorEndCount;
+
+	const b2ContactHitEvent* hitEvents;
+	int32 hitCount;
+};
+
 /// Callback class for AABB queries.
 /// See b2World::Query
 class b2QueryCallback
@@ -152,4 +198,28 @@ public:
 									const b2Vec2& normal, float32 fraction) = 0;
 };
 
+/// A range of independent work items run by a b2TaskScheduler.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Execute the items in [begin, end). This may be called concurrently
+	/// for disjoint ranges.
+	virtual void Execute(int32 begin, int32 end) = 0;
+};
+
+/// Implement this class to run parallel parts of the step on your own threads.
+/// See b2World::SetTaskScheduler
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// Execute all items of the task and return when they are done. The items may
+	/// be split into ranges of at least minRange items and run on any threads. The
+	/// results do not depend on how the items are split.
+	virtual void ParallelFor(b2Task* task, int32 itemCount, int32 minRange) = 0;
+};
+
 #endif
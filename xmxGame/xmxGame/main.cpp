@@ -130,11 +130,20 @@ int main(int argc, const char *argv[])
         printf(" %d : %.2f %.2f\n", stepCount, ballPos.x, ballPos.y);
         
         // Reset balls velocity
-        b2ContactEdge* c = ball->GetContactList();
-        if (c != NULL) { // Collision
+        b2StepEvents events = world.GetStepEvents();
+        for (int32 i = 0; i < events.beginCount; i++) { // Collision
+            b2Fixture* other;
+            if (events.beginEvents[i].fixtureA->GetBody() == ball) {
+                other = events.beginEvents[i].fixtureB;
+            } else if (events.beginEvents[i].fixtureB->GetBody() == ball) {
+                other = events.beginEvents[i].fixtureA;
+            } else {
+                continue;
+            }
             printf("ContactAt: %d (%.2f, %.2f)\n", stepCount, ball->GetLinearVelocity().x, ball->GetLinearVelocity().y);
-            if (c->other->GetFixtureList()->GetRestitution() != 0.0f && ballPos.y > c->other->GetWorldCenter().y) {
+            if (other->GetRestitution() != 0.0f && ballPos.y > other->GetBody()->GetWorldCenter().y) {
                 ball->SetLinearVelocity(b2Vec2(ball->GetLinearVelocity().x/2, 4.0f));
+                break;
             }
         }
         